@@ -0,0 +1,1877 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include "../src/consoleapp.h"
+#include "bench_option_opt.h"
+
+/* usage: bench_option <prop_num> <token_num> [copy|view|threads|batch|rsp|static|gen|short|dispatch|repl|iter|checker|value|abbrev|command|complete|defaults|mixed|suite|linebuf|rwh|paste|keymap]
+ * prop_num個のオプションを登録したopt_property_db_tに対して,
+ * 各オプションを1回ずつ指定した後に -p のコンテンツを token_num 個まで並べたargvを
+ * groupingOpt(copy) または groupingOptView(view) にかける.
+ * threadsでは1つのopt_property_db_tを共有したTHREAD_NUM個のスレッドがそれぞれのopt_parser_tで
+ * THREAD_LOOP_NUM回ずつ解析し, 全ての結果が一致することを確かめる.
+ * batchでは同じargvをBATCH_ITEM_NUM個並べてgroupingOptBatchにかけ, ワーカの数を1からオンラインのCPUの数の2倍まで倍々にして
+ * スループットと1ワーカの場合に対する比を出す.
+ * rspではtoken_numをサイズ(MB)とみなして, 全てのオプションの後にソースファイルのパスを並べた応答ファイルを一時ファイルに書き出し,
+ * @fileとしてoptIterNextで1グループずつ取り出す. 取り出す間のヒープの使用量の最大値がRSP_HEAP_KB_MAXを超えないこと,
+ * つまりファイルの大きさによらないことを確かめ, 最大RSS(マップしたページを含む)と共に出す.
+ * staticでは引数を無視し, BENCH_OPTSの16個のオプションについてgenOptPropDBとregOptPropで登録する場合と
+ * OPT_PROP_DB_DEFINEで定義した場合の起動時の登録にかかる時間とメモリ確保の回数を比べる.
+ * genではprop_numを無視し, optgenがbench_option.optから生成したマッチャと, 同じテーブルをハッシュの索引で引く場合とで
+ * 全てのオプションを1回ずつ指定したargvと, その後に -p のコンテンツをtoken_num個並べたargvの解析時間を比べる.
+ * shortでは引数を無視し, bench_option.optの1文字の短縮形式を持つオプションを -cgv... -ofile のように束ねたargvと,
+ * -c -g -v ... -o file のように分けたargvの解析時間をオプション1つあたりで比べる.
+ * dispatchでは引数を無視し, bench_option.optの全てのオプションを指定した解析結果について, 各グループがどのオプションかを
+ * strcmpの連鎖で調べる場合と, prop_idとgetOptGroupで引く場合の時間をグループ1つあたりで比べる.
+ * replではprop_numを無視し, REPLで打ち込まれるような短い行をtoken_num行, bench_option.optの1つのopt_property_db_tで解析する.
+ * 1つのopt_parser_tを使い回す場合, 行毎にgroupingOptを呼ぶ場合, 行毎にopt_property_db_tを作り直す場合の1行あたりの時間と確保の回数を比べる.
+ * iterではprop_numを無視し, -o out の後に -p のコンテンツをtoken_num個並べたargvについて, groupingOptViewで全体を解析する場合と,
+ * optIterNextで先頭のグループだけを取り出す場合と, optIterNextで全てのグループを取り出す場合の時間と確保の回数を比べる.
+ * checkerでは引数を無視し, 1回あたりCHECKER_SLEEP_USだけブロックするcontents_checkerを持つCHECKER_OPT_NUM個のオプションについて,
+ * 順に呼ぶ場合とsetOptCheckerThreadsで並列に呼ぶ場合の1回の解析時間と, 同じargvをCHECKER_BATCH_NUM個並べたgroupingOptBatchで
+ * setOptCheckerMemoの有無によるcontents_checkerの呼び出し回数と時間を比べる.
+ * valueではprop_numを無視し, -n の後に整数をtoken_num個, -d の後に小数をtoken_num個並べたargvについて,
+ * コンテンツを文字列のまま受け取ってstrtollとstrtodで変換する場合と, regOptPropTypedで型を宣言して解析中に変換する場合の
+ * コンテンツ1つあたりの時間を比べる.
+ * abbrevではtoken_numを無視し, --opt00001-name のような詳細形式を持つprop_num個のオプションを --opt00001 のように省略して全て並べたargvを
+ * setOptAbbrevで解析する場合の時間と, 各トークンについて全てのlong_formをstrncmpで調べて接頭辞を探す場合の時間をオプション1つあたりで比べる.
+ * commandでは引数を無視し, BENCH_OPTSのオプションを持つ32個のサブコマンドの1つを選ぶ -a cmd17 -b -c x -p y のようなargvについて,
+ * 起動時に全てのサブコマンドをgenOptPropDBとregOptPropで登録してからargvを切り分けて解析する場合と, groupingOptCommandで
+ * 静的なopt_command_tを初めて解析する場合の時間と確保の回数と索引を構築したopt_property_db_tの数を比べる.
+ * また2回目以降の解析について, groupingOptCommandの場合と, サブコマンドの位置を探して切り分けたargvを2回groupingOptにかける場合の時間を比べる.
+ * completeではtoken_numを無視し, --opt00001-name のような詳細形式とenum_namesを持つprop_num個のオプションについて,
+ * シェルの補完で呼ばれるcompleteOptの時間を測る. 名前の索引を構築する最初の1回と, 2回目以降の --opt0 (多数の候補),
+ * --opt0012 (少数の候補), 8個のオプションの後のenum_namesの補完の1回あたりの時間を出す.
+ * defaultsではcopyと同じargvの内容を設定ファイルに書き出し, 全てをargvで渡す場合と, setOptDefaultSourcesで設定ファイルと環境変数から
+ * 読む場合の1回の解析時間と確保の回数を比べる. 既定値は起動毎にopt_parser_tを作り直してファイルをマップする場合と,
+ * opt_parser_tを使い回してキャッシュした設定ファイルを使う場合に分ける.
+ * mixedではprop_num個のオプションを持つスキーマと, 短縮形式, 詳細形式, --long=a,b,c, 対応するオプションが無いコンテンツを混ぜた
+ * token_num個程度のトークンのargvを固定の種の擬似乱数で作り, genOptPropDBとregOptPropでの登録, groupingOpt, freeOptGroupDBの時間と
+ * トークン1つあたりの時間と確保の回数, 最大RSSを出す.
+ * suiteでは引数を無視し, prop_numが10から10000, token_numが10から1000000の各構成についてmixedを子プロセスで実行する.
+ * 出力はどのコミットでも同じ順と同じキーで並ぶので, 2つのコミットの出力を行毎に比べられる.
+ * linebufではprop_numを無視し, rwhの行を保持するlinebuf_tについてtoken_numバイトの行を1文字ずつ末尾に打ち込む場合と,
+ * その行の中央でLINEBUF_KEY_NUM回の挿入, バックスペース, 1文字ずつのカーソル移動をする場合の1キーあたりの時間を出す.
+ * 比較のため, キー毎に行全体を複製していた以前のstrninsertと同じ方法で中央に挿入する場合の時間も出す.
+ * rwhではprop_numを1行の文字の数とし, ptyのマスタから少しずつ書き込んだtoken_num行のキー入力を子プロセスのrwhで読む.
+ * rwhを呼ぶ毎に生モードに入る場合, beginRawSessionで全体を1つのセッションにする場合, 以前のgetchと同じく1バイト毎に
+ * 端末の設定を変えて読むだけの場合について, 入力1バイトあたりのread, tcgetattr, tcsetattr, isattyの呼び出し回数と時間を比べる.
+ * また1つのセッションで読んだ場合に端末へ書き出したバイト数とwriteの回数をキー1つあたりで出す.
+ * pasteではprop_numを無視し, 改行とタブを含むtoken_num MBのテキストをbracketed pasteの印で囲んでptyから1行としてrwhに渡す場合と,
+ * 印を付けずに改行とタブを空白にした先頭のPASTE_TYPED_LENバイトを打ち込む場合の時間と, 端末へ書き出したバイト数とwriteの回数を比べる.
+ * keymapではbindRwhKeyでESC [ で始まる使われない束縛をprop_num個加えたrwhctx_tで, 文字と矢印キーなどを混ぜたtoken_num行を
+ * 一時ファイルからrwhで読み, キー1つあたりの時間とメモリ確保の回数を出す. 束縛の数によらないことを確かめる. */
+
+#define THREAD_NUM      4
+#define THREAD_LOOP_NUM 50
+#define BATCH_ITEM_NUM  2000
+#define GEN_TOKEN_NUM   10000000 /* genで解析するトークンの延べ数 */
+#define DISPATCH_LOOP_NUM 20000
+#define REPL_REBUILD_NUM  10000 /* replでopt_property_db_tを作り直す場合の行数. 遅いので減らす */
+#define ITER_FIRST_LOOP_NUM 10000
+#define CHECKER_OPT_NUM     8
+#define CHECKER_SLEEP_US    500 /* stat等のI/Oでブロックする時間の代わり */
+#define CHECKER_THREAD_NUM  4
+#define CHECKER_BATCH_NUM   100
+#define VALUE_LOOP_NUM      10
+#define ABBREV_LOOP_NUM     100
+#define COMMAND_LOOP_NUM    100000
+#define COMPLETE_LOOP_NUM   100000
+#define COMPLETE_CAND_MAX   64 /* 端末に一度に並べる候補の数 */
+#define DEFAULTS_LOOP_NUM   1000
+#define MIXED_MIN_TOKEN_NUM 1000000 /* mixedで1つの構成について解析するトークンの延べ数の下限 */
+#define LINEBUF_KEY_NUM     1000
+#define PASTE_TYPED_LEN     (1024 * 1024) /* pasteで貼り付けの印を付けずに打ち込む長さ. 遅いので減らす */
+#define RSP_HEAP_SAMPLE     1024 /* rspでヒープの使用量を調べるグループの間隔 */
+#define RSP_HEAP_KB_MAX     1024 /* rspで取り出す間に増えてよいヒープの使用量 */
+
+/* Makefileで -Wl,--wrap を指定してメモリ確保関数の呼び出し回数を数える */
+static _Atomic long alloc_num = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__real_reallocarray(void *ptr, size_t nmemb, size_t size);
+
+void *__wrap_malloc(size_t size){
+    alloc_num++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size){
+    alloc_num++;
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size){
+    alloc_num++;
+    return __real_realloc(ptr, size);
+}
+
+void *__wrap_reallocarray(void *ptr, size_t nmemb, size_t size){
+    alloc_num++;
+    return __real_reallocarray(ptr, nmemb, size);
+}
+
+/* 同じくrwhで端末の入力に関わるシステムコールの回数を数える */
+static long input_syscall_num = 0;
+
+ssize_t __real_read(int fd, void *buf, size_t count);
+int     __real_tcgetattr(int fd, struct termios *termios_p);
+int     __real_tcsetattr(int fd, int optional_actions, const struct termios *termios_p);
+int     __real_isatty(int fd);
+ssize_t __real_write(int fd, const void *buf, size_t count);
+
+ssize_t __wrap_read(int fd, void *buf, size_t count){
+    input_syscall_num++;
+    return __real_read(fd, buf, count);
+}
+
+int __wrap_tcgetattr(int fd, struct termios *termios_p){
+    input_syscall_num++;
+    return __real_tcgetattr(fd, termios_p);
+}
+
+int __wrap_tcsetattr(int fd, int optional_actions, const struct termios *termios_p){
+    input_syscall_num++;
+    return __real_tcsetattr(fd, optional_actions, termios_p);
+}
+
+int __wrap_isatty(int fd){
+    input_syscall_num++;
+    return __real_isatty(fd);
+}
+
+/* 端末への出力はwriteの回数を数える. 書いたバイト数は出力先のファイルの大きさで測る */
+static long output_write_num = 0;
+
+ssize_t __wrap_write(int fd, const void *buf, size_t count){
+    output_write_num += fd == STDOUT_FILENO;
+    return __real_write(fd, buf, count);
+}
+
+#define BENCH_OPTS(X) \
+    X("-a", "--alpha",   0, 0, NULL) X("-b", "--bravo",   0, 0, NULL) X("-c", "--charlie", 1, 1, NULL) X("-d", "--delta",   1, 1, NULL) \
+    X("-e", "--echo",    0, 0, NULL) X("-f", "--foxtrot", 0, 0, NULL) X("-g", "--golf",    1, 1, NULL) X("-H", "--hotel",   1, 1, NULL) \
+    X("-i", "--india",   0, 0, NULL) X("-j", "--juliet",  0, 0, NULL) X("-k", "--kilo",    1, 1, NULL) X("-l", "--lima",    1, 1, NULL) \
+    X("-m", "--mike",    0, 0, NULL) X("-n", "--november",0, 0, NULL) X("-O", "--oscar",   1, 1, NULL) X("-p", "--print",   1, INT_MAX, NULL)
+
+OPT_PROP_DB_DEFINE(bench_static_db, BENCH_OPTS);
+
+/* commandで用いるCOMMAND_SUB_NUM個のサブコマンド. どれもBENCH_OPTSのオプションを持つ */
+#define BENCH_CMDS(X) \
+    X(00) X(01) X(02) X(03) X(04) X(05) X(06) X(07) X(08) X(09) X(10) X(11) X(12) X(13) X(14) X(15) \
+    X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23) X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31)
+#define BENCH_CMD_DB(n)  OPT_PROP_DB_DEFINE(bench_cmd##n##_db, BENCH_OPTS);
+#define BENCH_CMD_SUB(n) {"cmd" #n, &bench_cmd##n##_db, 0, NULL},
+BENCH_CMDS(BENCH_CMD_DB)
+OPT_PROP_DB_DEFINE(bench_root_db, BENCH_OPTS);
+static const opt_command_t bench_cmd_subs[] = {BENCH_CMDS(BENCH_CMD_SUB)};
+static const opt_command_t bench_cmd_root   = {NULL, &bench_root_db, sizeof(bench_cmd_subs) / sizeof(bench_cmd_subs[0]), bench_cmd_subs};
+
+static double nowNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+typedef struct _bench_thread_arg_t{
+    const opt_property_db_t *db;
+    int                      argc;
+    char                   **argv;
+    int                      prop_num;
+    int                      failed_num; /* 結果が期待と異なった解析の数 */
+}bench_thread_arg_t;
+
+static void *benchThread(void *arg){
+    bench_thread_arg_t *bta = (bench_thread_arg_t *)arg;
+    opt_parser_t        parser;
+    opt_group_db_t     *opt_grp_db;
+
+    if(initOptParser(&parser, bta->db) != OPTION_SUCCESS){
+        bta->failed_num = THREAD_LOOP_NUM;
+        return NULL;
+    }
+    for(int i=0; i<THREAD_LOOP_NUM; i++){
+        if(groupingOptWithParser(&parser, bta->argc, bta->argv, &opt_grp_db) != OPTION_SUCCESS){
+            bta->failed_num++;
+            continue;
+        }
+        opt_group_t *print_grp = &opt_grp_db->grps[opt_grp_db->grp_num-1];
+        if(opt_grp_db->grp_num != bta->prop_num || strcmp(print_grp->option, "-p") != 0 ||
+                print_grp->content_num != bta->argc-1-bta->prop_num ||
+                strcmp(print_grp->contents[print_grp->content_num-1], bta->argv[bta->argc-1]) != 0){
+            bta->failed_num++;
+        }
+        freeOptGroupDB(opt_grp_db);
+    }
+    freeOptParser(&parser);
+    return NULL;
+}
+
+static int benchThreads(const opt_property_db_t *opt_prop_db, int prop_num, int token_num, char **bench_argv){
+    pthread_t          threads[THREAD_NUM];
+    bench_thread_arg_t args[THREAD_NUM];
+    int                failed_num = 0;
+
+    double begin = nowNs();
+    for(int i=0; i<THREAD_NUM; i++){
+        args[i] = (bench_thread_arg_t){opt_prop_db, token_num+1, bench_argv, prop_num, 0};
+        pthread_create(&threads[i], NULL, benchThread, &args[i]);
+    }
+    for(int i=0; i<THREAD_NUM; i++){
+        pthread_join(threads[i], NULL);
+        failed_num += args[i].failed_num;
+    }
+    double end = nowNs();
+
+    printf("mode=threads\tprop_num=%d\ttoken_num=%d\tthread_num=%d\tparse_num=%d\tfailed=%d\tns_per_token=%.1f\n",
+            prop_num, token_num, THREAD_NUM, THREAD_NUM*THREAD_LOOP_NUM, failed_num,
+            (end - begin) / ((double)token_num*THREAD_NUM*THREAD_LOOP_NUM));
+    return failed_num == 0 ? 0 : 1;
+}
+
+static int benchBatch(const opt_property_db_t *opt_prop_db, int prop_num, int token_num, char **bench_argv){
+    opt_argv_t *items   = (opt_argv_t *)malloc(sizeof(opt_argv_t)*BATCH_ITEM_NUM);
+    long        cpu_num = sysconf(_SC_NPROCESSORS_ONLN);
+    double      base_ns = 0;
+
+    for(int i=0; i<BATCH_ITEM_NUM; i++){
+        items[i] = (opt_argv_t){token_num+1, bench_argv};
+    }
+
+    for(int worker_num=1; worker_num<=2*(cpu_num > 0 ? cpu_num : 1); worker_num*=2){
+        opt_group_batch_t *batch;
+        int                failed_num = 0;
+
+        double begin = nowNs();
+        int    ret   = groupingOptBatch(opt_prop_db, BATCH_ITEM_NUM, items, worker_num, &batch);
+        double end   = nowNs();
+        if(ret != OPTION_SUCCESS){
+            fprintf(stderr, "error: groupingOptBatch returns %d\n", ret);
+            free(items);
+            return 1;
+        }
+        for(int i=0; i<BATCH_ITEM_NUM; i++){
+            if(batch->err_codes[i] != OPTION_SUCCESS || batch->grp_dbs[i]->grp_num != prop_num){
+                failed_num++;
+            }
+        }
+        freeOptGroupBatch(batch);
+
+        if(worker_num == 1){
+            base_ns = end - begin;
+        }
+        printf("mode=batch\tprop_num=%d\ttoken_num=%d\titem_num=%d\tworker_num=%d\tcpu_num=%ld\tfailed=%d\titems_per_sec=%.0f\tspeedup=%.2f\n",
+                prop_num, token_num, BATCH_ITEM_NUM, worker_num, cpu_num, failed_num,
+                BATCH_ITEM_NUM / ((end - begin) / 1e9), base_ns / (end - begin));
+        if(failed_num != 0){
+            free(items);
+            return 1;
+        }
+    }
+
+    free(items);
+    return 0;
+}
+
+static size_t benchHeapBytes(void){
+    struct mallinfo2 heap = mallinfo2();
+    return heap.uordblks + heap.hblkhd;
+}
+
+static int benchRsp(const opt_property_db_t *opt_prop_db, int prop_num, int mb){
+    char  path[] = "/tmp/bench_option_XXXXXX";
+    int   fd     = mkstemp(path);
+    FILE *fp     = fd == -1 ? NULL : fdopen(fd, "w");
+    if(!fp){
+        fprintf(stderr, "error: cannot create a response file\n");
+        return 1;
+    }
+
+    /* ビルドのラッパーが渡すようにフラグの後に長いパスを並べ, 8個に1個は引用符で囲んで空白を含める.
+     * パスは対応するオプションが無いコンテンツなので1つずつのグループになる */
+    long file_bytes = 0;
+    for(int i=1; i<prop_num; i++){
+        file_bytes += fprintf(fp, i % 2 ? "-o%d\n" : "--option-%d\n", i);
+    }
+    for(long i=0; file_bytes < (long)mb*1024*1024; i++){
+        file_bytes += fprintf(fp, i % 8 ? "src/component%04ld/source_file_%07ld.c\n" : "'src/component %04ld/source file %07ld.c'\n", i % 1000, i);
+    }
+    fclose(fp);
+
+    char             rsp_arg[sizeof(path)+1];
+    char            *rsp_argv[] = {"bench_option", rsp_arg};
+    opt_iter_t       it;
+    opt_view_group_t grp;
+    struct rusage    usage;
+    int              ret;
+    int              token_num  = 0;
+    int              grp_num    = 0;
+
+    sprintf(rsp_arg, "@%s", path);
+    initOptIter(&it, opt_prop_db, 2, rsp_argv);
+    setOptRspFileDepth(&it.parser, 1);
+
+    size_t heap_begin  = benchHeapBytes();
+    size_t heap_peak   = heap_begin;
+    long   alloc_begin = alloc_num;
+    double begin       = nowNs();
+    while((ret = optIterNext(&it, &grp)) == OPTION_SUCCESS){
+        token_num += (grp.prop_id != -1) + grp.content_num;
+        if(++grp_num % RSP_HEAP_SAMPLE == 0){
+            size_t heap = benchHeapBytes();
+            heap_peak   = heap > heap_peak ? heap : heap_peak;
+        }
+    }
+    double end       = nowNs();
+    long   alloc_end = alloc_num;
+    getrusage(RUSAGE_SELF, &usage);
+    freeOptIter(&it);
+    unlink(path);
+
+    size_t peak_kb = (heap_peak - heap_begin) / 1024;
+    if(ret != OPTION_ITER_END){
+        fprintf(stderr, "error: optIterNext returns %d\n", ret);
+        return 1;
+    }
+    if(peak_kb > RSP_HEAP_KB_MAX){
+        fprintf(stderr, "error: the heap grew by %zu KB while iterating over the response file\n", peak_kb);
+        return 1;
+    }
+    printf("mode=rsp\tprop_num=%d\tfile_bytes=%ld\ttoken_num=%d\titer_ns=%.0f\tns_per_byte=%.2f\tns_per_token=%.1f\tallocs=%ld\tpeak_heap_kb=%zu\tmax_rss_kb=%ld\n",
+            prop_num, file_bytes, token_num, end - begin, (end - begin) / file_bytes, (end - begin) / token_num,
+            alloc_end - alloc_begin, peak_kb, usage.ru_maxrss);
+    return 0;
+}
+
+static int benchDefaultsGrouping(opt_parser_t *parser, int argc, char **argv, int *grp_num){
+    opt_group_db_t *opt_grp_db;
+    int             ret = groupingOptWithParser(parser, argc, argv, &opt_grp_db);
+    if(ret == OPTION_SUCCESS){
+        *grp_num = opt_grp_db->grp_num;
+        freeOptGroupDB(opt_grp_db);
+    }
+    return ret;
+}
+
+static int benchDefaults(const opt_property_db_t *opt_prop_db, int prop_num, int token_num, char **bench_argv){
+    char  path[] = "/tmp/bench_option_XXXXXX";
+    int   fd     = mkstemp(path);
+    FILE *fp     = fd == -1 ? NULL : fdopen(fd, "w");
+    if(!fp){
+        fprintf(stderr, "error: cannot create a config file\n");
+        return 1;
+    }
+
+    /* ラッパースクリプトが毎回argvに並べていたものを設定ファイルに移し, フラグの1つは環境変数で打ち消す */
+    fprintf(fp, "# bench_option defaults\n");
+    for(int i=1; i<prop_num; i++){
+        fprintf(fp, i % 2 ? "option-%d\n" : "--option-%d = true\n", i);
+    }
+    fprintf(fp, "print");
+    for(int i=prop_num+1; i<=token_num; i++){
+        fprintf(fp, " %s", bench_argv[i]);
+    }
+    fprintf(fp, "\n");
+    fclose(fp);
+    setenv("BENCH_OPTION_OPTION_1", "false", 1);
+
+    char        *empty_argv[] = {"bench_option"};
+    opt_parser_t parser;
+    int          argv_grp_num   = 0;
+    int          cold_grp_num   = 0;
+    int          cached_grp_num = 0;
+    int          failed_num     = 0;
+
+    initOptParser(&parser, opt_prop_db);
+    double argv_begin = nowNs();
+    for(int l=0; l<DEFAULTS_LOOP_NUM; l++){
+        failed_num += benchDefaultsGrouping(&parser, token_num+1, bench_argv, &argv_grp_num) != OPTION_SUCCESS;
+    }
+    double argv_end = nowNs();
+    freeOptParser(&parser);
+
+    /* プロセスを起動する度に設定ファイルをマップしてトークンに分ける場合 */
+    long   cold_alloc_begin = alloc_num;
+    double cold_begin       = nowNs();
+    for(int l=0; l<DEFAULTS_LOOP_NUM; l++){
+        initOptParser(&parser, opt_prop_db);
+        setOptDefaultSources(&parser, path, "BENCH_OPTION_");
+        failed_num += benchDefaultsGrouping(&parser, 1, empty_argv, &cold_grp_num) != OPTION_SUCCESS;
+        freeOptParser(&parser);
+    }
+    double cold_end       = nowNs();
+    long   cold_alloc_end = alloc_num;
+
+    /* 常駐するプロセスがopt_parser_tを使い回す場合. 2回目以降はfstatでファイルが変わっていないことを確かめるだけになる */
+    initOptParser(&parser, opt_prop_db);
+    setOptDefaultSources(&parser, path, "BENCH_OPTION_");
+    failed_num += benchDefaultsGrouping(&parser, 1, empty_argv, &cached_grp_num) != OPTION_SUCCESS;
+    long   cached_alloc_begin = alloc_num;
+    double cached_begin       = nowNs();
+    for(int l=0; l<DEFAULTS_LOOP_NUM; l++){
+        failed_num += benchDefaultsGrouping(&parser, 1, empty_argv, &cached_grp_num) != OPTION_SUCCESS;
+    }
+    double cached_end       = nowNs();
+    long   cached_alloc_end = alloc_num;
+    freeOptParser(&parser);
+    unsetenv("BENCH_OPTION_OPTION_1");
+
+    /* 同じ層で偽を指定した後にもう一度指定するのは, 偽の指定が結果に現れなくても重複になる */
+    int dup_ret = OPTION_SUCCESS;
+    int dup_grp_num;
+    if((fp = fopen(path, "w"))){
+        fprintf(fp, "option-1 = false\noption-1 = true\n");
+        fclose(fp);
+        initOptParser(&parser, opt_prop_db);
+        setOptDefaultSources(&parser, path, "BENCH_OPTION_");
+        dup_ret = benchDefaultsGrouping(&parser, 1, empty_argv, &dup_grp_num);
+        freeOptParser(&parser);
+    }
+    unlink(path);
+
+    /* argvでは全てのオプションが出現し, 既定値では環境変数で打ち消した --option-1 の分だけグループが少ない */
+    if(failed_num > 0 || cold_grp_num != argv_grp_num - 1 || cached_grp_num != cold_grp_num){
+        fprintf(stderr, "error: %d groupings failed or the merged groups differ (argv %d, cold %d, cached %d)\n",
+                failed_num, argv_grp_num, cold_grp_num, cached_grp_num);
+        return 1;
+    }
+    if(dup_ret != OPTION_DUPLICATE_SAME_OPT){
+        fprintf(stderr, "error: a config file repeating a false option returns %d\n", dup_ret);
+        return 1;
+    }
+    printf("mode=defaults\tprop_num=%d\ttoken_num=%d\targv_ns=%.0f\tcold_ns=%.0f\tcold_allocs=%.1f\tcached_ns=%.0f\tcached_allocs=%.1f\n",
+            prop_num, token_num, (argv_end - argv_begin) / DEFAULTS_LOOP_NUM,
+            (cold_end - cold_begin) / DEFAULTS_LOOP_NUM, (double)(cold_alloc_end - cold_alloc_begin) / DEFAULTS_LOOP_NUM,
+            (cached_end - cached_begin) / DEFAULTS_LOOP_NUM, (double)(cached_alloc_end - cached_alloc_begin) / DEFAULTS_LOOP_NUM);
+    return 0;
+}
+
+static int benchStatic(void){
+    char           *small_argv[] = {"bench_option", "-a", "--charlie", "x", "-p", "y"};
+    int             small_argc   = sizeof(small_argv) / sizeof(small_argv[0]);
+    opt_group_db_t *opt_grp_db;
+
+    /* genOptPropDBとregOptPropで登録してから1回解析する */
+    long   dyn_alloc_begin = alloc_num;
+    double dyn_begin       = nowNs();
+    opt_property_db_t *dyn_db = genOptPropDB(16);
+#define BENCH_REG(short_form, long_form, min, max, checker) regOptProp(dyn_db, short_form, long_form, min, max, checker);
+    BENCH_OPTS(BENCH_REG)
+#undef BENCH_REG
+    double dyn_reg_end       = nowNs();
+    long   dyn_reg_alloc_end = alloc_num;
+    int    dyn_ret           = groupingOpt(dyn_db, small_argc, small_argv, &opt_grp_db);
+    double dyn_end           = nowNs();
+    long   dyn_alloc_end     = alloc_num;
+    freeOptGroupDB(opt_grp_db);
+
+    /* 静的なテーブルをそのまま解析する. 索引は最初の解析で構築される */
+    long   static_alloc_begin = alloc_num;
+    double static_begin       = nowNs();
+    int    static_ret         = groupingOpt(&bench_static_db, small_argc, small_argv, &opt_grp_db);
+    double static_end         = nowNs();
+    long   static_alloc_end   = alloc_num;
+    freeOptGroupDB(opt_grp_db);
+
+    if(dyn_ret != OPTION_SUCCESS || static_ret != OPTION_SUCCESS){
+        fprintf(stderr, "error: groupingOpt returns %d, %d\n", dyn_ret, static_ret);
+        return 1;
+    }
+    printf("mode=static\tprop_num=16\tdyn_reg_ns=%.0f\tdyn_reg_allocs=%ld\tdyn_parse_ns=%.0f\tdyn_parse_allocs=%ld\tstatic_reg_ns=0\tstatic_reg_allocs=0\tstatic_parse_ns=%.0f\tstatic_parse_allocs=%ld\n",
+            dyn_reg_end - dyn_begin, dyn_reg_alloc_end - dyn_alloc_begin, dyn_end - dyn_reg_end, dyn_alloc_end - dyn_reg_alloc_end,
+            static_end - static_begin, static_alloc_end - static_alloc_begin);
+    freeOptPropDB(dyn_db);
+    return 0;
+}
+
+static double benchGenParse(opt_parser_t *parser, int argc, char **argv, int loop_num, int *ret){
+    opt_view_group_db_t *opt_grp_db;
+
+    double begin = nowNs();
+    for(int i=0; i<loop_num; i++){
+        if((*ret = groupingOptViewWithParser(parser, argc, argv, &opt_grp_db)) != OPTION_SUCCESS){
+            return 0;
+        }
+        freeOptViewGroupDB(opt_grp_db);
+    }
+    return (nowNs() - begin) / ((double)(argc-1)*loop_num);
+}
+
+static int benchGen(int token_num){
+    const opt_property_db_t *gen_db  = &bench_option_opt_prop_db;
+    opt_property_db_t        hash_db = bench_option_opt_prop_db; /* 同じテーブルと索引をマッチャ無しで引く */
+    int                      prop_num = gen_db->prop_num;
+    char                   **gen_argv = (char **)malloc(sizeof(char *) * (1 + prop_num*2 + token_num));
+    char                    *contents = (char *)malloc(32 * (size_t)(prop_num + token_num));
+    int                      gen_argc = 1;
+    int                      opts_argc;
+
+    hash_db.matcher = NULL;
+    gen_argv[0] = "bench_option";
+    /* -pは最後に置き, それ以外は短い形式と長い形式を交互に使う */
+    for(int i=1; i<=prop_num; i++){
+        const opt_property_t *prop = &gen_db->props[i % prop_num];
+        gen_argv[gen_argc++] = (char *)(i % 2 == 0 || !prop->long_form ? prop->short_form : prop->long_form);
+        if(i < prop_num && prop->content_num_min > 0){
+            gen_argv[gen_argc] = contents + 32*i;
+            sprintf(gen_argv[gen_argc++], "value%d", i);
+        }
+    }
+    opts_argc = gen_argc;
+    for(int i=0; i<token_num; i++){
+        gen_argv[gen_argc] = contents + 32*(size_t)(prop_num + i);
+        sprintf(gen_argv[gen_argc++], "src/file%d.c", i);
+    }
+    /* オプションだけのargvは -p にコンテンツを1つ付ける */
+    gen_argv[opts_argc] = "src/main.c";
+
+    opt_parser_t gen_parser;
+    opt_parser_t hash_parser;
+    int          ret[4]  = {OPTION_SUCCESS, OPTION_SUCCESS, OPTION_SUCCESS, OPTION_SUCCESS};
+    int          opts_loop_num = GEN_TOKEN_NUM / opts_argc;
+    int          full_loop_num = GEN_TOKEN_NUM / (gen_argc-1) + 1;
+    initOptParser(&gen_parser, gen_db);
+    initOptParser(&hash_parser, &hash_db);
+    double gen_opts_ns  = benchGenParse(&gen_parser,  opts_argc+1, gen_argv, opts_loop_num, &ret[0]);
+    double hash_opts_ns = benchGenParse(&hash_parser, opts_argc+1, gen_argv, opts_loop_num, &ret[1]);
+    double gen_full_ns  = benchGenParse(&gen_parser,  gen_argc,    gen_argv, full_loop_num, &ret[2]);
+    double hash_full_ns = benchGenParse(&hash_parser, gen_argc,    gen_argv, full_loop_num, &ret[3]);
+    freeOptParser(&gen_parser);
+    freeOptParser(&hash_parser);
+    free(gen_argv);
+    free(contents);
+
+    for(int i=0; i<4; i++){
+        if(ret[i] != OPTION_SUCCESS){
+            fprintf(stderr, "error: groupingOptViewWithParser returns %d\n", ret[i]);
+            return 1;
+        }
+    }
+    printf("mode=gen\tprop_num=%d\ttoken_num=%d\topts_gen_ns_per_token=%.1f\topts_hash_ns_per_token=%.1f\tgen_ns_per_token=%.1f\thash_ns_per_token=%.1f\n",
+            prop_num, token_num, gen_opts_ns, hash_opts_ns, gen_full_ns, hash_full_ns);
+    return 0;
+}
+
+static int benchShort(void){
+    const opt_property_db_t *db = &bench_option_opt_prop_db;
+    char                     bundle[258] = "-";
+    char                     singles[256][3];
+    char                    *bundle_argv[2];
+    char                    *single_argv[1 + 256 + 1];
+    int                      single_argc = 1;
+    int                      opt_num     = 0;
+    char                    *value       = NULL;
+
+    /* コンテンツを取らないオプションを1つの引数に束ね, 最後にコンテンツを1つ取るオプションを値を付けて置く */
+    for(int c=1; c<256; c++){
+        int prop_i = db->short_idx[c] - 1;
+        if(prop_i == -1 || c == '-' || db->props[prop_i].content_num_min > 0){
+            continue;
+        }
+        bundle[1 + opt_num] = c;
+        sprintf(singles[opt_num], "-%c", c);
+        single_argv[single_argc++] = singles[opt_num++];
+    }
+    for(int c=1; c<256 && !value; c++){
+        int prop_i = db->short_idx[c] - 1;
+        if(prop_i != -1 && c != '-' && db->props[prop_i].content_num_max == 1){
+            bundle[1 + opt_num] = c;
+            strcpy(&bundle[2 + opt_num], "file");
+            sprintf(singles[opt_num], "-%c", c);
+            single_argv[single_argc++] = singles[opt_num++];
+            single_argv[single_argc++] = value = "file";
+        }
+    }
+    bundle_argv[0] = single_argv[0] = "bench_option";
+    bundle_argv[1] = bundle;
+
+    opt_parser_t parser;
+    int          ret[2]   = {OPTION_SUCCESS, OPTION_SUCCESS};
+    int          loop_num = GEN_TOKEN_NUM / single_argc;
+    initOptParser(&parser, db);
+    /* ns_per_tokenはトークン数で割るので, 1つの引数に束ねた方はオプション数で割り直す */
+    double bundle_ns = benchGenParse(&parser, 2, bundle_argv, loop_num, &ret[0]) / opt_num;
+    double single_ns = benchGenParse(&parser, single_argc, single_argv, loop_num, &ret[1]) * (single_argc-1) / opt_num;
+    freeOptParser(&parser);
+
+    if(ret[0] != OPTION_SUCCESS || ret[1] != OPTION_SUCCESS){
+        fprintf(stderr, "error: groupingOptViewWithParser returns %d, %d\n", ret[0], ret[1]);
+        return 1;
+    }
+    printf("mode=short\topt_num=%d\tbundle_ns_per_opt=%.1f\tsingle_ns_per_opt=%.1f\n", opt_num, bundle_ns, single_ns);
+    return 0;
+}
+
+static int benchDispatch(void){
+    const opt_property_db_t *db       = &bench_option_opt_prop_db;
+    int                      prop_num = db->prop_num;
+    char                    *dispatch_argv[1 + 64*2];
+    int                      dispatch_argc = 1;
+    opt_group_db_t          *opt_grp_db;
+    volatile long            sum = 0; /* 最適化で消されないように結果を足し込む */
+
+    if(prop_num > 64){
+        fprintf(stderr, "error: bench_option.opt has more than 64 options\n");
+        return 1;
+    }
+    dispatch_argv[0] = "bench_option";
+    for(int i=0; i<prop_num; i++){
+        dispatch_argv[dispatch_argc++] = (char *)(i % 2 == 0 || !db->props[i].long_form ? db->props[i].short_form : db->props[i].long_form);
+        if(db->props[i].content_num_min > 0){
+            dispatch_argv[dispatch_argc++] = "value";
+        }
+    }
+    if(groupingOpt(db, dispatch_argc, dispatch_argv, &opt_grp_db) != OPTION_SUCCESS){
+        fprintf(stderr, "error: groupingOpt failed\n");
+        return 1;
+    }
+
+    /* 利用者が書く if(strcmp(flag, "-h") == 0 || strcmp(flag, "--help") == 0) ... else if の連鎖と同じ比較を行う */
+    double strcmp_begin = nowNs();
+    for(int loop=0; loop<DISPATCH_LOOP_NUM; loop++){
+        for(int i=0; i<opt_grp_db->grp_num; i++){
+            const char *flag = opt_grp_db->grps[i].option;
+            for(int j=0; j<prop_num; j++){
+                if(strcmp(flag, db->props[j].short_form) == 0 || (db->props[j].long_form && strcmp(flag, db->props[j].long_form) == 0)){
+                    sum += j;
+                    break;
+                }
+            }
+        }
+    }
+    double strcmp_end = nowNs();
+
+    double id_begin = nowNs();
+    for(int loop=0; loop<DISPATCH_LOOP_NUM; loop++){
+        for(int i=0; i<opt_grp_db->grp_num; i++){
+            sum += opt_grp_db->grps[i].prop_id;
+        }
+    }
+    double id_end = nowNs();
+
+    double get_begin = nowNs();
+    for(int loop=0; loop<DISPATCH_LOOP_NUM; loop++){
+        for(int j=0; j<prop_num; j++){
+            sum += getOptGroup(opt_grp_db, j)->content_num;
+        }
+    }
+    double get_end = nowNs();
+
+    double dispatch_num = (double)opt_grp_db->grp_num * DISPATCH_LOOP_NUM;
+    printf("mode=dispatch\tgrp_num=%d\tstrcmp_ns_per_grp=%.1f\tprop_id_ns_per_grp=%.2f\tget_opt_group_ns_per_grp=%.2f\n",
+            opt_grp_db->grp_num, (strcmp_end - strcmp_begin) / dispatch_num, (id_end - id_begin) / dispatch_num,
+            (get_end - get_begin) / ((double)prop_num * DISPATCH_LOOP_NUM));
+    freeOptGroupDB(opt_grp_db);
+    return 0;
+}
+
+static int benchRepl(int line_num){
+    const opt_property_db_t *db = &bench_option_opt_prop_db;
+    char *line0[] = {"repl", "-v"};
+    char *line1[] = {"repl", "-c", "-o", "main.o", "main.c"};
+    char *line2[] = {"repl", "--print", "a", "b", "c"};
+    char *line3[] = {"repl", "-cgv", "-Iinc", "-O", "2", "x.c"};
+    char *line4[] = {"repl", "--jobs", "4", "--keep-going", "all"};
+    char *line5[] = {"repl", "-h"};
+    struct{
+        int    argc;
+        char **argv;
+    } lines[] = {
+        {sizeof(line0)/sizeof(char *), line0}, {sizeof(line1)/sizeof(char *), line1}, {sizeof(line2)/sizeof(char *), line2},
+        {sizeof(line3)/sizeof(char *), line3}, {sizeof(line4)/sizeof(char *), line4}, {sizeof(line5)/sizeof(char *), line5},
+    };
+    int             pattern_num = sizeof(lines) / sizeof(lines[0]);
+    int             failed_num  = 0;
+    opt_group_db_t *opt_grp_db;
+    opt_parser_t    parser;
+
+    /* 1つのopt_parser_tを使い回す */
+    initOptParser(&parser, db);
+    long   reuse_alloc_begin = alloc_num;
+    double reuse_begin       = nowNs();
+    for(int i=0; i<line_num; i++){
+        if(groupingOptWithParser(&parser, lines[i % pattern_num].argc, lines[i % pattern_num].argv, &opt_grp_db) != OPTION_SUCCESS){
+            failed_num++;
+            continue;
+        }
+        freeOptGroupDB(opt_grp_db);
+    }
+    double reuse_end       = nowNs();
+    long   reuse_alloc_end = alloc_num;
+    freeOptParser(&parser);
+
+    /* 行毎にgroupingOptを呼ぶ. opt_property_db_tは共有する */
+    long   once_alloc_begin = alloc_num;
+    double once_begin       = nowNs();
+    for(int i=0; i<line_num; i++){
+        if(groupingOpt(db, lines[i % pattern_num].argc, lines[i % pattern_num].argv, &opt_grp_db) != OPTION_SUCCESS){
+            failed_num++;
+            continue;
+        }
+        freeOptGroupDB(opt_grp_db);
+    }
+    double once_end       = nowNs();
+    long   once_alloc_end = alloc_num;
+
+    /* 行毎にopt_property_db_tを作り直す */
+    int    rebuild_num         = line_num < REPL_REBUILD_NUM ? line_num : REPL_REBUILD_NUM;
+    long   rebuild_alloc_begin = alloc_num;
+    double rebuild_begin       = nowNs();
+    for(int i=0; i<rebuild_num; i++){
+        opt_property_db_t *dyn_db = genOptPropDB(db->prop_num);
+        for(int j=0; j<db->prop_num; j++){
+            const opt_property_t *prop = &db->props[j];
+            regOptProp(dyn_db, prop->short_form, prop->long_form, prop->content_num_min, prop->content_num_max, prop->contents_checker);
+        }
+        if(groupingOpt(dyn_db, lines[i % pattern_num].argc, lines[i % pattern_num].argv, &opt_grp_db) != OPTION_SUCCESS){
+            failed_num++;
+        }
+        else{
+            freeOptGroupDB(opt_grp_db);
+        }
+        freeOptPropDB(dyn_db);
+    }
+    double rebuild_end       = nowNs();
+    long   rebuild_alloc_end = alloc_num;
+
+    if(failed_num > 0){
+        fprintf(stderr, "error: %d lines failed\n", failed_num);
+        return 1;
+    }
+    printf("mode=repl\tline_num=%d\treuse_ns_per_line=%.1f\treuse_allocs_per_line=%.2f\tonce_ns_per_line=%.1f\tonce_allocs_per_line=%.2f\trebuild_ns_per_line=%.1f\trebuild_allocs_per_line=%.2f\n",
+            line_num, (reuse_end - reuse_begin) / line_num, (double)(reuse_alloc_end - reuse_alloc_begin) / line_num,
+            (once_end - once_begin) / line_num, (double)(once_alloc_end - once_alloc_begin) / line_num,
+            (rebuild_end - rebuild_begin) / rebuild_num, (double)(rebuild_alloc_end - rebuild_alloc_begin) / rebuild_num);
+    return 0;
+}
+
+static int benchIter(int token_num){
+    const opt_property_db_t *db        = &bench_option_opt_prop_db;
+    int                      iter_argc = 3 + 1 + token_num;
+    char                   **iter_argv = (char **)malloc(sizeof(char *) * iter_argc);
+    opt_view_group_db_t     *opt_grp_db;
+    opt_iter_t               it;
+    opt_view_group_t         grp;
+    int                      grp_num = 0;
+    int                      ret[3];
+
+    iter_argv[0] = "bench_option";
+    iter_argv[1] = "-o";
+    iter_argv[2] = "out";
+    iter_argv[3] = "-p";
+    for(int i=4; i<iter_argc; i++){
+        iter_argv[i] = "content";
+    }
+
+    long   view_alloc_begin = alloc_num;
+    double view_begin       = nowNs();
+    ret[0] = groupingOptView(db, iter_argc, iter_argv, &opt_grp_db);
+    double view_end         = nowNs();
+    long   view_alloc_end   = alloc_num;
+    freeOptViewGroupDB(opt_grp_db);
+
+    /* 1回では短すぎるのでITER_FIRST_LOOP_NUM回の平均をとる */
+    long   first_alloc_begin = alloc_num;
+    double first_begin       = nowNs();
+    for(int i=0; i<ITER_FIRST_LOOP_NUM; i++){
+        initOptIter(&it, db, iter_argc, iter_argv);
+        ret[1] = optIterNext(&it, &grp);
+        freeOptIter(&it);
+    }
+    double first_end         = nowNs();
+    long   first_alloc_end   = alloc_num;
+
+    long   all_alloc_begin = alloc_num;
+    double all_begin       = nowNs();
+    initOptIter(&it, db, iter_argc, iter_argv);
+    while((ret[2] = optIterNext(&it, &grp)) == OPTION_SUCCESS){
+        grp_num++;
+    }
+    freeOptIter(&it);
+    double all_end         = nowNs();
+    long   all_alloc_end   = alloc_num;
+    free(iter_argv);
+
+    if(ret[0] != OPTION_SUCCESS || ret[1] != OPTION_SUCCESS || ret[2] != OPTION_ITER_END || grp_num != 2){
+        fprintf(stderr, "error: groupingOptView returns %d, optIterNext returns %d, %d (%d groups)\n", ret[0], ret[1], ret[2], grp_num);
+        return 1;
+    }
+    printf("mode=iter\ttoken_num=%d\tview_ns=%.0f\tview_allocs=%ld\titer_first_ns=%.0f\titer_first_allocs=%ld\titer_all_ns=%.0f\titer_all_allocs=%ld\n",
+            token_num, view_end - view_begin, view_alloc_end - view_alloc_begin,
+            (first_end - first_begin) / ITER_FIRST_LOOP_NUM, (first_alloc_end - first_alloc_begin) / ITER_FIRST_LOOP_NUM,
+            all_end - all_begin, all_alloc_end - all_alloc_begin);
+    return 0;
+}
+
+static _Atomic long checker_call_num = 0;
+
+static int benchChecker_(char **contents, int content_num){
+    checker_call_num++;
+    usleep(CHECKER_SLEEP_US);
+    return content_num > 0 && contents[0][0] == '/' ? 0 : 1;
+}
+
+static int benchChecker(void){
+    opt_property_db_t *db = genOptPropDB(CHECKER_OPT_NUM);
+    char               short_forms[CHECKER_OPT_NUM][8];
+    char              *checker_argv[1 + CHECKER_OPT_NUM*5];
+    int                checker_argc = 1;
+    opt_group_db_t    *opt_grp_db;
+    opt_group_batch_t *batch;
+    opt_argv_t         items[CHECKER_BATCH_NUM];
+    int                failed_num = 0;
+
+    checker_argv[0] = "bench_option";
+    for(int i=0; i<CHECKER_OPT_NUM; i++){
+        sprintf(short_forms[i], "-%c", 'a'+i);
+        regOptProp(db, short_forms[i], NULL, 1, INT_MAX, benchChecker_);
+        checker_argv[checker_argc++] = short_forms[i];
+        for(int j=0; j<4; j++){
+            checker_argv[checker_argc++] = "/usr/include";
+        }
+    }
+    for(int i=0; i<CHECKER_BATCH_NUM; i++){
+        items[i] = (opt_argv_t){checker_argc, checker_argv};
+    }
+
+    double serial_begin = nowNs();
+    failed_num += groupingOpt(db, checker_argc, checker_argv, &opt_grp_db) != OPTION_SUCCESS;
+    double serial_end   = nowNs();
+    freeOptGroupDB(opt_grp_db);
+
+    setOptCheckerThreads(db, CHECKER_THREAD_NUM);
+    double parallel_begin = nowNs();
+    failed_num += groupingOpt(db, checker_argc, checker_argv, &opt_grp_db) != OPTION_SUCCESS;
+    double parallel_end   = nowNs();
+    freeOptGroupDB(opt_grp_db);
+    setOptCheckerThreads(db, 1);
+
+    long   nomemo_call_begin = checker_call_num;
+    double nomemo_begin      = nowNs();
+    failed_num += groupingOptBatch(db, CHECKER_BATCH_NUM, items, 1, &batch) != OPTION_SUCCESS;
+    double nomemo_end        = nowNs();
+    long   nomemo_call_end   = checker_call_num;
+    freeOptGroupBatch(batch);
+
+    opt_checker_memo_t *memo = genOptCheckerMemo();
+    setOptCheckerMemo(db, memo);
+    long   memo_call_begin = checker_call_num;
+    double memo_begin      = nowNs();
+    failed_num += groupingOptBatch(db, CHECKER_BATCH_NUM, items, 1, &batch) != OPTION_SUCCESS;
+    double memo_end        = nowNs();
+    long   memo_call_end   = checker_call_num;
+    freeOptGroupBatch(batch);
+    setOptCheckerMemo(db, NULL);
+    freeOptCheckerMemo(memo);
+    freeOptPropDB(db);
+
+    if(failed_num > 0){
+        fprintf(stderr, "error: %d parses failed\n", failed_num);
+        return 1;
+    }
+    printf("mode=checker\topt_num=%d\tsleep_us=%d\tserial_us=%.0f\tparallel_us=%.0f\tthread_num=%d\tbatch_num=%d\tnomemo_us=%.0f\tnomemo_calls=%ld\tmemo_us=%.0f\tmemo_calls=%ld\n",
+            CHECKER_OPT_NUM, CHECKER_SLEEP_US, (serial_end - serial_begin) / 1e3, (parallel_end - parallel_begin) / 1e3, CHECKER_THREAD_NUM,
+            CHECKER_BATCH_NUM, (nomemo_end - nomemo_begin) / 1e3, nomemo_call_end - nomemo_call_begin,
+            (memo_end - memo_begin) / 1e3, memo_call_end - memo_call_begin);
+    return 0;
+}
+
+static int benchValue(int token_num){
+    opt_property_db_t *str_db   = genOptPropDB(2);
+    opt_property_db_t *typed_db = genOptPropDB(2);
+    int                value_argc = 1 + (1 + token_num)*2;
+    char             **value_argv = (char **)malloc(sizeof(char *) * value_argc);
+    opt_group_db_t    *opt_grp_db;
+    opt_parser_t       parser;
+    int64_t            int_sum[2] = {0, 0};
+    double             dbl_sum[2] = {0, 0};
+    int                failed_num = 0;
+
+    regOptProp(str_db, "-n", "--num", 1, INT_MAX, NULL);
+    regOptProp(str_db, "-d", "--dbl", 1, INT_MAX, NULL);
+    regOptPropTyped(typed_db, "-n", "--num", 1, INT_MAX, NULL, OPT_VALUE_INT64, NULL);
+    regOptPropTyped(typed_db, "-d", "--dbl", 1, INT_MAX, NULL, OPT_VALUE_DOUBLE, NULL);
+
+    value_argv[0]           = "bench_option";
+    value_argv[1]           = "-n";
+    value_argv[2+token_num] = "-d";
+    for(int i=0; i<token_num; i++){
+        value_argv[2+i]           = (char *)malloc(32);
+        value_argv[3+token_num+i] = (char *)malloc(32);
+        sprintf(value_argv[2+i], "%d", (int)(i * 2654435761u % 100000000) - 50000000);
+        sprintf(value_argv[3+token_num+i], "%d.%03d", (int)(i * 40503u % 100000), i % 1000);
+    }
+
+    /* 作業領域の確保を除くためにどちらもparserを使い回す */
+    initOptParser(&parser, str_db);
+    double str_begin = nowNs();
+    for(int l=0; l<VALUE_LOOP_NUM; l++){
+        failed_num += groupingOptWithParser(&parser, value_argc, value_argv, &opt_grp_db) != OPTION_SUCCESS;
+        for(int i=0; i<opt_grp_db->grps[0].content_num; i++){
+            int_sum[0] += strtoll(opt_grp_db->grps[0].contents[i], NULL, 10);
+        }
+        for(int i=0; i<opt_grp_db->grps[1].content_num; i++){
+            dbl_sum[0] += strtod(opt_grp_db->grps[1].contents[i], NULL);
+        }
+        freeOptGroupDB(opt_grp_db);
+    }
+    double str_end = nowNs();
+    freeOptParser(&parser);
+
+    initOptParser(&parser, typed_db);
+    double typed_begin = nowNs();
+    for(int l=0; l<VALUE_LOOP_NUM; l++){
+        failed_num += groupingOptWithParser(&parser, value_argc, value_argv, &opt_grp_db) != OPTION_SUCCESS;
+        for(int i=0; i<opt_grp_db->grps[0].content_num; i++){
+            int_sum[1] += opt_grp_db->grps[0].values[i].i64;
+        }
+        for(int i=0; i<opt_grp_db->grps[1].content_num; i++){
+            dbl_sum[1] += opt_grp_db->grps[1].values[i].dbl;
+        }
+        freeOptGroupDB(opt_grp_db);
+    }
+    double typed_end = nowNs();
+    freeOptParser(&parser);
+
+    for(int i=0; i<token_num; i++){
+        free(value_argv[2+i]);
+        free(value_argv[3+token_num+i]);
+    }
+    free(value_argv);
+    freeOptPropDB(str_db);
+    freeOptPropDB(typed_db);
+
+    if(failed_num > 0 || int_sum[0] != int_sum[1] || dbl_sum[0] != dbl_sum[1]){
+        fprintf(stderr, "error: %d parses failed or the values differ\n", failed_num);
+        return 1;
+    }
+    printf("mode=value\ttoken_num=%d\tstrto_ns_per_content=%.1f\ttyped_ns_per_content=%.1f\n",
+            token_num, (str_end - str_begin) / VALUE_LOOP_NUM / (token_num*2),
+            (typed_end - typed_begin) / VALUE_LOOP_NUM / (token_num*2));
+    return 0;
+}
+
+static int benchAbbrev(int prop_num){
+    opt_property_db_t   *db          = genOptPropDB(prop_num);
+    char               **long_forms  = (char **)malloc(sizeof(char *) * prop_num);
+    char               **abbrev_argv = (char **)malloc(sizeof(char *) * (prop_num+1));
+    char                 short_form[32];
+    opt_parser_t         parser;
+    opt_view_group_db_t *opt_grp_db;
+    int                  failed_num = 0;
+    long                 found_sum  = 0;
+
+    abbrev_argv[0] = "bench_option";
+    for(int i=0; i<prop_num; i++){
+        long_forms[i]    = (char *)malloc(32);
+        abbrev_argv[i+1] = (char *)malloc(32);
+        sprintf(short_form, "-o%d", i);
+        sprintf(long_forms[i], "--opt%05d-name", i);
+        sprintf(abbrev_argv[i+1], "--opt%05d", i);
+        regOptProp(db, short_form, long_forms[i], 0, 0, NULL);
+    }
+    setOptAbbrev(db, true);
+
+    initOptParser(&parser, db);
+    double trie_begin = nowNs();
+    for(int l=0; l<ABBREV_LOOP_NUM; l++){
+        failed_num += groupingOptViewWithParser(&parser, prop_num+1, abbrev_argv, &opt_grp_db) != OPTION_SUCCESS || opt_grp_db->grp_num != prop_num;
+        freeOptViewGroupDB(opt_grp_db);
+    }
+    double trie_end = nowNs();
+    freeOptParser(&parser);
+
+    /* 基数木を使わずに全てのlong_formと比べる素朴な方法. 解析は含まないので接頭辞を探す時間だけになる */
+    double scan_begin = nowNs();
+    for(int l=0; l<ABBREV_LOOP_NUM; l++){
+        for(int i=1; i<=prop_num; i++){
+            size_t len   = strlen(abbrev_argv[i]);
+            int    found = -1;
+            for(int j=0; j<prop_num; j++){
+                if(strncmp(long_forms[j], abbrev_argv[i], len) == 0){
+                    found = found == -1 ? j : -2;
+                }
+            }
+            found_sum += found;
+        }
+    }
+    double scan_end = nowNs();
+
+    for(int i=0; i<prop_num; i++){
+        free(long_forms[i]);
+        free(abbrev_argv[i+1]);
+    }
+    free(long_forms);
+    free(abbrev_argv);
+    freeOptPropDB(db);
+
+    if(failed_num > 0 || found_sum != (long)ABBREV_LOOP_NUM * prop_num * (prop_num-1) / 2){
+        fprintf(stderr, "error: %d parses failed or the scan found wrong options\n", failed_num);
+        return 1;
+    }
+    printf("mode=abbrev\tprop_num=%d\ttrie_parse_ns_per_opt=%.1f\tscan_lookup_ns_per_opt=%.1f\n",
+            prop_num, (trie_end - trie_begin) / ABBREV_LOOP_NUM / prop_num, (scan_end - scan_begin) / ABBREV_LOOP_NUM / prop_num);
+    return 0;
+}
+
+static const char *const bench_complete_enums[] = {"always", "auto", "never", NULL};
+
+static int benchComplete(int prop_num){
+    opt_property_db_t *db            = genOptPropDB(prop_num);
+    char             **long_forms    = (char **)malloc(sizeof(char *) * prop_num);
+    char               short_form[32];
+    const char        *cands[COMPLETE_CAND_MAX];
+    int                cand_pos;
+    int                failed_num    = 0;
+    char              *many_words[]  = {"bench_option", "--opt0"};
+    char              *few_words[]   = {"bench_option", "--opt0012"};
+    char              *enum_words[]  = {"bench_option", "-o1", "-o2", "-o3", "-o4", "-o5", "-o6", "-o7", "--opt00008-name", "a"};
+    int                enum_word_num = sizeof(enum_words) / sizeof(enum_words[0]);
+    char               nameless_eq[40];
+    char              *nameless_words[] = {"bench_option", NULL, ""};
+
+    /* 最後のオプションはenum_namesを持たないOPT_VALUE_ENUMにする. 候補は無いが補完できなければならない */
+    for(int i=0; i<prop_num; i++){
+        long_forms[i] = (char *)malloc(32);
+        sprintf(short_form, "-o%d", i);
+        sprintf(long_forms[i], "--opt%05d-name", i);
+        regOptPropTyped(db, short_form, long_forms[i], 0, 1, NULL, OPT_VALUE_ENUM, i < prop_num-1 ? bench_complete_enums : NULL);
+    }
+    sprintf(nameless_eq, "%s=a", long_forms[prop_num-1]);
+    nameless_words[1] = long_forms[prop_num-1];
+
+    /* TABを押す度にプロセスが起動する場合は毎回この時間がかかる. optgenで生成した場合は索引が構築済みなので2回目以降と同じになる */
+    long   first_alloc_begin = alloc_num;
+    double first_begin       = nowNs();
+    failed_num += completeOpt(db, 2, many_words, 1, &cand_pos, cands, COMPLETE_CAND_MAX) != (prop_num < 10000 ? prop_num : 10000);
+    double first_end         = nowNs();
+    long   first_alloc_end   = alloc_num;
+
+    double many_begin = nowNs();
+    for(int l=0; l<COMPLETE_LOOP_NUM; l++){
+        failed_num += completeOpt(db, 2, many_words, 1, &cand_pos, cands, COMPLETE_CAND_MAX) != (prop_num < 10000 ? prop_num : 10000);
+    }
+    double many_end = nowNs();
+
+    double few_begin = nowNs();
+    for(int l=0; l<COMPLETE_LOOP_NUM; l++){
+        failed_num += completeOpt(db, 2, few_words, 1, &cand_pos, cands, COMPLETE_CAND_MAX) != (prop_num > 120 ? 10 : 0);
+    }
+    double few_end = nowNs();
+
+    long   enum_alloc_begin = alloc_num;
+    double enum_begin       = nowNs();
+    for(int l=0; l<COMPLETE_LOOP_NUM; l++){
+        failed_num += completeOpt(db, enum_word_num, enum_words, enum_word_num-1, &cand_pos, cands, COMPLETE_CAND_MAX) != 2;
+    }
+    double enum_end       = nowNs();
+    long   enum_alloc_end = alloc_num;
+
+    failed_num += completeOpt(db, 3, nameless_words, 2, &cand_pos, cands, COMPLETE_CAND_MAX) != 0;
+    nameless_words[1] = nameless_eq;
+    failed_num += completeOpt(db, 2, nameless_words, 1, &cand_pos, cands, COMPLETE_CAND_MAX) != 0;
+
+    for(int i=0; i<prop_num; i++){
+        free(long_forms[i]);
+    }
+    free(long_forms);
+    freeOptPropDB(db);
+
+    if(failed_num > 0 || enum_alloc_end != enum_alloc_begin){
+        fprintf(stderr, "error: %d completions returned wrong candidates or completeOpt allocated memory\n", failed_num);
+        return 1;
+    }
+    printf("mode=complete\tprop_num=%d\tfirst_us=%.1f\tfirst_allocs=%ld\tmany_ns=%.1f\tfew_ns=%.1f\tenum_ns=%.1f\n",
+            prop_num, (first_end - first_begin) / 1000, first_alloc_end - first_alloc_begin,
+            (many_end - many_begin) / COMPLETE_LOOP_NUM, (few_end - few_begin) / COMPLETE_LOOP_NUM, (enum_end - enum_begin) / COMPLETE_LOOP_NUM);
+    return 0;
+}
+
+static int benchCommandFind_(const void *name, const void *sub){
+    return strcmp((const char *)name, ((const opt_command_t *)sub)->name);
+}
+
+static int benchCommandSlice(const opt_property_db_t *root_db, const opt_property_db_t **sub_dbs, int argc, char **argv,
+        opt_group_db_t **root_grp_db, opt_group_db_t **sub_grp_db){
+    /* 根のオプションのコンテンツを取らない前提で, 最初にサブコマンドの名前に一致した引数で切り分ける */
+    for(int i=1; i<argc; i++){
+        const opt_command_t *sub = bsearch(argv[i], bench_cmd_subs, bench_cmd_root.sub_num, sizeof(opt_command_t), benchCommandFind_);
+        if(sub != NULL){
+            int ret = groupingOpt(root_db, i, argv, root_grp_db);
+            if(ret != OPTION_SUCCESS){
+                return ret;
+            }
+            ret = groupingOpt(sub_dbs[sub - bench_cmd_subs], argc - i, argv + i, sub_grp_db);
+            if(ret != OPTION_SUCCESS){
+                freeOptGroupDB(*root_grp_db);
+            }
+            return ret;
+        }
+    }
+    return -1; /* サブコマンドが無い */
+}
+
+static int benchCommand(void){
+    char                    *cmd_argv[] = {"bench_option", "-a", "cmd17", "-b", "-c", "x", "-p", "y"};
+    int                      cmd_argc   = sizeof(cmd_argv) / sizeof(cmd_argv[0]);
+    int                      sub_num    = bench_cmd_root.sub_num;
+    const opt_property_db_t *dyn_sub_dbs[sizeof(bench_cmd_subs) / sizeof(bench_cmd_subs[0])];
+    opt_property_db_t       *dyn_dbs[sizeof(bench_cmd_subs) / sizeof(bench_cmd_subs[0]) + 1];
+    opt_group_db_t          *root_grp_db;
+    opt_group_db_t          *sub_grp_db;
+    opt_command_group_db_t  *cmd_grp_db;
+    int                      failed_num = 0;
+
+    /* 起動時に根と全てのサブコマンドを登録し, argvを切り分けて1回解析する */
+    long   eager_alloc_begin = alloc_num;
+    double eager_begin       = nowNs();
+    for(int i=0; i<=sub_num; i++){
+        dyn_dbs[i] = genOptPropDB(16);
+#define BENCH_REG(short_form, long_form, min, max, checker) regOptProp(dyn_dbs[i], short_form, long_form, min, max, checker);
+        BENCH_OPTS(BENCH_REG)
+#undef BENCH_REG
+    }
+    for(int i=0; i<sub_num; i++){
+        dyn_sub_dbs[i] = dyn_dbs[i+1];
+    }
+    failed_num += benchCommandSlice(dyn_dbs[0], dyn_sub_dbs, cmd_argc, cmd_argv, &root_grp_db, &sub_grp_db) != OPTION_SUCCESS;
+    double eager_end       = nowNs();
+    long   eager_alloc_end = alloc_num;
+    freeOptGroupDB(root_grp_db);
+    freeOptGroupDB(sub_grp_db);
+
+    /* 静的なサブコマンドの木を初めて解析する. 辿った根とcmd17の索引だけが構築される */
+    long   lazy_alloc_begin = alloc_num;
+    double lazy_begin       = nowNs();
+    int    lazy_ret         = groupingOptCommand(&bench_cmd_root, cmd_argc, cmd_argv, &cmd_grp_db);
+    double lazy_end         = nowNs();
+    long   lazy_alloc_end   = alloc_num;
+    if(lazy_ret != OPTION_SUCCESS){
+        fprintf(stderr, "error: groupingOptCommand returns %d\n", lazy_ret);
+        return 1;
+    }
+    freeOptCommandGroupDB(cmd_grp_db);
+    int built_num = 0;
+    for(int i=0; i<=sub_num; i++){
+        const opt_property_db_t *db = i < sub_num ? bench_cmd_subs[i].db : bench_cmd_root.db;
+        built_num += atomic_load(&db->idx_state) == OPT_IDX_BUILT;
+    }
+
+    /* 2回目以降. どちらも索引は構築済み */
+    double cmd_begin = nowNs();
+    for(int l=0; l<COMMAND_LOOP_NUM; l++){
+        failed_num += groupingOptCommand(&bench_cmd_root, cmd_argc, cmd_argv, &cmd_grp_db) != OPTION_SUCCESS;
+        failed_num += cmd_grp_db->grp_db->grp_num != 1 || cmd_grp_db->sub == NULL || cmd_grp_db->sub->grp_db->grp_num != 3;
+        freeOptCommandGroupDB(cmd_grp_db);
+    }
+    double cmd_end = nowNs();
+
+    double slice_begin = nowNs();
+    for(int l=0; l<COMMAND_LOOP_NUM; l++){
+        failed_num += benchCommandSlice(dyn_dbs[0], dyn_sub_dbs, cmd_argc, cmd_argv, &root_grp_db, &sub_grp_db) != OPTION_SUCCESS;
+        failed_num += root_grp_db->grp_num != 1 || sub_grp_db->grp_num != 3;
+        freeOptGroupDB(root_grp_db);
+        freeOptGroupDB(sub_grp_db);
+    }
+    double slice_end = nowNs();
+
+    for(int i=0; i<=sub_num; i++){
+        freeOptPropDB(dyn_dbs[i]);
+    }
+    if(failed_num > 0){
+        fprintf(stderr, "error: %d parses failed\n", failed_num);
+        return 1;
+    }
+    printf("mode=command\tsub_num=%d\teager_first_ns=%.0f\teager_first_allocs=%ld\teager_built_dbs=%d\tlazy_first_ns=%.0f\tlazy_first_allocs=%ld\tlazy_built_dbs=%d\tcommand_ns=%.1f\tslice_ns=%.1f\n",
+            sub_num, eager_end - eager_begin, eager_alloc_end - eager_alloc_begin, sub_num + 1, lazy_end - lazy_begin, lazy_alloc_end - lazy_alloc_begin, built_num,
+            (cmd_end - cmd_begin) / COMMAND_LOOP_NUM, (slice_end - slice_begin) / COMMAND_LOOP_NUM);
+    return 0;
+}
+
+/* 再現できるように擬似乱数の種は固定する */
+static unsigned long long mixed_rand_state = 88172645463325252ull;
+
+static unsigned int mixedRand(unsigned int n){
+    mixed_rand_state ^= mixed_rand_state << 13;
+    mixed_rand_state ^= mixed_rand_state >> 7;
+    mixed_rand_state ^= mixed_rand_state << 17;
+    return (unsigned int)(mixed_rand_state >> 32) % n;
+}
+
+/* mixedのスキーマ. propsの添字を4で割った余りでフラグ, 1個のコンテンツ, 1個以上のコンテンツ, 0から2個のコンテンツを取るオプションにする */
+static void mixedProp(int i, char *short_form, char *long_form, int *min, int *max){
+    static const char letters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    static const int  mins[]    = {0, 1, 1, 0};
+    static const int  maxs[]    = {0, 1, INT_MAX, 2};
+
+    /* 先頭の52個は -a のように束ねられる1文字の短縮形式にする */
+    if(i < (int)sizeof(letters) - 1){
+        sprintf(short_form, "-%c", letters[i]);
+    }
+    else{
+        sprintf(short_form, "-s%d", i);
+    }
+    sprintf(long_form, "--opt-%05d", i);
+    *min = mins[i % 4];
+    *max = maxs[i % 4];
+}
+
+/* 解析のトークンがtoken_num個程度になるargvを作る. オプションは乱順に短縮形式, 詳細形式, --long=a,b,c の形を混ぜて1回ずつ指定し,
+ * 1個以上のコンテンツを取るオプションに残りのコンテンツを配り, 最後にフラグの後ろに対応するオプションが無いコンテンツを1割並べる.
+ * 戻り値はargvの要素数. *tok_numに解析で切り出されるトークンの数を格納する */
+static int mixedArgv(int prop_num, int token_num, char ***mixed_argv, char **mixed_buf, long *tok_num){
+    int   *order    = (int *)malloc(sizeof(int) * prop_num);
+    int    multi    = 0;
+    int    arg_max  = token_num + prop_num + 2;
+    char **args     = (char **)malloc(sizeof(char *) * arg_max);
+    char  *buf      = (char *)malloc((size_t)arg_max * 40);
+    char  *p        = buf;
+    int    arg_num  = 0;
+    long   toks     = 0;
+    long   optless  = token_num / 10;
+    char   short_form[32];
+    char   long_form[32];
+    int    min;
+    int    max;
+
+    /* 0番目のフラグは末尾に置くので乱順に並べるのは1番目以降 */
+    for(int i=1; i<prop_num; i++){
+        order[i-1] = i;
+        multi += i % 4 == 2;
+    }
+    for(int i=prop_num-2; i>0; i--){
+        int j = mixedRand(i + 1), t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    args[arg_num++] = "bench_option";
+    for(int k=0; k<prop_num-1 && toks < token_num - optless - 1; k++){
+        int i = order[k];
+        mixedProp(i, short_form, long_form, &min, &max);
+        /* 1個以上のコンテンツを取るオプションは残りの予算を等分し, そうでなければ最小数から最大数のどれかにする */
+        long content_num = max == INT_MAX ? (token_num - optless - 1 - toks) / (multi > 0 ? multi : 1) : min + mixedRand(max - min + 1);
+        if(content_num < min){
+            content_num = min;
+        }
+        multi -= max == INT_MAX;
+
+        int form = mixedRand(3);
+        if(form == 2 && content_num > 0){
+            /* --long=a,b,c の形にはコンテンツを3個まで詰め, 残りは後ろに並べる */
+            int packed = content_num < 3 ? content_num : 3;
+            args[arg_num++] = p;
+            p += sprintf(p, "%s=", long_form);
+            for(int c=0; c<packed; c++){
+                p += sprintf(p, c == 0 ? "v%ld" : ",v%ld", toks + c);
+            }
+            p++;
+            toks        += 1 + packed;
+            content_num -= packed;
+        }
+        else{
+            args[arg_num++] = p;
+            p += sprintf(p, "%s", form == 0 ? short_form : long_form) + 1;
+            toks++;
+        }
+        for(long c=0; c<content_num && arg_num < arg_max - optless - 2; c++){
+            args[arg_num++] = p;
+            p += sprintf(p, "src/file%07ld.c", toks++) + 1;
+        }
+    }
+
+    /* フラグの後ろのコンテンツは対応するオプションが無いコンテンツになる */
+    mixedProp(0, short_form, long_form, &min, &max);
+    args[arg_num++] = p;
+    p += sprintf(p, "%s", long_form) + 1;
+    toks++;
+    for(long c=0; c<optless; c++){
+        args[arg_num++] = p;
+        p += sprintf(p, "input%07ld", toks++) + 1;
+    }
+
+    free(order);
+    *mixed_argv = args;
+    *mixed_buf  = buf;
+    *tok_num    = toks;
+    return arg_num;
+}
+
+static int benchMixed(int prop_num, int token_num){
+    char   short_form[32];
+    char   long_form[32];
+    int    min;
+    int    max;
+    char **mixed_argv;
+    char  *mixed_buf;
+    long   tok_num;
+    int    mixed_argc = mixedArgv(prop_num, token_num, &mixed_argv, &mixed_buf, &tok_num);
+
+    long   reg_alloc_begin = alloc_num;
+    double reg_begin       = nowNs();
+    opt_property_db_t *db  = genOptPropDB(prop_num);
+    for(int i=0; i<prop_num; i++){
+        mixedProp(i, short_form, long_form, &min, &max);
+        regOptProp(db, short_form, long_form, min, max, NULL);
+    }
+    double reg_end       = nowNs();
+    long   reg_alloc_end = alloc_num;
+
+    /* 短い場合は時計の分解能に埋もれるので合計がMIXED_MIN_TOKEN_NUMトークン以上になるまで繰り返し, 最も速かった回を採る */
+    int    loop_num     = tok_num < MIXED_MIN_TOKEN_NUM ? MIXED_MIN_TOKEN_NUM / tok_num : 1;
+    double grouping_min = 0;
+    double free_min     = 0;
+    long   grouping_allocs = 0;
+    int    grp_num      = 0;
+    int    ret          = OPTION_SUCCESS;
+    for(int l=0; l<loop_num && ret == OPTION_SUCCESS; l++){
+        opt_group_db_t *opt_grp_db;
+        long   alloc_begin    = alloc_num;
+        double grouping_begin = nowNs();
+        ret                   = groupingOpt(db, mixed_argc, mixed_argv, &opt_grp_db);
+        double grouping_end   = nowNs();
+        grouping_allocs       = alloc_num - alloc_begin;
+        if(ret != OPTION_SUCCESS){
+            break;
+        }
+        grp_num = opt_grp_db -> grp_num;
+
+        double free_begin = nowNs();
+        freeOptGroupDB(opt_grp_db);
+        double free_end   = nowNs();
+        if(l == 0 || grouping_end - grouping_begin < grouping_min){
+            grouping_min = grouping_end - grouping_begin;
+        }
+        if(l == 0 || free_end - free_begin < free_min){
+            free_min = free_end - free_begin;
+        }
+    }
+    freeOptPropDB(db);
+    free(mixed_argv);
+    free(mixed_buf);
+
+    if(ret != OPTION_SUCCESS){
+        fprintf(stderr, "error: groupingOpt returns %d for prop_num=%d token_num=%d\n", ret, prop_num, token_num);
+        return 1;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("mode=mixed\tprop_num=%d\ttoken_num=%ld\targ_num=%d\tgrp_num=%d\treg_ns=%.0f\treg_allocs=%ld\tgrouping_ns=%.0f\tgrouping_allocs=%ld\tfree_ns=%.0f\tns_per_token=%.1f\tallocs_per_token=%.6f\tmax_rss_kb=%ld\n",
+            prop_num, tok_num, mixed_argc - 1, grp_num, reg_end - reg_begin, reg_alloc_end - reg_alloc_begin,
+            grouping_min, grouping_allocs, free_min, grouping_min / tok_num, (double)grouping_allocs / tok_num, usage.ru_maxrss);
+    return 0;
+}
+
+static int benchSuite(void){
+    static const int prop_nums[]  = {10, 100, 1000, 10000};
+    static const int token_nums[] = {10, 1000, 100000, 1000000};
+    int failed_num = 0;
+
+    /* 最大RSSがそれまでの構成の分を含まないように, 構成毎に子プロセスで測る */
+    for(int i=0; i<(int)(sizeof(prop_nums)/sizeof(prop_nums[0])); i++){
+        for(int j=0; j<(int)(sizeof(token_nums)/sizeof(token_nums[0])); j++){
+            fflush(stdout);
+            pid_t pid = fork();
+            if(pid == 0){
+                exit(benchMixed(prop_nums[i], token_nums[j]));
+            }
+            int status;
+            if(pid == -1 || waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0){
+                failed_num++;
+            }
+        }
+    }
+    return failed_num > 0;
+}
+
+/* 以前のrwhのstrninsertと同じく, キー毎に行全体を複製して1文字を挿入する */
+static char *copyInsert(char *str, int pos, char ch){
+    size_t len = strlen(str);
+    char  *new = (char *)malloc(len+2);
+    if(!new){
+        free(str);
+        return NULL;
+    }
+    memcpy(new, str, pos);
+    new[pos] = ch;
+    memcpy(new+pos+1, str+pos, len-pos+1);
+    free(str);
+    return new;
+}
+
+static int benchLineBuf(int line_len){
+    linebuf_t *lb = genLineBuf(0);
+    if(!lb || line_len < 2){
+        fprintf(stderr, "error: line_len must be >= 2\n");
+        freeLineBuf(lb);
+        return 1;
+    }
+
+    /* 末尾に1文字ずつ打ち込む */
+    double append_begin = nowNs();
+    for(int i=0; i<line_len; i++){
+        char ch = 'a' + i % 26;
+        if(insertLineBuf(lb, &ch, 1) != 0){
+            fprintf(stderr, "error: insertLineBuf failed\n");
+            freeLineBuf(lb);
+            return 1;
+        }
+    }
+    double append_end = nowNs();
+
+    /* 行の中央で挿入, バックスペース, カーソル移動 */
+    moveLineBuf(lb, line_len / 2);
+    double insert_begin = nowNs();
+    for(int i=0; i<LINEBUF_KEY_NUM; i++){
+        insertLineBuf(lb, "x", 1);
+    }
+    double insert_end = nowNs();
+
+    double backspace_begin = nowNs();
+    for(int i=0; i<LINEBUF_KEY_NUM; i++){
+        deleteLineBuf(lb, 1, 0);
+    }
+    double backspace_end = nowNs();
+
+    double move_begin = nowNs();
+    for(int i=0; i<LINEBUF_KEY_NUM; i++){
+        moveLineBuf(lb, lb->gap_head + (i % 2 ? 1 : -1));
+    }
+    double move_end = nowNs();
+
+    char *line = dupLineBuf(lb);
+    freeLineBuf(lb);
+    if(!line || (int)strlen(line) != line_len){
+        fprintf(stderr, "error: line is broken\n");
+        free(line);
+        return 1;
+    }
+
+    /* 以前の方法で中央に挿入する */
+    double copy_begin = nowNs();
+    for(int i=0; i<LINEBUF_KEY_NUM; i++){
+        if(!(line = copyInsert(line, line_len / 2, 'x'))){
+            fprintf(stderr, "error: out of memory\n");
+            return 1;
+        }
+    }
+    double copy_end = nowNs();
+    free(line);
+
+    printf("mode=linebuf\tline_len=%d\tappend_ns_per_key=%.1f\tinsert_ns_per_key=%.1f\tbackspace_ns_per_key=%.1f\tmove_ns_per_key=%.1f\tcopy_insert_ns_per_key=%.1f\n",
+            line_len, (append_end - append_begin) / line_len, (insert_end - insert_begin) / LINEBUF_KEY_NUM,
+            (backspace_end - backspace_begin) / LINEBUF_KEY_NUM, (move_end - move_begin) / LINEBUF_KEY_NUM,
+            (copy_end - copy_begin) / LINEBUF_KEY_NUM);
+    return 0;
+}
+
+typedef struct _rwh_result_t{
+    long   byte_num;
+    long   line_num;
+    long   syscall_num;
+    long   write_num;
+    long   out_bytes;
+    long   char_num; /* rwhが返した行の文字の数の合計 */
+    double ns;
+}rwh_result_t;
+
+/* 以前のrwhのgetchと同じく, 1バイト毎に端末を非カノニカルモードにして読み, 元に戻す */
+static int perByteGetch(void){
+    char           ch = 0;
+    struct termios old;
+    tcgetattr(STDIN_FILENO, &old);
+    old.c_lflag &= ~(ICANON | ECHO);
+    old.c_cc[VMIN]  = 1;
+    old.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &old);
+    ssize_t n = read(STDIN_FILENO, &ch, 1);
+    old.c_lflag |= ICANON | ECHO;
+    tcsetattr(STDIN_FILENO, TCSADRAIN, &old);
+    return n == 1 ? (unsigned char)ch : EOF;
+}
+
+/* 子プロセスでptyのスレーブを標準入力にして読み, 結果をpipe_fdに書く */
+static void rwhChild(int slave_fd, int pipe_fd, int mode, int line_num){
+    const char  *cands[] = {"help", "quit"};
+    rwh_result_t result  = {0};
+    FILE        *out     = tmpfile();
+
+    dup2(slave_fd, STDIN_FILENO);
+    dup2(fileno(out), STDOUT_FILENO);
+    close(slave_fd);
+
+    rwhctx_t *ctx = genRwhCtx("$ ", 16, cands, 2);
+    input_syscall_num = 0;
+    output_write_num  = 0;
+    double begin = nowNs();
+    if(mode == 0){
+        /* rwhを呼ぶ毎に生モードに入る */
+        for(char *line; result.line_num < line_num && (line = rwh(ctx)) != NULL; result.line_num++){
+            result.char_num += strlen(line);
+        }
+    }
+    else if(mode == 1){
+        /* 全ての行を1つのセッションで読む */
+        beginRawSession();
+        for(char *line; result.line_num < line_num && (line = rwh(ctx)) != NULL; result.line_num++){
+            result.char_num += strlen(line);
+        }
+        endRawSession();
+    }
+    else{
+        /* 以前の方法で同じ入力を読むだけ. 編集はしない */
+        for(int ch; result.line_num < line_num && (ch = perByteGetch()) != EOF; result.line_num += ch == '\n');
+    }
+    result.ns          = nowNs() - begin;
+    result.syscall_num = input_syscall_num;
+    result.write_num   = output_write_num;
+    fflush(stdout);
+    result.out_bytes   = lseek(STDOUT_FILENO, 0, SEEK_END);
+    freeRwhCtx(ctx);
+    if(write(pipe_fd, &result, sizeof(result)) != sizeof(result)){
+        exit(1);
+    }
+    exit(0);
+}
+
+static int benchRwhOne(const char *input, long input_len, int line_num, int mode, rwh_result_t *result){
+    int master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if(master_fd < 0 || grantpt(master_fd) != 0 || unlockpt(master_fd) != 0){
+        perror("posix_openpt()");
+        return 1;
+    }
+    int slave_fd = open(ptsname(master_fd), O_RDWR | O_NOCTTY);
+    int pipe_fds[2];
+    if(slave_fd < 0 || pipe(pipe_fds) != 0){
+        perror("open()");
+        return 1;
+    }
+
+    /* 子プロセスが生モードに入る前に届いた入力がエコーされたり, カノニカルモードの行の長さの上限で切られたりしないよう,
+     * 最初から非カノニカルモードにしておく */
+    struct termios t;
+    tcgetattr(slave_fd, &t);
+    t.c_lflag &= ~(ICANON | ECHO);
+    tcsetattr(slave_fd, TCSANOW, &t);
+
+    pid_t pid = fork();
+    if(pid == 0){
+        close(master_fd);
+        close(pipe_fds[0]);
+        rwhChild(slave_fd, pipe_fds[1], mode, line_num);
+    }
+    close(slave_fd);
+    close(pipe_fds[1]);
+
+    /* 端末にキーボードから打ち込まれたのと同じく, 入力は少しずつ届く */
+    for(long off=0; off<input_len; ){
+        ssize_t n = write(master_fd, &input[off], input_len - off < 256 ? input_len - off : 256);
+        if(n <= 0){
+            break;
+        }
+        off += n;
+    }
+    /* 子プロセスはline_num行を読んだら結果を書いて終わる. マスタはその後で閉じる */
+    int     status;
+    ssize_t n = read(pipe_fds[0], result, sizeof(*result));
+    close(pipe_fds[0]);
+    close(master_fd);
+    if(pid == -1 || waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || n != sizeof(*result)){
+        fprintf(stderr, "error: rwh child failed\n");
+        return 1;
+    }
+    result -> byte_num = input_len;
+    return 0;
+}
+
+static int benchRwh(int char_num, int line_num){
+    /* 1行はchar_num文字, 左矢印3回, 右矢印1回, 1文字, Enter */
+    const char *keys      = "\x1b[D\x1b[D\x1b[D\x1b[Cx\n";
+    long        line_len  = char_num + strlen(keys);
+    long        input_len = line_len * line_num;
+    long        key_num   = (long)(char_num + 6) * line_num;
+    char       *input     = (char *)malloc(input_len);
+    if(char_num < 1 || line_num < 1){
+        fprintf(stderr, "error: char_num and line_num must be >= 1\n");
+        free(input);
+        return 1;
+    }
+    for(int i=0; i<line_num; i++){
+        for(int j=0; j<char_num; j++){
+            input[i*line_len + j] = j % 8 == 7 ? ' ' : 'a' + (i + j) % 26;
+        }
+        memcpy(&input[i*line_len + char_num], keys, strlen(keys));
+    }
+
+    rwh_result_t per_call, session, per_byte;
+    if(benchRwhOne(input, input_len, line_num, 0, &per_call) != 0 ||
+       benchRwhOne(input, input_len, line_num, 1, &session) != 0 ||
+       benchRwhOne(input, input_len, line_num, 2, &per_byte) != 0){
+        free(input);
+        return 1;
+    }
+    free(input);
+
+    if(per_call.line_num != line_num || session.line_num != line_num || per_byte.line_num != line_num){
+        fprintf(stderr, "error: lines are lost (%ld, %ld, %ld / %d)\n", per_call.line_num, session.line_num, per_byte.line_num, line_num);
+        return 1;
+    }
+    printf("mode=rwh\tchar_num=%d\tline_num=%d\tbyte_num=%ld\tcall_syscalls_per_byte=%.4f\tcall_ns_per_byte=%.0f\tsession_syscalls_per_byte=%.4f\tsession_ns_per_byte=%.0f\tper_byte_syscalls_per_byte=%.4f\tper_byte_ns_per_byte=%.0f\tout_bytes_per_key=%.1f\twrites_per_key=%.2f\n",
+            char_num, line_num, input_len,
+            (double)per_call.syscall_num / input_len, per_call.ns / input_len,
+            (double)session.syscall_num / input_len,  session.ns / input_len,
+            (double)per_byte.syscall_num / input_len, per_byte.ns / input_len,
+            (double)session.out_bytes / key_num, (double)session.write_num / key_num);
+    return 0;
+}
+
+static int benchPaste(int mb){
+    /* 改行とタブを含むJSONのような貼り付け. 打ち込む場合は改行とタブを空白にする */
+    long  paste_len = (long)mb * 1024 * 1024;
+    long  typed_len = paste_len < PASTE_TYPED_LEN ? paste_len : PASTE_TYPED_LEN;
+    char *paste     = (char *)malloc(paste_len + 16);
+    char *typed     = (char *)malloc(typed_len + 1);
+    if(mb < 1 || !paste || !typed){
+        fprintf(stderr, "error: mb must be >= 1\n");
+        free(paste);
+        free(typed);
+        return 1;
+    }
+    memcpy(paste, "\x1b[200~", 6);
+    for(long i=0; i<paste_len; i++){
+        const char *json = "{\n\t\"key\": \"value\",\n\t\"n\": 12345\n}\n";
+        paste[6+i] = json[i % strlen(json)];
+    }
+    memcpy(&paste[6+paste_len], "\x1b[201~\n", 7);
+    for(long i=0; i<typed_len; i++){
+        typed[i] = paste[6+i] == '\n' || paste[6+i] == '\t' ? ' ' : paste[6+i];
+    }
+    typed[typed_len] = '\n';
+
+    rwh_result_t pasted, keyed;
+    int ret = benchRwhOne(paste, paste_len + 13, 1, 1, &pasted) != 0 || benchRwhOne(typed, typed_len + 1, 1, 1, &keyed) != 0;
+    free(paste);
+    free(typed);
+    if(ret != 0){
+        return 1;
+    }
+    if(pasted.char_num != paste_len || keyed.char_num != typed_len){
+        fprintf(stderr, "error: pasted text is lost (%ld / %ld, %ld / %ld)\n", pasted.char_num, paste_len, keyed.char_num, typed_len);
+        return 1;
+    }
+    printf("mode=paste\tpaste_bytes=%ld\tpaste_ms=%.1f\tpaste_ns_per_byte=%.1f\tpaste_out_bytes=%ld\tpaste_writes=%ld\ttyped_bytes=%ld\ttyped_ns_per_byte=%.1f\ttyped_out_bytes=%ld\ttyped_writes=%ld\n",
+            paste_len, pasted.ns / 1e6, pasted.ns / paste_len, pasted.out_bytes, pasted.write_num,
+            typed_len, keyed.ns / typed_len, keyed.out_bytes, keyed.write_num);
+    return 0;
+}
+
+static int benchKeymap(int bind_num, int line_num){
+    /* 1行は60文字, 矢印キー, ^A, ^E, Deleteキー, Enter. 入力は一時ファイルから読ませるので端末の設定は変わらない */
+    const char *keys     = "\x1b[D\x1b[D\x01\x05\x1b[C\x1b[3~\x1b[D\n";
+    int         key_num  = 60 + 8;
+    FILE       *in       = tmpfile();
+    int         saved_in = dup(STDIN_FILENO);
+    int         saved_out = dup(STDOUT_FILENO);
+    int         null_fd  = open("/dev/null", O_WRONLY);
+    if(!in || saved_in < 0 || saved_out < 0 || null_fd < 0){
+        perror("tmpfile()");
+        return 1;
+    }
+    for(int i=0; i<line_num; i++){
+        for(int j=0; j<60; j++){
+            fputc(j % 8 == 7 ? ' ' : 'a' + (i + j) % 26, in);
+        }
+        fputs(keys, in);
+    }
+    fflush(in);
+    rewind(in);
+
+    /* 使われない束縛をbind_num個加える. 既定の束縛と同じくESC [ で始まる */
+    const char *cands[] = {"help", "quit"};
+    rwhctx_t   *ctx     = genRwhCtx("$ ", 16, cands, 2);
+    char        seq[32];
+    for(int i=0; i<bind_num; i++){
+        sprintf(seq, "\x1b[%d;%d~", i / 64 + 10, i % 64);
+        bindRwhKey(ctx, seq, RWH_ACTION_TAIL);
+    }
+
+    fflush(stdout);
+    dup2(fileno(in), STDIN_FILENO);
+    dup2(null_fd, STDOUT_FILENO);
+    int    read_num    = 0;
+    long   alloc_begin = alloc_num;
+    double begin       = nowNs();
+    for(char *line; read_num < line_num && (line = rwh(ctx)) != NULL; read_num++);
+    double end         = nowNs();
+    long   alloc_end   = alloc_num;
+    fflush(stdout);
+    dup2(saved_in, STDIN_FILENO);
+    dup2(saved_out, STDOUT_FILENO);
+    close(saved_in);
+    close(saved_out);
+    close(null_fd);
+    fclose(in);
+    freeRwhCtx(ctx);
+
+    if(read_num != line_num){
+        fprintf(stderr, "error: lines are lost (%d / %d)\n", read_num, line_num);
+        return 1;
+    }
+    printf("mode=keymap\tbind_num=%d\tline_num=%d\tns_per_key=%.1f\tallocs_per_key=%.3f\n",
+            bind_num, line_num, (end - begin) / ((double)key_num * line_num), (double)(alloc_end - alloc_begin) / ((double)key_num * line_num));
+    return 0;
+}
+
+int main(int argc, char *argv[]){
+    if(argc == 4 && strcmp(argv[3], "static") == 0){
+        return benchStatic();
+    }
+    if(argc == 4 && strcmp(argv[3], "gen") == 0){
+        return benchGen(atoi(argv[2]));
+    }
+    if(argc == 4 && strcmp(argv[3], "short") == 0){
+        return benchShort();
+    }
+    if(argc == 4 && strcmp(argv[3], "dispatch") == 0){
+        return benchDispatch();
+    }
+    if(argc == 4 && strcmp(argv[3], "repl") == 0){
+        return benchRepl(atoi(argv[2]));
+    }
+    if(argc == 4 && strcmp(argv[3], "iter") == 0){
+        return benchIter(atoi(argv[2]));
+    }
+    if(argc == 4 && strcmp(argv[3], "checker") == 0){
+        return benchChecker();
+    }
+    if(argc == 4 && strcmp(argv[3], "value") == 0){
+        return benchValue(atoi(argv[2]));
+    }
+    if(argc == 4 && strcmp(argv[3], "abbrev") == 0){
+        return benchAbbrev(atoi(argv[1]));
+    }
+    if(argc == 4 && strcmp(argv[3], "command") == 0){
+        return benchCommand();
+    }
+    if(argc == 4 && strcmp(argv[3], "complete") == 0){
+        return benchComplete(atoi(argv[1]));
+    }
+    if(argc == 4 && strcmp(argv[3], "mixed") == 0){
+        return benchMixed(atoi(argv[1]), atoi(argv[2]));
+    }
+    if(argc == 4 && strcmp(argv[3], "suite") == 0){
+        return benchSuite();
+    }
+    if(argc == 4 && strcmp(argv[3], "linebuf") == 0){
+        return benchLineBuf(atoi(argv[2]));
+    }
+    if(argc == 4 && strcmp(argv[3], "keymap") == 0){
+        return benchKeymap(atoi(argv[1]), atoi(argv[2]));
+    }
+    if(argc == 4 && strcmp(argv[3], "paste") == 0){
+        return benchPaste(atoi(argv[2]));
+    }
+    if(argc == 4 && strcmp(argv[3], "rwh") == 0){
+        return benchRwh(atoi(argv[1]), atoi(argv[2]));
+    }
+    if(argc != 3 && argc != 4){
+        fprintf(stderr, "usage: %s <prop_num> <token_num> [copy|view|threads|batch|rsp|static|gen|short|dispatch|repl|iter|checker|value|abbrev|command|complete|defaults|mixed|suite|linebuf|rwh|paste|keymap]\n", argv[0]);
+        return 1;
+    }
+
+    int  prop_num  = atoi(argv[1]);
+    int  token_num = atoi(argv[2]);
+    bool view      = argc == 4 && strcmp(argv[3], "view") == 0;
+    if(prop_num < 1 || token_num < prop_num){
+        fprintf(stderr, "error: token_num must be >= prop_num >= 1\n");
+        return 1;
+    }
+
+    opt_property_db_t   *opt_prop_db     = genOptPropDB(prop_num);
+    opt_group_db_t      *opt_grp_db      = NULL;
+    opt_view_group_db_t *opt_view_grp_db = NULL;
+    char                 short_form[32];
+    char                 long_form[32];
+
+    double reg_begin = nowNs();
+    regOptProp(opt_prop_db, "-p", "--print", 1, INT_MAX, NULL);
+    for(int i=1; i<prop_num; i++){
+        sprintf(short_form, "-o%d", i);
+        sprintf(long_form, "--option-%d", i);
+        regOptProp(opt_prop_db, short_form, long_form, 0, 0, NULL);
+    }
+    double reg_end = nowNs();
+
+    if(argc == 4 && strcmp(argv[3], "rsp") == 0){
+        int ret = benchRsp(opt_prop_db, prop_num, token_num);
+        freeOptPropDB(opt_prop_db);
+        return ret;
+    }
+
+    char **bench_argv = (char **)malloc(sizeof(char *)*(token_num+1));
+    bench_argv[0] = argv[0];
+    for(int i=1; i<prop_num; i++){
+        bench_argv[i] = (char *)malloc(32);
+        sprintf(bench_argv[i], i % 2 ? "-o%d" : "--option-%d", i);
+    }
+    bench_argv[prop_num] = "-p";
+    for(int i=prop_num+1; i<=token_num; i++){
+        bench_argv[i] = (char *)malloc(32);
+        sprintf(bench_argv[i], "content%d", i);
+    }
+
+    if(argc == 4 && strcmp(argv[3], "threads") == 0){
+        int ret = benchThreads(opt_prop_db, prop_num, token_num, bench_argv);
+        freeOptPropDB(opt_prop_db);
+        return ret;
+    }
+    if(argc == 4 && strcmp(argv[3], "batch") == 0){
+        int ret = benchBatch(opt_prop_db, prop_num, token_num, bench_argv);
+        freeOptPropDB(opt_prop_db);
+        return ret;
+    }
+    if(argc == 4 && strcmp(argv[3], "defaults") == 0){
+        int ret = benchDefaults(opt_prop_db, prop_num, token_num, bench_argv);
+        freeOptPropDB(opt_prop_db);
+        return ret;
+    }
+
+    long   alloc_begin = alloc_num;
+    double grp_begin = nowNs();
+    int    ret       = view ? groupingOptView(opt_prop_db, token_num+1, bench_argv, &opt_view_grp_db)
+                            : groupingOpt(opt_prop_db, token_num+1, bench_argv, &opt_grp_db);
+    double grp_end   = nowNs();
+    long   alloc_end = alloc_num;
+
+    if(ret != OPTION_SUCCESS){
+        fprintf(stderr, "error: groupingOpt returns %d\n", ret);
+        return 1;
+    }
+
+    double free_begin = nowNs();
+    if(view){
+        freeOptViewGroupDB(opt_view_grp_db);
+    }
+    else{
+        freeOptGroupDB(opt_grp_db);
+    }
+    double free_end   = nowNs();
+
+    printf("mode=%s\tprop_num=%d\ttoken_num=%d\treg_ns=%.0f\tgrouping_ns=%.0f\tfree_ns=%.0f\tns_per_token=%.1f\tallocs=%ld\n",
+            view ? "view" : "copy", prop_num, token_num,
+            reg_end - reg_begin, grp_end - grp_begin, free_end - free_begin,
+            (grp_end - grp_begin) / token_num, alloc_end - alloc_begin);
+
+    freeOptPropDB(opt_prop_db);
+    return 0;
+}
@@ -0,0 +1,623 @@
+/* このファイルはoptgenが./bench/bench_option.optから生成した. 編集しないこと */
+
+static const opt_property_t bench_option_opt_prop_db_props_[64] = {
+    {"-p", "--print", NULL, 1, INT_MAX, OPT_VALUE_NONE, NULL},
+    {"-o", "--output", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-c", "--compile", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-S", "--assemble", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-E", "--preprocess", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-g", "--debug", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-v", "--verbose", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-q", "--quiet", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-w", "--no-warnings", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-I", "--include-directory", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-L", "--library-directory", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-l", "--library", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-D", "--define-macro", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-U", "--undefine-macro", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-O", "--optimize", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-W", "--warning", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-f", "--feature", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-m", "--machine", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-x", "--language", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-B", "--prefix", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-M", "--dependencies", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-MM", "--user-dependencies", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-MD", "--write-dependencies", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-MMD", "--write-user-dependencies", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-MF", "--dependency-file", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-MT", "--dependency-target", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-MP", "--phony-targets", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-std", "--standard", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-pg", "--profile", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-pipe", "--pipe", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-shared", "--shared", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-static", "--static", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-pie", "--pie", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-no-pie", "--no-pie", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-rdynamic", "--export-dynamic", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-nostdlib", "--no-standard-libraries", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-nostdinc", "--no-standard-includes", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-isystem", "--include-system", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-iquote", "--include-quote", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-include", "--include", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-imacros", "--include-macros", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-T", "--script", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-u", "--undefined", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-z", "--keyword", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-Xlinker", "--linker-option", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-Xassembler", "--assembler-option", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-Xpreprocessor", "--preprocessor-option", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-save-temps", "--save-temps", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-time", "--time", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-wrapper", "--wrapper", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-specs", "--specs", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-h", "--help", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-V", "--version", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-j", "--jobs", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-k", "--keep-going", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-n", "--dry-run", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-s", "--silent", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-t", "--touch", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-C", "--directory", NULL, 1, 1, OPT_VALUE_NONE, NULL},
+    {"-e", "--environment-overrides", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-i", "--ignore-errors", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-r", "--no-builtin-rules", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-R", "--no-builtin-variables", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+    {"-d", "--debug-all", NULL, 0, 0, OPT_VALUE_NONE, NULL},
+};
+
+static int bench_option_opt_prop_db_idx_[256] = {
+    -1, 27, 26, -1, 38, 30, 57, 47, -1, -1, 37, 32, -1, -1, 31, -1,
+    -1, 48, 52, 9, 16, -1, -1, -1, -1, 12, -1, -1, -1, -1, 27, -1,
+    28, 50, -1, 24, 29, 31, 23, 44, 25, -1, 8, -1, 39, 28, -1, -1,
+    -1, -1, 32, -1, -1, -1, 46, 33, 49, -1, -1, -1, -1, -1, 48, -1,
+    -1, -1, 1, 29, 59, 38, 21, -1, -1, 15, 54, 24, 36, 42, 5, -1,
+    -1, 18, -1, -1, -1, -1, 0, -1, -1, -1, -1, -1, 51, -1, 13, 40,
+    -1, -1, -1, -1, 33, -1, -1, -1, 36, -1, -1, -1, -1, -1, -1, -1,
+    55, 22, 34, -1, -1, 4, 40, -1, 61, -1, -1, -1, -1, 7, -1, 6,
+    53, -1, 43, 19, 44, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    10, -1, -1, -1, -1, -1, 45, -1, 22, -1, 20, 34, -1, -1, -1, -1,
+    63, 25, -1, -1, -1, -1, 30, 58, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, 11, -1, -1, -1, -1, 3, 41, -1, -1, -1, -1, 39, -1, -1,
+    -1, -1, -1, 49, 2, -1, -1, 60, -1, -1, -1, -1, 47, -1, -1, -1,
+    23, 50, -1, 35, 35, -1, -1, -1, -1, -1, -1, 46, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, 56, -1, -1, -1, 62, -1, -1, 26, 21, -1,
+    14, 37, -1, -1, -1, -1, -1, -1, -1, -1, -1, 45, 17, -1, -1, -1,
+};
+
+static int
+bench_option_opt_prop_db_match_(
+        const char *str,
+        int         len)
+{
+    switch(len){
+        case 3:
+            if(str[0] != '-'){
+                return -1;
+            }
+            switch(str[1]){
+                case 'M':
+                    switch(str[2]){
+                        case 'D':
+                            return 22;
+                        case 'F':
+                            return 24;
+                        case 'M':
+                            return 21;
+                        case 'P':
+                            return 26;
+                        case 'T':
+                            return 25;
+                    }
+                    return -1;
+                case 'p':
+                    return memcmp(str+2, "g", 1) == 0 ? 28 : -1;
+            }
+            return -1;
+        case 4:
+            if(str[0] != '-'){
+                return -1;
+            }
+            switch(str[1]){
+                case 'M':
+                    return memcmp(str+2, "MD", 2) == 0 ? 23 : -1;
+                case 'p':
+                    return memcmp(str+2, "ie", 2) == 0 ? 32 : -1;
+                case 's':
+                    return memcmp(str+2, "td", 2) == 0 ? 27 : -1;
+            }
+            return -1;
+        case 5:
+            if(str[0] != '-'){
+                return -1;
+            }
+            switch(str[1]){
+                case '-':
+                    return memcmp(str+2, "pie", 3) == 0 ? 32 : -1;
+                case 'p':
+                    return memcmp(str+2, "ipe", 3) == 0 ? 29 : -1;
+                case 't':
+                    return memcmp(str+2, "ime", 3) == 0 ? 48 : -1;
+            }
+            return -1;
+        case 6:
+            if(str[0] != '-'){
+                return -1;
+            }
+            switch(str[1]){
+                case '-':
+                    switch(str[2]){
+                        case 'h':
+                            return memcmp(str+3, "elp", 3) == 0 ? 51 : -1;
+                        case 'j':
+                            return memcmp(str+3, "obs", 3) == 0 ? 53 : -1;
+                        case 'p':
+                            return memcmp(str+3, "ipe", 3) == 0 ? 29 : -1;
+                        case 't':
+                            return memcmp(str+3, "ime", 3) == 0 ? 48 : -1;
+                    }
+                    return -1;
+                case 's':
+                    return memcmp(str+2, "pecs", 4) == 0 ? 50 : -1;
+            }
+            return -1;
+        case 7:
+            if(str[0] != '-'){
+                return -1;
+            }
+            switch(str[1]){
+                case '-':
+                    switch(str[2]){
+                        case 'd':
+                            return memcmp(str+3, "ebug", 4) == 0 ? 5 : -1;
+                        case 'p':
+                            return memcmp(str+3, "rint", 4) == 0 ? 0 : -1;
+                        case 'q':
+                            return memcmp(str+3, "uiet", 4) == 0 ? 7 : -1;
+                        case 's':
+                            return memcmp(str+3, "pecs", 4) == 0 ? 50 : -1;
+                        case 't':
+                            return memcmp(str+3, "ouch", 4) == 0 ? 57 : -1;
+                    }
+                    return -1;
+                case 'i':
+                    return memcmp(str+2, "quote", 5) == 0 ? 38 : -1;
+                case 'n':
+                    return memcmp(str+2, "o-pie", 5) == 0 ? 33 : -1;
+                case 's':
+                    switch(str[2]){
+                        case 'h':
+                            return memcmp(str+3, "ared", 4) == 0 ? 30 : -1;
+                        case 't':
+                            return memcmp(str+3, "atic", 4) == 0 ? 31 : -1;
+                    }
+                    return -1;
+            }
+            return -1;
+        case 8:
+            if(str[0] != '-'){
+                return -1;
+            }
+            switch(str[1]){
+                case '-':
+                    switch(str[2]){
+                        case 'n':
+                            return memcmp(str+3, "o-pie", 5) == 0 ? 33 : -1;
+                        case 'o':
+                            return memcmp(str+3, "utput", 5) == 0 ? 1 : -1;
+                        case 'p':
+                            return memcmp(str+3, "refix", 5) == 0 ? 19 : -1;
+                        case 's':
+                            switch(str[3]){
+                                case 'c':
+                                    return memcmp(str+4, "ript", 4) == 0 ? 41 : -1;
+                                case 'h':
+                                    return memcmp(str+4, "ared", 4) == 0 ? 30 : -1;
+                                case 'i':
+                                    return memcmp(str+4, "lent", 4) == 0 ? 56 : -1;
+                                case 't':
+                                    return memcmp(str+4, "atic", 4) == 0 ? 31 : -1;
+                            }
+                            return -1;
+                    }
+                    return -1;
+                case 'X':
+                    return memcmp(str+2, "linker", 6) == 0 ? 44 : -1;
+                case 'i':
+                    switch(str[2]){
+                        case 'm':
+                            return memcmp(str+3, "acros", 5) == 0 ? 40 : -1;
+                        case 'n':
+                            return memcmp(str+3, "clude", 5) == 0 ? 39 : -1;
+                        case 's':
+                            return memcmp(str+3, "ystem", 5) == 0 ? 37 : -1;
+                    }
+                    return -1;
+                case 'w':
+                    return memcmp(str+2, "rapper", 6) == 0 ? 49 : -1;
+            }
+            return -1;
+        case 9:
+            if(str[0] != '-'){
+                return -1;
+            }
+            switch(str[1]){
+                case '-':
+                    switch(str[2]){
+                        case 'c':
+                            return memcmp(str+3, "ompile", 6) == 0 ? 2 : -1;
+                        case 'd':
+                            return memcmp(str+3, "ry-run", 6) == 0 ? 55 : -1;
+                        case 'f':
+                            return memcmp(str+3, "eature", 6) == 0 ? 16 : -1;
+                        case 'i':
+                            return memcmp(str+3, "nclude", 6) == 0 ? 39 : -1;
+                        case 'k':
+                            return memcmp(str+3, "eyword", 6) == 0 ? 43 : -1;
+                        case 'l':
+                            return memcmp(str+3, "ibrary", 6) == 0 ? 11 : -1;
+                        case 'm':
+                            return memcmp(str+3, "achine", 6) == 0 ? 17 : -1;
+                        case 'p':
+                            return memcmp(str+3, "rofile", 6) == 0 ? 28 : -1;
+                        case 'v':
+                            if(memcmp(str+3, "er", 2) != 0){
+                                return -1;
+                            }
+                            switch(str[5]){
+                                case 'b':
+                                    return memcmp(str+6, "ose", 3) == 0 ? 6 : -1;
+                                case 's':
+                                    return memcmp(str+6, "ion", 3) == 0 ? 52 : -1;
+                            }
+                            return -1;
+                        case 'w':
+                            switch(str[3]){
+                                case 'a':
+                                    return memcmp(str+4, "rning", 5) == 0 ? 15 : -1;
+                                case 'r':
+                                    return memcmp(str+4, "apper", 5) == 0 ? 49 : -1;
+                            }
+                            return -1;
+                    }
+                    return -1;
+                case 'n':
+                    if(memcmp(str+2, "ostd", 4) != 0){
+                        return -1;
+                    }
+                    switch(str[6]){
+                        case 'i':
+                            return memcmp(str+7, "nc", 2) == 0 ? 36 : -1;
+                        case 'l':
+                            return memcmp(str+7, "ib", 2) == 0 ? 35 : -1;
+                    }
+                    return -1;
+                case 'r':
+                    return memcmp(str+2, "dynamic", 7) == 0 ? 34 : -1;
+            }
+            return -1;
+        case 10:
+            if(memcmp(str+0, "--", 2) != 0){
+                return -1;
+            }
+            switch(str[2]){
+                case 'a':
+                    return memcmp(str+3, "ssemble", 7) == 0 ? 3 : -1;
+                case 'l':
+                    return memcmp(str+3, "anguage", 7) == 0 ? 18 : -1;
+                case 'o':
+                    return memcmp(str+3, "ptimize", 7) == 0 ? 14 : -1;
+                case 's':
+                    return memcmp(str+3, "tandard", 7) == 0 ? 27 : -1;
+            }
+            return -1;
+        case 11:
+            if(str[0] != '-'){
+                return -1;
+            }
+            switch(str[1]){
+                case '-':
+                    switch(str[2]){
+                        case 'd':
+                            switch(str[3]){
+                                case 'e':
+                                    return memcmp(str+4, "bug-all", 7) == 0 ? 63 : -1;
+                                case 'i':
+                                    return memcmp(str+4, "rectory", 7) == 0 ? 58 : -1;
+                            }
+                            return -1;
+                        case 'u':
+                            return memcmp(str+3, "ndefined", 8) == 0 ? 42 : -1;
+                    }
+                    return -1;
+                case 'X':
+                    return memcmp(str+2, "assembler", 9) == 0 ? 45 : -1;
+                case 's':
+                    return memcmp(str+2, "ave-temps", 9) == 0 ? 47 : -1;
+            }
+            return -1;
+        case 12:
+            if(memcmp(str+0, "--", 2) != 0){
+                return -1;
+            }
+            switch(str[2]){
+                case 'k':
+                    return memcmp(str+3, "eep-going", 9) == 0 ? 54 : -1;
+                case 'p':
+                    return memcmp(str+3, "reprocess", 9) == 0 ? 4 : -1;
+                case 's':
+                    return memcmp(str+3, "ave-temps", 9) == 0 ? 47 : -1;
+            }
+            return -1;
+        case 13:
+            return memcmp(str+0, "--no-warnings", 13) == 0 ? 8 : -1;
+        case 14:
+            if(str[0] != '-'){
+                return -1;
+            }
+            switch(str[1]){
+                case '-':
+                    if(memcmp(str+2, "de", 2) != 0){
+                        return -1;
+                    }
+                    switch(str[4]){
+                        case 'f':
+                            return memcmp(str+5, "ine-macro", 9) == 0 ? 12 : -1;
+                        case 'p':
+                            return memcmp(str+5, "endencies", 9) == 0 ? 20 : -1;
+                    }
+                    return -1;
+                case 'X':
+                    return memcmp(str+2, "preprocessor", 12) == 0 ? 46 : -1;
+            }
+            return -1;
+        case 15:
+            if(memcmp(str+0, "--", 2) != 0){
+                return -1;
+            }
+            switch(str[2]){
+                case 'i':
+                    switch(str[3]){
+                        case 'g':
+                            return memcmp(str+4, "nore-errors", 11) == 0 ? 60 : -1;
+                        case 'n':
+                            return memcmp(str+4, "clude-quote", 11) == 0 ? 38 : -1;
+                    }
+                    return -1;
+                case 'l':
+                    return memcmp(str+3, "inker-option", 12) == 0 ? 44 : -1;
+                case 'p':
+                    return memcmp(str+3, "hony-targets", 12) == 0 ? 26 : -1;
+            }
+            return -1;
+        case 16:
+            if(memcmp(str+0, "--", 2) != 0){
+                return -1;
+            }
+            switch(str[2]){
+                case 'e':
+                    return memcmp(str+3, "xport-dynamic", 13) == 0 ? 34 : -1;
+                case 'i':
+                    if(memcmp(str+3, "nclude-", 7) != 0){
+                        return -1;
+                    }
+                    switch(str[10]){
+                        case 'm':
+                            return memcmp(str+11, "acros", 5) == 0 ? 40 : -1;
+                        case 's':
+                            return memcmp(str+11, "ystem", 5) == 0 ? 37 : -1;
+                    }
+                    return -1;
+                case 'u':
+                    return memcmp(str+3, "ndefine-macro", 13) == 0 ? 13 : -1;
+            }
+            return -1;
+        case 17:
+            return memcmp(str+0, "--dependency-file", 17) == 0 ? 24 : -1;
+        case 18:
+            if(memcmp(str+0, "--", 2) != 0){
+                return -1;
+            }
+            switch(str[2]){
+                case 'a':
+                    return memcmp(str+3, "ssembler-option", 15) == 0 ? 45 : -1;
+                case 'n':
+                    return memcmp(str+3, "o-builtin-rules", 15) == 0 ? 61 : -1;
+            }
+            return -1;
+        case 19:
+            if(memcmp(str+0, "--", 2) != 0){
+                return -1;
+            }
+            switch(str[2]){
+                case 'd':
+                    return memcmp(str+3, "ependency-target", 16) == 0 ? 25 : -1;
+                case 'i':
+                    return memcmp(str+3, "nclude-directory", 16) == 0 ? 9 : -1;
+                case 'l':
+                    return memcmp(str+3, "ibrary-directory", 16) == 0 ? 10 : -1;
+                case 'u':
+                    return memcmp(str+3, "ser-dependencies", 16) == 0 ? 21 : -1;
+            }
+            return -1;
+        case 20:
+            return memcmp(str+0, "--write-dependencies", 20) == 0 ? 22 : -1;
+        case 21:
+            return memcmp(str+0, "--preprocessor-option", 21) == 0 ? 46 : -1;
+        case 22:
+            if(memcmp(str+0, "--no-", 5) != 0){
+                return -1;
+            }
+            switch(str[5]){
+                case 'b':
+                    return memcmp(str+6, "uiltin-variables", 16) == 0 ? 62 : -1;
+                case 's':
+                    return memcmp(str+6, "tandard-includes", 16) == 0 ? 36 : -1;
+            }
+            return -1;
+        case 23:
+            if(memcmp(str+0, "--", 2) != 0){
+                return -1;
+            }
+            switch(str[2]){
+                case 'e':
+                    return memcmp(str+3, "nvironment-overrides", 20) == 0 ? 59 : -1;
+                case 'n':
+                    return memcmp(str+3, "o-standard-libraries", 20) == 0 ? 35 : -1;
+            }
+            return -1;
+        case 25:
+            return memcmp(str+0, "--write-user-dependencies", 25) == 0 ? 23 : -1;
+    }
+    return -1;
+}
+
+static opt_name_t bench_option_opt_prop_db_names_[128] = {
+    {"--assemble", 3},
+    {"--assembler-option", 45},
+    {"--compile", 2},
+    {"--debug", 5},
+    {"--debug-all", 63},
+    {"--define-macro", 12},
+    {"--dependencies", 20},
+    {"--dependency-file", 24},
+    {"--dependency-target", 25},
+    {"--directory", 58},
+    {"--dry-run", 55},
+    {"--environment-overrides", 59},
+    {"--export-dynamic", 34},
+    {"--feature", 16},
+    {"--help", 51},
+    {"--ignore-errors", 60},
+    {"--include", 39},
+    {"--include-directory", 9},
+    {"--include-macros", 40},
+    {"--include-quote", 38},
+    {"--include-system", 37},
+    {"--jobs", 53},
+    {"--keep-going", 54},
+    {"--keyword", 43},
+    {"--language", 18},
+    {"--library", 11},
+    {"--library-directory", 10},
+    {"--linker-option", 44},
+    {"--machine", 17},
+    {"--no-builtin-rules", 61},
+    {"--no-builtin-variables", 62},
+    {"--no-pie", 33},
+    {"--no-standard-includes", 36},
+    {"--no-standard-libraries", 35},
+    {"--no-warnings", 8},
+    {"--optimize", 14},
+    {"--output", 1},
+    {"--phony-targets", 26},
+    {"--pie", 32},
+    {"--pipe", 29},
+    {"--prefix", 19},
+    {"--preprocess", 4},
+    {"--preprocessor-option", 46},
+    {"--print", 0},
+    {"--profile", 28},
+    {"--quiet", 7},
+    {"--save-temps", 47},
+    {"--script", 41},
+    {"--shared", 30},
+    {"--silent", 56},
+    {"--specs", 50},
+    {"--standard", 27},
+    {"--static", 31},
+    {"--time", 48},
+    {"--touch", 57},
+    {"--undefine-macro", 13},
+    {"--undefined", 42},
+    {"--user-dependencies", 21},
+    {"--verbose", 6},
+    {"--version", 52},
+    {"--warning", 15},
+    {"--wrapper", 49},
+    {"--write-dependencies", 22},
+    {"--write-user-dependencies", 23},
+    {"-B", 19},
+    {"-C", 58},
+    {"-D", 12},
+    {"-E", 4},
+    {"-I", 9},
+    {"-L", 10},
+    {"-M", 20},
+    {"-MD", 22},
+    {"-MF", 24},
+    {"-MM", 21},
+    {"-MMD", 23},
+    {"-MP", 26},
+    {"-MT", 25},
+    {"-O", 14},
+    {"-R", 62},
+    {"-S", 3},
+    {"-T", 41},
+    {"-U", 13},
+    {"-V", 52},
+    {"-W", 15},
+    {"-Xassembler", 45},
+    {"-Xlinker", 44},
+    {"-Xpreprocessor", 46},
+    {"-c", 2},
+    {"-d", 63},
+    {"-e", 59},
+    {"-f", 16},
+    {"-g", 5},
+    {"-h", 51},
+    {"-i", 60},
+    {"-imacros", 40},
+    {"-include", 39},
+    {"-iquote", 38},
+    {"-isystem", 37},
+    {"-j", 53},
+    {"-k", 54},
+    {"-l", 11},
+    {"-m", 17},
+    {"-n", 55},
+    {"-no-pie", 33},
+    {"-nostdinc", 36},
+    {"-nostdlib", 35},
+    {"-o", 1},
+    {"-p", 0},
+    {"-pg", 28},
+    {"-pie", 32},
+    {"-pipe", 29},
+    {"-q", 7},
+    {"-r", 61},
+    {"-rdynamic", 34},
+    {"-s", 56},
+    {"-save-temps", 47},
+    {"-shared", 30},
+    {"-specs", 50},
+    {"-static", 31},
+    {"-std", 27},
+    {"-t", 57},
+    {"-time", 48},
+    {"-u", 42},
+    {"-v", 6},
+    {"-w", 8},
+    {"-wrapper", 49},
+    {"-x", 18},
+    {"-z", 43},
+};
+
+static opt_trie_node_t bench_option_opt_prop_db_trie_[OPT_PROP_TRIE_SIZE(64)];
+
+static opt_property_db_t bench_option_opt_prop_db = {
+    .prop_num  = 64,
+    .reg_num   = 64,
+    .props     = bench_option_opt_prop_db_props_,
+    .idx_size  = 256,
+    .idx       = bench_option_opt_prop_db_idx_,
+    .short_idx = {['B'] = 20, ['C'] = 59, ['D'] = 13, ['E'] = 5, ['I'] = 10, ['L'] = 11, ['M'] = 21, ['O'] = 15, ['R'] = 63, ['S'] = 4, ['T'] = 42, ['U'] = 14, ['V'] = 53, ['W'] = 16, ['c'] = 3, ['d'] = 64, ['e'] = 60, ['f'] = 17, ['g'] = 6, ['h'] = 52, ['i'] = 61, ['j'] = 54, ['k'] = 55, ['l'] = 12, ['m'] = 18, ['n'] = 56, ['o'] = 2, ['p'] = 1, ['q'] = 8, ['r'] = 62, ['s'] = 57, ['t'] = 58, ['u'] = 43, ['v'] = 7, ['w'] = 9, ['x'] = 19, ['z'] = 44, },
+    .idx_state = OPT_IDX_BUILT,
+    .matcher   = bench_option_opt_prop_db_match_,
+    .trie_size = OPT_PROP_TRIE_SIZE(64),
+    .trie      = bench_option_opt_prop_db_trie_,
+    .name_num  = 128,
+    .names     = bench_option_opt_prop_db_names_,
+    .names_state = OPT_IDX_BUILT,
+};
@@ -1,14 +1,3 @@
-int chkOptInteractive(char **contents, int dont_care){
-    const int SUCCESS        = 0;
-    const int ILLIGAL_NUMBER = 1;
-
-    int num = atoi(contents[0]);
-    if(num < 1){
-        return ILLIGAL_NUMBER;
-    }
-    return SUCCESS;
-}
-
 #if DEBUG
 void debugInfo1(int groupingOpt_ret, opt_group_db_t *opt_grp_db){
     printf("#################### debug info 1 ########################\n");
@@ -31,7 +20,9 @@ void debugInfo1(int groupingOpt_ret, opt_group_db_t *opt_grp_db){
         int    content_num = opt_grp_db -> grps[i].content_num;
         char **contents    = opt_grp_db -> grps[i].contents;
         int    err_code    = opt_grp_db -> grps[i].err_code;
+        int    prop_id     = opt_grp_db -> grps[i].prop_id;
         printf("opt_grp_db -> opt_grps[%d].err_code = %d\n", i, err_code);
+        printf("opt_grp_db -> opt_grps[%d].prop_id = %d\n", i, prop_id);
         printf("opt_grp_db -> opt_grps[%d].flag = %s\n", i, flag);
         printf("opt_grp_db -> opt_grps[%d].content_num = %d\n", i, content_num);
         for(int j=0;j<content_num;j++){
@@ -40,4 +31,13 @@ void debugInfo1(int groupingOpt_ret, opt_group_db_t *opt_grp_db){
     }
     printf("#########################################################\n");
 }
+
+void debugInfoStats(const opt_stats_t *stats){
+    printf("#################### debug info stats ####################\n");
+    printf("decode %luns, classify %luns, count check %luns, defaults %luns, fill %luns, checker %luns, total %luns\n",
+            stats->decode_ns, stats->classify_ns, stats->count_check_ns, stats->defaults_ns, stats->fill_ns, stats->checker_ns, stats->total_ns);
+    printf("tokens %lu, groups %lu, allocs %lu (%lu bytes), string comparisons %lu\n",
+            stats->token_num, stats->grp_num, stats->alloc_num, stats->alloc_bytes, stats->str_cmp_num);
+    printf("#########################################################\n");
+}
 #endif
@@ -10,22 +10,52 @@
 void printUsage(void);
 void printVersion(void);
 void interactive(int hist_entory_size);
+int  complete(int word_i, int word_num, char **words);
+
+#define SAMPLE_OPTS(X) \
+    X("-h", "--help",        0,       0, NULL) \
+    X("-v", "--version",     0,       0, NULL) \
+    X("-p", "--print",       1, INT_MAX, NULL) \
+    X("-i", "--interactive", 1,       1, NULL, OPT_VALUE_INT64)
+
+OPT_PROP_DB_DEFINE(opt_prop_db, SAMPLE_OPTS);
+
+/* opt_group_tのprop_id. SAMPLE_OPTSに書いた順に0から振られる */
+enum{
+    SAMPLE_OPT_HELP,
+    SAMPLE_OPT_VERSION,
+    SAMPLE_OPT_PRINT,
+    SAMPLE_OPT_INTERACTIVE,
+};
 
 int main(int argc, char *argv[]){
 
-    opt_property_db_t *opt_prop_db = genOptPropDB(4);
-    opt_group_db_t    *opt_grp_db   = NULL;
-    int                ret;
+    opt_group_db_t *opt_grp_db = NULL;
+    opt_parser_t    parser;
+    int             ret;
+
+    /* --inter のような一意な接頭辞も受け付ける */
+    setOptAbbrev(&opt_prop_db, true);
 
-    regOptProp(opt_prop_db, "-h", "--help",        0,       0, NULL);
-    regOptProp(opt_prop_db, "-v", "--version",     0,       0, NULL);
-    regOptProp(opt_prop_db, "-p", "--print",       1, INT_MAX, NULL);
-    regOptProp(opt_prop_db, "-i", "--interactive", 1,       1, chkOptInteractive);
+    /* シェルの補完から sample --complete $COMP_CWORD "${COMP_WORDS[@]}" のように呼ばれたら候補を返すだけで終わる */
+    if(argc >= 3 && strcmp(argv[1], "--complete") == 0){
+        return complete(atoi(argv[2]), argc - 3, argv + 3);
+    }
 
-    ret = groupingOpt(opt_prop_db, argc, argv, &opt_grp_db);
+    /* SAMPLE_PRINT="a b" のような環境変数と, SAMPLE_CONFIG で指定した設定ファイルを既定値にする. argvが最も優先される */
+    initOptParser(&parser, &opt_prop_db);
+    setOptDefaultSources(&parser, getenv("SAMPLE_CONFIG"), "SAMPLE_");
+#if DEBUG
+    /* デバッグ版のライブラリはOPT_STATSを定義してビルドしているので解析の段階毎の時間が分かる */
+    opt_stats_t stats = {0};
+    setOptStats(&parser, &stats);
+#endif
+    ret = groupingOptWithParser(&parser, argc, argv, &opt_grp_db);
+    freeOptParser(&parser);
 
 #if DEBUG
     debugInfo1(ret, opt_grp_db);
+    debugInfoStats(&stats);
 #endif
 
     switch(ret){
@@ -52,48 +82,67 @@ int main(int argc, char *argv[]){
             fprintf(stderr, "error: too little contents\n");
             exit(1);
 
+        case OPTION_INVALID_VALUE:
+            fprintf(stderr, "error: the history size must be an integer\n");
+            exit(2);
+
+        case OPTION_AMBIGUOUS_OPT:
+            fprintf(stderr, "error: ambiguous option\n");
+            exit(1);
+
+        case OPTION_UNKNOWN_CONFIG_KEY:
+            fprintf(stderr, "error: unknown option in $SAMPLE_CONFIG\n");
+            exit(1);
+
         default:
             fprintf(stderr, "there is a bug! (line: %d)\n", __LINE__);
             exit(100);
     }
 
-    for(int i=0; i<opt_grp_db->grp_num; i++){
-        switch(opt_grp_db->grps[i].err_code){
-            case 0: /* success */
+    for(int i=0;i<opt_grp_db->grp_num;i++){
+        char        **contents    = opt_grp_db -> grps[i].contents;
+        int           content_num = opt_grp_db -> grps[i].content_num;
+        opt_value_t  *values      = opt_grp_db -> grps[i].values;
+
+        switch(opt_grp_db->grps[i].prop_id){
+            case SAMPLE_OPT_HELP:
+                printUsage();
+                break;
+
+            case SAMPLE_OPT_VERSION:
+                printVersion();
                 break;
 
-            case 1: 
-                fprintf(stderr, "error: the history size \"%s\" specified with the option \"%s\" is an invalid value\n", opt_grp_db->grps[i].contents[0], opt_grp_db->grps[i].option);
-                exit(2);
+            case SAMPLE_OPT_PRINT:
+                for(int i=0; i<content_num; i++){
+                    printf("%s\n", contents[i]);
+                }
                 break;
 
-            default:
-                fprintf(stderr, "error: there is a bug! (line: %d)\n", __LINE__);
-                exit(100);
+            case SAMPLE_OPT_INTERACTIVE:
+                /* groupingOptが解釈済みなのでatoiで変換し直す必要は無い */
+                if(values[0].i64 < 1 || values[0].i64 > INT_MAX){
+                    fprintf(stderr, "error: the history size \"%s\" specified with the option \"%s\" is an invalid value\n", contents[0], opt_grp_db->grps[i].option);
+                    exit(2);
+                }
+                interactive((int)values[0].i64);
+                break;
         }
     }
 
-    for(int i=0;i<opt_grp_db->grp_num;i++){
-        char *flag       = opt_grp_db -> grps[i].option;
-        char **contents  = opt_grp_db -> grps[i].contents;
-        int  content_num = opt_grp_db -> grps[i].content_num;
+    return 0;
+}
 
-        if(strcmp(flag, "-h") == 0 || strcmp(flag, "--help") == 0){
-            printUsage();
-        }
-        else if(strcmp(flag, "-v") == 0 || strcmp(flag, "--version") == 0){
-            printVersion();
-        }
-        else if(strcmp(flag, "-p") == 0 || strcmp(flag, "--print") == 0){
-            for(int i=0; i<content_num; i++){
-                printf("%s\n", contents[i]);
-            }
-        }
-        else if(strcmp(flag, "-i") == 0 || strcmp(flag, "--interactive") == 0){
-            interactive(atoi(contents[0]));
-        }
-    }
+int complete(int word_i, int word_num, char **words){
+    const char *cands[64];
+    int         cand_pos;
+    int         cand_num = completeOpt(&opt_prop_db, word_num, words, word_i, &cand_pos, cands, 64);
+    const char *word     = word_i < word_num ? words[word_i] : "";
 
+    /* シェルは単語全体を置き換えるので, --mode=f のような場合は = までを付け直す */
+    for(int i=0; i<cand_num && i<64; i++){
+        printf("%.*s%s\n", cand_pos, word, cands[i]);
+    }
     return 0;
 }
 
@@ -160,7 +209,10 @@ void interactive(int hist_entory_size){
         switch(mode){
             case 1:
                 line = rwh(ctx1);
-                if(strcmp(line, "help") == 0){
+                if(line == NULL){
+                    goto free_and_exit;
+                }
+                else if(strcmp(line, "help") == 0){
                     interactiveHelp1();
                 }
                 else if(strcmp(line, "ctx") == 0){
@@ -182,7 +234,10 @@ void interactive(int hist_entory_size){
 
             case 2:
                 line = rwh(ctx2);
-                if(strcmp(line, "help") == 0){
+                if(line == NULL){
+                    goto free_and_exit;
+                }
+                else if(strcmp(line, "help") == 0){
                     interactiveHelp2();
                 }
                 else if(strcmp(line, "ctx") == 0){
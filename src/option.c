@@ -21,6 +21,101 @@
  * SOFTWARE. */
 
 #include "option.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <errno.h>
+#include <math.h>
+#ifdef OPT_STATS
+#include <time.h>
+#endif
+
+/* ============================================== */
+
+/* setOptStatsの計測. OPT_STATSを定義しなければ全てのマクロが空になり, 計測のコードは残らない */
+#ifdef OPT_STATS
+
+/* 確保と比較は深い関数で起こるのでparserを渡さずにスレッド毎に数え, 解析の前後の差をopt_stats_tに足し込む */
+typedef struct _opt_stats_counter_t{
+    uint64_t alloc_num;
+    uint64_t alloc_bytes;
+    uint64_t str_cmp_num;
+}opt_stats_counter_t;
+
+static _Thread_local opt_stats_counter_t opt_stats_counter;
+
+static uint64_t
+nowOptStatsNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+#define OPT_STATS_COUNT_ALLOC(size) (opt_stats_counter.alloc_num++, opt_stats_counter.alloc_bytes += (size))
+#define OPT_STATS_COUNT_CMP()       (opt_stats_counter.str_cmp_num++)
+#define OPT_STATS_BEGIN(stats, t)   uint64_t t = (stats) ? nowOptStatsNs() : 0
+#define OPT_STATS_END(stats, t, field) \
+    do{ \
+        if(stats){ \
+            (stats) -> field += nowOptStatsNs() - (t); \
+        } \
+    }while(0)
+/* contents_checkerは複数のスレッドから呼ばれるので, オプション毎の時間は不可分に足し込む */
+#define OPT_STATS_END_CHECKER(stats, t, prop_id) \
+    do{ \
+        if((stats) && (stats)->prop_checker_ns){ \
+            __atomic_fetch_add(&((stats) -> prop_checker_ns[prop_id]), nowOptStatsNs() - (t), __ATOMIC_RELAXED); \
+        } \
+    }while(0)
+#define OPT_STATS_PARSE_BEGIN(stats, t, counter) \
+    OPT_STATS_BEGIN(stats, t); \
+    opt_stats_counter_t counter = opt_stats_counter
+#define OPT_STATS_PARSE_END(stats, t, counter, ret, tok_num, grp_num) \
+    do{ \
+        if(stats){ \
+            addOptParseStats(stats, t, &(counter), ret, tok_num, grp_num); \
+        } \
+    }while(0)
+
+static void
+addOptParseStats( /* 1回の解析の全体の時間と数をstatsに足し込む */
+        opt_stats_t               *stats,
+        uint64_t                   begin,   /* 解析を始めた時刻 */
+        const opt_stats_counter_t *counter, /* [in] 解析を始める前のopt_stats_counter */
+        int                        ret,     /* 解析の戻り値 */
+        int                        tok_num,
+        int                        grp_num)
+{
+    stats -> total_ns    += nowOptStatsNs() - begin;
+    stats -> parse_num   += 1;
+    stats -> failed_num  += ret != OPTION_SUCCESS;
+    stats -> token_num   += tok_num;
+    stats -> grp_num     += grp_num;
+    stats -> alloc_num   += opt_stats_counter.alloc_num   - counter->alloc_num;
+    stats -> alloc_bytes += opt_stats_counter.alloc_bytes - counter->alloc_bytes;
+    stats -> str_cmp_num += opt_stats_counter.str_cmp_num - counter->str_cmp_num;
+}
+
+#else
+
+#define OPT_STATS_COUNT_ALLOC(size)    ((void)0)
+#define OPT_STATS_COUNT_CMP()          ((void)0)
+#define OPT_STATS_BEGIN(stats, t)
+#define OPT_STATS_END(stats, t, field) ((void)0)
+#define OPT_STATS_END_CHECKER(stats, t, prop_id) ((void)0)
+#define OPT_STATS_PARSE_BEGIN(stats, t, counter)
+#define OPT_STATS_PARSE_END(stats, t, counter, ret, tok_num, grp_num) ((void)0)
+
+#endif
+
+/* ============================================== */
 
 static int 
 alwaysReturnTrue(
@@ -30,6 +125,114 @@ alwaysReturnTrue(
     return 0;
 }
 
+static unsigned int /* FNV-1a */
+hashOptName(
+        const char *str,
+        int         len)
+{
+    unsigned int hash = 2166136261u;
+    for(int i=0; i<len; i++){
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool
+equalsOptName( /* formとstrの先頭len文字が一致するか */
+        const char *form,
+        const char *str,
+        int         len)
+{
+    if(!form){
+        return false;
+    }
+    OPT_STATS_COUNT_CMP();
+    return strncmp(form, str, len) == 0 && form[len] == '\0';
+}
+
+static int /* strに対応するopt_property_tのpropsにおける添字. 見つからなければ-1 */
+lookupOptProp(
+        const opt_property_db_t *db,
+        const char              *str,
+        int                      len)
+{
+    if(len == 2 && str[0] == '-'){
+        return db->short_idx[(unsigned char)str[1]] - 1;
+    }
+    if(db->matcher){
+        return db->matcher(str, len);
+    }
+
+    unsigned int mask = db->idx_size - 1;
+
+    for(unsigned int slot = hashOptName(str, len) & mask; db->idx[slot] != -1; slot = (slot+1) & mask){
+        const opt_property_t *prop = &(db -> props[db->idx[slot]]);
+        if(equalsOptName(prop->short_form, str, len) || equalsOptName(prop->long_form, str, len)){
+            return db->idx[slot];
+        }
+    }
+    return -1;
+}
+
+static void
+insertOptIdx(
+        opt_property_db_t *db,
+        const char        *form,
+        int                prop_i)
+{
+    int len = strlen(form);
+
+    if(len == 2 && form[0] == '-'){
+        if(db->short_idx[(unsigned char)form[1]] == 0){
+            db -> short_idx[(unsigned char)form[1]] = prop_i + 1;
+        }
+        return; /* '-'と1文字からなる名前はshort_idxだけで引く */
+    }
+
+    unsigned int mask = db->idx_size - 1;
+    unsigned int slot = hashOptName(form, len) & mask;
+
+    while(db->idx[slot] != -1){
+        const opt_property_t *prop = &(db -> props[db->idx[slot]]);
+        if(equalsOptName(prop->short_form, form, len) || equalsOptName(prop->long_form, form, len)){
+            return; /* 同じ名前のオプションは先に登録されたものを優先する */
+        }
+        slot = (slot+1) & mask;
+    }
+    db -> idx[slot] = prop_i;
+}
+
+static void
+ensureOptIdx( /* OPT_PROP_DB_DEFINEで定義されたopt_property_db_tのidxを最初の1回だけ構築する. 複数のスレッドから同時に呼ばれてもよい */
+        const opt_property_db_t *opt_prop_db)
+{
+    /* 静的なopt_property_db_tでもpropsだけが.rodataに置かれ, idxとidx_stateは書き換えられる領域に置かれている */
+    opt_property_db_t *db    = (opt_property_db_t *)opt_prop_db;
+    int                state = OPT_IDX_EMPTY;
+
+    if(atomic_load_explicit(&db->idx_state, memory_order_acquire) == OPT_IDX_BUILT){
+        return;
+    }
+
+    if(atomic_compare_exchange_strong_explicit(&db->idx_state, &state, OPT_IDX_BUILDING, memory_order_acq_rel, memory_order_acquire)){
+        memset(db->idx, 0xff, sizeof(int)*db->idx_size); /* 全て-1にする */
+        memset(db->short_idx, 0, sizeof(db->short_idx));
+        for(int i=0; i<db->reg_num; i++){
+            insertOptIdx(db, db->props[i].short_form, i);
+            if(db->props[i].long_form){
+                insertOptIdx(db, db->props[i].long_form, i);
+            }
+        }
+        atomic_store_explicit(&db->idx_state, OPT_IDX_BUILT, memory_order_release);
+        return;
+    }
+
+    while(atomic_load_explicit(&db->idx_state, memory_order_acquire) != OPT_IDX_BUILT){
+        sched_yield();
+    }
+}
+
 opt_property_db_t
 *genOptPropDB(
         int prop_num)
@@ -44,19 +247,64 @@ opt_property_db_t
         return NULL;
     }
 
-    opt_prop_db -> prop_num = prop_num;
+    opt_property_t *props;
+
+    opt_prop_db -> prop_num           = prop_num;
+    opt_prop_db -> reg_num            = 0;
+    opt_prop_db -> matcher            = NULL;
+    opt_prop_db -> checker_thread_num = 1;
+    opt_prop_db -> checker_memo       = NULL;
+    opt_prop_db -> abbrev             = false;
+    opt_prop_db -> trie_size          = OPT_PROP_TRIE_SIZE(prop_num);
+    opt_prop_db -> trie_num           = 0;
+    opt_prop_db -> name_num           = 0;
+    atomic_init(&(opt_prop_db -> idx_state), OPT_IDX_BUILT); /* regOptPropで1つずつ登録するので構築済みとみなす */
+    atomic_init(&(opt_prop_db -> trie_state), OPT_IDX_EMPTY);
+    atomic_init(&(opt_prop_db -> names_state), OPT_IDX_EMPTY);
+
+    if(!(opt_prop_db->props = props = (opt_property_t *)calloc(prop_num, sizeof(opt_property_t)))){
+        free(opt_prop_db);
+        opt_prop_db = NULL;
+        return NULL;
+    }
+
+    /* short_formとlong_formの2つのキーを登録しても負荷率が1/2以下になるようにする */
+    opt_prop_db -> idx_size = 4;
+    while(opt_prop_db->idx_size < prop_num*4){
+        opt_prop_db -> idx_size <<= 1;
+    }
+    if(!(opt_prop_db->idx = (int *)malloc(sizeof(int)*opt_prop_db->idx_size))){
+        free(props);
+        free(opt_prop_db);
+        opt_prop_db = NULL;
+        return NULL;
+    }
+    memset(opt_prop_db->idx, 0xff, sizeof(int)*opt_prop_db->idx_size); /* 全て-1にする */
+    memset(opt_prop_db->short_idx, 0, sizeof(opt_prop_db->short_idx));
+
+    if(!(opt_prop_db->trie = (opt_trie_node_t *)malloc(sizeof(opt_trie_node_t)*opt_prop_db->trie_size))){
+        free(opt_prop_db->idx);
+        free(props);
+        free(opt_prop_db);
+        opt_prop_db = NULL;
+        return NULL;
+    }
 
-    if(!(opt_prop_db->props = (opt_property_t *)calloc(prop_num, sizeof(opt_property_t)))){
+    if(!(opt_prop_db->names = (opt_name_t *)malloc(sizeof(opt_name_t)*OPT_PROP_NAMES_SIZE(prop_num)))){
+        free(opt_prop_db->trie);
+        free(opt_prop_db->idx);
+        free(props);
         free(opt_prop_db);
         opt_prop_db = NULL;
         return NULL;
     }
 
     for(int i=0; i<prop_num; i++){
-        opt_prop_db -> props[i].short_form       = NULL;
-        opt_prop_db -> props[i].long_form        = NULL;
-        opt_prop_db -> props[i].contents_checker = alwaysReturnTrue;
-        opt_prop_db -> props[i].appeared_yet     = 0;
+        props[i].short_form       = NULL;
+        props[i].long_form        = NULL;
+        props[i].contents_checker = alwaysReturnTrue;
+        props[i].value_type       = OPT_VALUE_NONE;
+        props[i].enum_names       = NULL;
     }
 
     return opt_prop_db;
@@ -71,8 +319,31 @@ regOptProp(
         int             content_num_max,
         int             (*contents_checker)(char **contents, int content_num))
 {
-    static int idx = 0;
-    opt_property_t *opt_prop = &(db -> props[idx]);
+    return regOptPropTyped(db, short_form, long_form, content_num_min, content_num_max, contents_checker, OPT_VALUE_NONE, NULL);
+}
+
+int
+regOptPropTyped(
+        opt_property_db_t  *db,
+        char               *short_form,
+        char               *long_form,
+        int                 content_num_min,
+        int                 content_num_max,
+        int               (*contents_checker)(char **contents, int content_num),
+        int                 value_type,
+        const char *const  *enum_names)
+{
+    if(!db){
+        return OPTION_OPT_PROP_DB_IS_NULL;
+    }
+
+    if(db->reg_num >= db->prop_num){
+        return OPTION_OPT_PROP_DB_IS_FULL;
+    }
+
+    /* genOptPropDBで確保したpropsなので書き換えてよい */
+    int             idx      = db -> reg_num;
+    opt_property_t *opt_prop = (opt_property_t *)&(db -> props[idx]);
 
     if(short_form == NULL){
         return OPTION_OPT_NAME_IS_NULL;
@@ -82,26 +353,37 @@ regOptProp(
         return OPTION_MIN_BIGGER_THAN_MAX;
     }
 
-    if(!(opt_prop->short_form = (char *)malloc(strlen(short_form)))){
+    if(!(opt_prop->short_form = (char *)malloc(sizeof(char)*(strlen(short_form)+1)))){
         return OPTION_OUT_OF_MEMORY;
     }
     strcpy(opt_prop->short_form, short_form);
 
-    if(long_form && !(opt_prop->long_form = (char *)malloc(sizeof(char)*strlen(long_form)))){
-        free(opt_prop->short_form);
-        opt_prop->short_form = NULL;
-        return OPTION_OUT_OF_MEMORY;
+    if(long_form){
+        if(!(opt_prop->long_form = (char *)malloc(sizeof(char)*(strlen(long_form)+1)))){
+            free(opt_prop->short_form);
+            opt_prop->short_form = NULL;
+            return OPTION_OUT_OF_MEMORY;
+        }
+        strcpy(opt_prop->long_form, long_form);
+    }
+
+    insertOptIdx(db, opt_prop->short_form, idx);
+    if(opt_prop->long_form){
+        insertOptIdx(db, opt_prop->long_form, idx);
     }
-    strcpy(opt_prop->long_form, long_form);
-    
+
     if(contents_checker){
         opt_prop->contents_checker = contents_checker;
     }
 
-    opt_prop->appeared_yet = 0;
     opt_prop->content_num_min = content_num_min;
     opt_prop->content_num_max = content_num_max;
-    idx++;
+    opt_prop->value_type      = value_type;
+    opt_prop->enum_names      = enum_names;
+    db -> reg_num++;
+    /* 基数木は次の解析で, 名前の索引は次の補完で作り直す */
+    atomic_store_explicit(&db->trie_state, OPT_IDX_EMPTY, memory_order_release);
+    atomic_store_explicit(&db->names_state, OPT_IDX_EMPTY, memory_order_release);
 
     return OPTION_SUCCESS;
 }
@@ -120,206 +402,287 @@ void
 freeOptPropDB(
         opt_property_db_t *db)
 {
+    opt_property_t *props = (opt_property_t *)db -> props;
+
     for(int i=0; i < db->prop_num; i++){
-        freeOptProp(&(db->props[i]));
+        freeOptProp(&props[i]);
     }
+    free(props);
+    free(db -> idx);
+    free(db -> trie);
+    free(db -> names);
     free(db);
     db = NULL;
 }
 
 /* ============================================== */
 
-static void
-initOptGroupDB(
-        opt_group_db_t *opt_grp_db)
+#define OPT_ABBREV_AMBIGUOUS (-2) /* matchOptAbbrevの戻り値. 複数のオプションに一致した */
+
+static int /* 追加した節の添字 */
+newTrieNode(
+        opt_property_db_t *db,
+        const char        *label,
+        int                label_len,
+        int                prop)
 {
-    opt_grp_db -> grp_num      = 0;
-    opt_grp_db -> grps         = NULL;
-    opt_grp_db -> optless_num  = 0;
-    opt_grp_db -> optless      = NULL;
+    opt_trie_node_t *node = &(db -> trie[db->trie_num]);
+
+    node -> label     = label;
+    node -> label_len = label_len;
+    node -> child     = -1;
+    node -> sibling   = -1;
+    node -> prop      = prop;
+    node -> only      = prop;
+    return db->trie_num++;
 }
 
-static void
-initOptGroup(
-        opt_group_t *grp)
+static int* /* 親nodeの子のリストのうち, 最初の文字がcの子を指す添字の格納先. 無ければcを挿入すべき位置 */
+findTrieChild( /* 子のリストは最初の文字の昇順に並べてあるので, 候補を辿ると辞書順になる */
+        opt_trie_node_t *trie,
+        int              node,
+        unsigned char    c)
 {
-    grp -> option      = NULL;
-    grp -> content_num = 0;
-    grp -> contents    = NULL;
-    grp -> err_code    = 0;
+    int *link = &(trie[node].child);
+    while(*link != -1 && (unsigned char)trie[*link].label[0] < c){
+        link = &(trie[*link].sibling);
+    }
+    return link;
 }
 
-static int /* 0:success, 1: out of memory */
-decodeOptions(
+static void
+insertOptTrie( /* long_formを基数木に追加する. 同じ名前は先に登録されたオプションを優先する */
         opt_property_db_t *db,
-        int               org_argc,
-        char            **org_argv,
-        int              *new_argc,
-        char           ***new_argv)
-{
-    const int SUCCESS            = 0;
-    const int OUT_OF_MEMORY      = 1;
-
-    int ret     = SUCCESS;
-    *new_argc   = 0;
-    (*new_argv) = NULL;
-
-    for(int org_argv_i=1; org_argv_i<org_argc; org_argv_i++){
-        char *copy_src            = org_argv[org_argv_i];
-        char *last_null_ptr       = &copy_src[strlen(copy_src)];
-        int   a_part_of_condition = 0;
-        char  delim               = '\0';
-
-        for(int db_i = 0; db_i<db->prop_num; db_i++){
-            char *memo = strchr(copy_src, '=');
-            if(memo){
-                if(strcmp(db->props[db_i].long_form, strtok(copy_src, "=")) == 0){
-                    a_part_of_condition = 1;
-                    delim = '=';
-                    break;
-                }
-                else{
-                    *memo = '='; /* 分割した文字列をもとに戻す */
-                }
-            }
+        const char        *form,
+        int                prop_i)
+{
+    opt_trie_node_t *trie = db -> trie;
+    int              len  = strlen(form);
+    int              node = 0;
+    int              pos  = 0;
+
+    while(pos < len){
+        int *link = findTrieChild(trie, node, form[pos]);
+        int  c    = *link;
+
+        if(c == -1 || trie[c].label[0] != form[pos]){
+            int leaf = newTrieNode(db, form + pos, len - pos, prop_i);
+            trie[leaf].sibling = c;
+            *link              = leaf;
+            break;
         }
 
-        do{
-            (*new_argc)++;
-            if(!((*new_argv) = (char **)reallocarray(*new_argv, (*new_argc), sizeof(char *)))){
-                ret = OUT_OF_MEMORY;
-                goto free_and_exit;
-            }
-            if(!((*new_argv)[*new_argc-1] = (char *)malloc(sizeof(char)*(strlen(copy_src)+1)))){
-                ret = OUT_OF_MEMORY;
-                goto free_and_exit;
-            }
-            if(delim != '\0'){
-                (*new_argv)[*new_argc-1][0] = '\n'; // あまり良いやり方ではないかもしれないが、この情報はjudgeDestinationで必要になる
-                strcpy(&((*new_argv)[*new_argc-1][1]), copy_src);
-            }
-            else{
-                strcpy((*new_argv)[*new_argc-1], copy_src);
-            }
-            if(&copy_src[strlen(copy_src)] != last_null_ptr){
-                copy_src[strlen(copy_src)] = delim; /* 分割した文字列をもとに戻す */
-            }
-        }while(a_part_of_condition && 
-                (((copy_src = strtok(NULL, ",")) && (delim = ',')) ||
-                 ((delim = '\0') && (a_part_of_condition = 0))));
+        int common = 1;
+        while(common < trie[c].label_len && pos + common < len && trie[c].label[common] == form[pos+common]){
+            common++;
+        }
+        if(common < trie[c].label_len){
+            /* 辺の途中で分かれるので, 共通部分を新しい節にして元の節をその子にする */
+            int mid = newTrieNode(db, trie[c].label, common, -1);
+            trie[mid].only    = trie[c].only;
+            trie[mid].child   = c;
+            trie[mid].sibling = trie[c].sibling;
+            trie[c].label    += common;
+            trie[c].label_len -= common;
+            trie[c].sibling   = -1;
+            *link             = mid;
+            c                 = mid;
+        }
+        node = c;
+        pos += common;
+    }
+    if(pos == len){
+        if(trie[node].prop != -1){
+            return;
+        }
+        trie[node].prop = prop_i;
     }
 
-    return SUCCESS;
-
-free_and_exit:
-    for(int i=0; i<*new_argc; i++){
-        free((*new_argv)[i]);
-        (*new_argv)[i] = NULL;
+    /* 追加した名前の経路にある節のonlyを更新する */
+    for(node=0, pos=0; pos < len; pos += trie[node].label_len){
+        node = *findTrieChild(trie, node, form[pos]);
+        if(trie[node].only != prop_i){
+            trie[node].only = -1;
+        }
     }
-    free(*new_argv);
-    *new_argv = NULL;
-    return ret;
 }
 
-static int
-add2optGrpDB_contents(
-        opt_group_db_t *opt_grp_db,
-        char *str)
+static void
+ensureOptTrie( /* long_formの基数木を最初の1回だけ構築する. 複数のスレッドから同時に呼ばれてもよい */
+        const opt_property_db_t *opt_prop_db)
 {
-    const int SUCCESS       = 0;
-    const int OUT_OF_MEMORY = 1;
+    /* 静的なopt_property_db_tでもtrieとtrie_stateは書き換えられる領域に置かれている */
+    opt_property_db_t *db    = (opt_property_db_t *)opt_prop_db;
+    int                state = OPT_IDX_EMPTY;
 
-    opt_grp_db -> optless_num += 1;
-    if(!(opt_grp_db -> optless = (char **)reallocarray(opt_grp_db->optless, opt_grp_db->optless_num, sizeof(char *)))){
-        return OUT_OF_MEMORY;
+    if(atomic_load_explicit(&db->trie_state, memory_order_acquire) == OPT_IDX_BUILT){
+        return;
+    }
+
+    if(atomic_compare_exchange_strong_explicit(&db->trie_state, &state, OPT_IDX_BUILDING, memory_order_acq_rel, memory_order_acquire)){
+        db -> trie_num = 0;
+        newTrieNode(db, "", 0, -1);
+        for(int i=0; i<db->reg_num; i++){
+            if(db->props[i].long_form){
+                insertOptTrie(db, db->props[i].long_form, i);
+            }
+        }
+        atomic_store_explicit(&db->trie_state, OPT_IDX_BUILT, memory_order_release);
+        return;
+    }
+
+    while(atomic_load_explicit(&db->trie_state, memory_order_acquire) != OPT_IDX_BUILT){
+        sched_yield();
     }
-    opt_grp_db -> optless[opt_grp_db->optless_num-1] = str;
-    return SUCCESS;
 }
 
-static int
-add2optGrpDB_OptGrps_Option(
-        opt_group_db_t *opt_grp_db,
-        char       *str)     
+static int /* strの先頭len文字で終わる節か, その文字を含む辺の先の節. 一致する名前が無ければ-1 */
+walkOptTrie( /* 文字列の比較は辺毎に1回で, 節の数によらずO(len)で辿る */
+        const opt_property_db_t *db,
+        const char              *str,
+        int                      len,
+        bool                    *exact) /* [out] strが節でちょうど終わったか */
 {
-    const int SUCCESS       = 0;
-    const int OUT_OF_MEMORY = 1;
+    const opt_trie_node_t *trie = db -> trie;
+    int                    node = 0;
+    int                    pos  = 0;
+
+    *exact = true;
+    while(pos < len){
+        node = *findTrieChild((opt_trie_node_t *)trie, node, str[pos]);
+        if(node == -1 || trie[node].label[0] != str[pos]){
+            return -1;
+        }
 
-    opt_grp_db -> grp_num += 1;
-    if(!(opt_grp_db -> grps = (opt_group_t*)reallocarray(opt_grp_db->grps, opt_grp_db->grp_num, sizeof(opt_group_t)))){
-        return OUT_OF_MEMORY;
+        int n = trie[node].label_len < len - pos ? trie[node].label_len : len - pos;
+        OPT_STATS_COUNT_CMP();
+        if(memcmp(trie[node].label, str + pos, n) != 0){
+            return -1;
+        }
+        *exact = n == trie[node].label_len;
+        pos   += n;
     }
-    initOptGroup(&(opt_grp_db -> grps[opt_grp_db->grp_num-1]));
-    opt_grp_db -> grps[opt_grp_db->grp_num-1].option = str;
-    return SUCCESS;
+    return node;
 }
 
-static int
-add2optGrpDB_OptGrps_Contents(
-        opt_group_db_t *opt_grp_db,
-        char       *str)     
+static int /* strを接頭辞に持つ唯一のオプションのpropsの添字. 無ければ-1, 複数あればOPT_ABBREV_AMBIGUOUS */
+matchOptAbbrev(
+        const opt_property_db_t *db,
+        const char              *str,
+        int                      len)
 {
-    const int SUCCESS       = 0;
-    const int OUT_OF_MEMORY = 1;
+    bool exact;
+    int  node;
 
-    opt_group_t *current_grp  = &(opt_grp_db -> grps[opt_grp_db->grp_num - 1]);
-    current_grp -> content_num++;
-    if(!(current_grp->contents = (char **)reallocarray(current_grp->contents, current_grp->content_num, sizeof(char *)))){
-        return OUT_OF_MEMORY;
+    ensureOptTrie(db);
+    if((node = walkOptTrie(db, str, len, &exact)) == -1){
+        return -1;
     }
-    current_grp->contents[current_grp->content_num-1] = str;
-    return SUCCESS;
+    /* --in と --input のように完全に一致する名前は他の名前の接頭辞でもそれを選ぶ */
+    if(exact && db->trie[node].prop != -1){
+        return db->trie[node].prop;
+    }
+    return db->trie[node].only != -1 ? db->trie[node].only : OPT_ABBREV_AMBIGUOUS;
 }
 
-static void
-adaptContentsChecker(
-        opt_property_db_t *opt_prop_db,
-        opt_group_db_t    *opt_grp_db)
+static int /* nodeの部分木にあるlong_formの数 */
+collectOptTrie( /* nodeの部分木にあるlong_formのpropsの添字を辞書順にpropsに格納する */
+        const opt_trie_node_t *trie,
+        int                    node,
+        int                   *props,
+        int                    prop_max,
+        int                    prop_num) /* 格納済みの数 */
 {
-    for(int i=0; i<opt_grp_db->grp_num; i++){
-        opt_group_t *grp = &(opt_grp_db -> grps[i]);
-        for(int j=0; j<opt_prop_db->prop_num; j++){
-            opt_property_t *prop = &(opt_prop_db -> props[j]);
-            if(strcmp(prop->short_form, grp->option) == 0 || strcmp(prop->long_form, grp->option) == 0){
-                grp->err_code = prop->contents_checker(grp->contents, grp->content_num);
-                break;
-            }
+    if(trie[node].prop != -1){
+        if(prop_num < prop_max){
+            props[prop_num] = trie[node].prop;
         }
+        prop_num++;
+    }
+    for(int c = trie[node].child; c != -1; c = trie[c].sibling){
+        prop_num = collectOptTrie(trie, c, props, prop_max, prop_num);
     }
+    return prop_num;
 }
 
-static int
-checkContentsNum(
-        opt_property_db_t *opt_prop_db,
-        opt_group_db_t    *opt_grp_db)
+void
+setOptAbbrev(
+        opt_property_db_t *db,
+        bool               enable)
 {
-    /* return values */
-    const int SUCCESS = 0;
-    const int TOO_MANY_CONTENTS    = 1;
-    const int TOO_LITTLE_CONTENTS  = 2;
+    db -> abbrev = enable;
+}
 
-    for(int i=0; i<opt_grp_db->grp_num; i++){
-        char *option = opt_grp_db -> grps[i].option;
+int
+getOptAmbiguousCandidates(
+        const opt_parser_t *parser,
+        opt_view_t         *tok,
+        int                *props,
+        int                 prop_max)
+{
+    bool exact;
+    int  node;
 
-        opt_property_t *props = opt_prop_db -> props;
-        while(strcmp(props->short_form, option) != 0 && strcmp(props->long_form, option) != 0){
-            props++;
-        }
+    *tok = parser -> ambiguous;
+    if(!parser->ambiguous.str || (node = walkOptTrie(parser->db, tok->str, tok->len, &exact)) == -1){
+        return 0;
+    }
+    return collectOptTrie(parser->db->trie, node, props, prop_max, 0);
+}
+
+/* ============================================== */
 
-        int num = opt_grp_db -> grps[i].content_num;
-        int min = props -> content_num_min;
-        int max = props -> content_num_max;
+#define OPT_ARENA_CHUNK_SIZE (64*1024) /* アリーナのチャンクの既定のサイズ */
 
-        if(num < min){
-            return TOO_LITTLE_CONTENTS;
-        }
+struct _opt_arena_chunk_t{
+    opt_arena_chunk_t *next; /* 前に確保したチャンク */
+    size_t             size; /* dataのサイズ */
+    size_t             used; /* dataの使用済みのサイズ */
+    max_align_t        data[];
+};
 
-        if(num > max){
-            return TOO_MANY_CONTENTS;
+static void* /* 確保した領域. 失敗したらNULL */
+allocFromArenaAligned( /* 先頭のチャンクから切り出し, 足りなければ新しいチャンクを繋ぐ */
+        opt_arena_chunk_t **head,  /* [mod] チャンクの連結リストの先頭 */
+        size_t              size,
+        size_t              align) /* sizeをこの倍数に切り上げる. 文字列なら1 */
+{
+    size = (size + align - 1) / align * align;
+    if(!*head || (*head)->size - (*head)->used < size){
+        size_t             chunk_size = size > OPT_ARENA_CHUNK_SIZE ? size : OPT_ARENA_CHUNK_SIZE;
+        opt_arena_chunk_t *chunk      = (opt_arena_chunk_t *)malloc(sizeof(opt_arena_chunk_t) + chunk_size);
+        if(!chunk){
+            return NULL;
         }
+        OPT_STATS_COUNT_ALLOC(sizeof(opt_arena_chunk_t) + chunk_size);
+        chunk -> next = *head;
+        chunk -> size = chunk_size;
+        chunk -> used = 0;
+        *head = chunk;
     }
 
-    return SUCCESS;
+    void *mem = (char *)(*head)->data + (*head)->used;
+    (*head) -> used += size;
+    return mem;
+}
+
+static void*
+allocFromArena( /* buildOptGroupDBの確保関数 */
+        void   *ctx,  /* [mod] opt_arena_chunk_t *へのポインタ */
+        size_t  size)
+{
+    return allocFromArenaAligned((opt_arena_chunk_t **)ctx, size, sizeof(max_align_t));
+}
+
+static void
+freeArena(
+        opt_arena_chunk_t *head)
+{
+    while(head){
+        opt_arena_chunk_t *next = head -> next;
+        free(head);
+        head = next;
+    }
 }
 
 typedef enum{
@@ -331,183 +694,3129 @@ typedef enum{
     JD_TOO_LITTLE_CONTENTS   = -3,
 }judgeDestination_errcode_t;
 
-static int
-judgeDestination(
-        opt_property_db_t *opt_prop_db,
-        char **str)
+static int /* 0:success, 1: out of memory */
+reserveArray( /* 配列の容量がneed以上になるまで倍々に拡張する. 要素を1つずつ追加しても再確保は償却O(1)回になる */
+        void  **array,     /* [mod] 拡張する配列 */
+        int    *capacity,  /* [mod] arrayの容量 */
+        int     need,      /* 必要な要素数 */
+        size_t  elem_size) /* 要素のサイズ */
 {
-    /* flags */
-    static bool opt_grp_dbs_contents_is_empty   = 1;
-    static bool lock_opt_grp_dbs_contents       = 0;
-
-    /* memos */
-    static int current_options_contents_num     = 0;
-    static int current_options_contents_num_max = 0;
-    static int current_options_contents_num_min = 0;
+    const int SUCCESS       = 0;
+    const int OUT_OF_MEMORY = 1;
 
-    for(int i=0; i<opt_prop_db->prop_num; i++){
-        if(strcmp(opt_prop_db->props[i].short_form, *str) == 0 || strcmp(opt_prop_db->props[i].long_form, *str) == 0){
-            if(!opt_grp_dbs_contents_is_empty){
-                lock_opt_grp_dbs_contents = 1;
-            }
-            if(opt_prop_db->props[i].appeared_yet){
-                return JD_DUPLICATE_SAME_OPTION;
-            }
-            if(current_options_contents_num < current_options_contents_num_min){
-                return OPTION_TOO_LITTLE_CONTENTS;
-            }
-            opt_prop_db->props[i].appeared_yet = 1;
-            current_options_contents_num       = 0;
-            current_options_contents_num_max   = opt_prop_db->props[i].content_num_max;
-            current_options_contents_num_min   = opt_prop_db->props[i].content_num_min;
-            return JD_OPT_GRPs_OPTION;
-        }
+    if(need <= *capacity){
+        return SUCCESS;
     }
 
-    /* 文字列の先頭の改行コードはdecodeOptionsにてこの関数のために付属された情報で本来の文字列には先頭の改行コードは存在しない */
-    if(*str[0] == '\n'){
-        if(current_options_contents_num >= current_options_contents_num_max){
-            return OPTION_TOO_MANY_CONTENTS;
-        }
-        else{
-            /* 先頭の改行コードを削除 */
-            *str = &(*str[1]);
-            current_options_contents_num++;
-            return JD_OPT_GRPs_CONTENTS;
+    int new_capacity = *capacity == 0 ? 16 : *capacity;
+    while(new_capacity < need){
+        if(new_capacity > INT_MAX/2){
+            return OUT_OF_MEMORY;
         }
+        new_capacity *= 2;
     }
 
-    if(current_options_contents_num < current_options_contents_num_max){
-        current_options_contents_num++;
-        return JD_OPT_GRPs_CONTENTS;
+    void *new_array = reallocarray(*array, new_capacity, elem_size);
+    if(!new_array){
+        return OUT_OF_MEMORY;
     }
+    OPT_STATS_COUNT_ALLOC((size_t)new_capacity * elem_size);
+    *array    = new_array;
+    *capacity = new_capacity;
+    return SUCCESS;
+}
 
-    if(!lock_opt_grp_dbs_contents){
-        opt_grp_dbs_contents_is_empty = 0;
-        return JD_OPT_GRP_DBs_CONTENTS;
+static int /* 0:success, 1: out of memory */
+pushToken(
+        opt_parser_t *parser,
+        const char   *str,
+        int           len,
+        bool          forced)
+{
+    if(reserveArray((void **)&(parser -> toks), &(parser -> tok_capacity), parser->tok_num + 1, sizeof(opt_token_t)) != 0){
+        return 1;
     }
 
-    return OPTION_TOO_MANY_CONTENTS;
+    opt_token_t *tok = &(parser -> toks[parser->tok_num++]);
+    tok -> view.str = str;
+    tok -> view.len = len;
+    tok -> forced   = forced;
+    tok -> dest     = 0;
+    tok -> prop     = -1;
+    return 0;
 }
 
-int
-groupingOpt(
-        opt_property_db_t *opt_prop_db,
-        int               argc,
-        char            **argv,
-        opt_group_db_t   **opt_grp_db) 
+static int /* 0:success, 1: out of memory, 2: argは束ねた短縮形式ではない */
+decodeShortCluster( /* -hvi を -h, -v, -i に, -ofile と -I./inc を -o, file と -I, ./inc に分割する. 文字列の比較は行わない */
+        opt_parser_t *parser,
+        const char   *arg,
+        int           len)
 {
-    if(!opt_prop_db){
-        return OPTION_OPT_PROP_DB_IS_NULL;
-    }
+    const int SUCCESS       = 0;
+    const int OUT_OF_MEMORY = 1;
+    const int NOT_CLUSTER   = 2;
 
-    if(!(*opt_grp_db = (opt_group_db_t *)malloc(sizeof(opt_group_db_t)))){
-        return OPTION_OUT_OF_MEMORY;
+    const opt_property_db_t *db = parser -> db;
+    int                      i;
+
+    /* 先に全ての文字が1文字のオプションか確かめ, 知らない文字があれば分割せずに1つのトークンとして扱う.
+     * コンテンツを取るオプションが現れたらそれ以降は値なので調べない */
+    for(i=1; i<len; i++){
+        int prop_i = db->short_idx[(unsigned char)arg[i]] - 1;
+        if(prop_i == -1 || arg[i] == '-'){
+            return NOT_CLUSTER;
+        }
+        if(db->props[prop_i].content_num_max > 0){
+            break;
+        }
     }
-    initOptGroupDB(*opt_grp_db);
 
-    int    new_argc;
-    char **new_argv = NULL;
-    int    ret;
+    for(i=1; i<len; i++){
+        int prop_i = db->short_idx[(unsigned char)arg[i]] - 1;
 
-    ret = decodeOptions(opt_prop_db, argc, argv, &new_argc, &new_argv);
-    if(ret != 0){
-        goto free_and_exit;
+        /* argvの要素には'-'と文字が並んでいないので, オプションのビューは登録されたshort_formを指す */
+        if(pushToken(parser, db->props[prop_i].short_form, 2, false) != 0){
+            return OUT_OF_MEMORY;
+        }
+        parser -> toks[parser->tok_num-1].prop = prop_i;
+        if(db->props[prop_i].content_num_max > 0){
+            if(i+1 < len && pushToken(parser, arg+i+1, len-i-1, true) != 0){
+                return OUT_OF_MEMORY;
+            }
+            break;
+        }
     }
+    return SUCCESS;
+}
 
-    for(int i=0; i<new_argc; i++){
-        switch(judgeDestination(opt_prop_db, &new_argv[i])){
-            case JD_OPT_GRP_DBs_CONTENTS:
-                if(add2optGrpDB_contents(*opt_grp_db, new_argv[i]) == 1){
-                    ret = OPTION_OUT_OF_MEMORY;
-                    goto free_and_exit;
-                }
-                break;
+static int /* strに対応する詳細形式のpropsの添字. 見つからなければ-1, 省略形が曖昧ならOPT_ABBREV_AMBIGUOUS */
+lookupLongForm( /* 完全に一致する名前はハッシュで引き, abbrevが有効で -- で始まる場合は基数木で接頭辞として引く */
+        const opt_property_db_t *db,
+        const char              *str,
+        int                      len)
+{
+    int prop_i = lookupOptProp(db, str, len);
 
-            case JD_OPT_GRPs_CONTENTS:
-                if(add2optGrpDB_OptGrps_Contents(*opt_grp_db, new_argv[i]) == 1){
-                    ret = OPTION_OUT_OF_MEMORY;
-                    goto free_and_exit;
-                }
-                break;
+    if(prop_i != -1){
+        return equalsOptName(db->props[prop_i].long_form, str, len) ? prop_i : -1;
+    }
+    if(!db->abbrev || len <= 2 || str[0] != '-' || str[1] != '-'){
+        return -1;
+    }
+    return matchOptAbbrev(db, str, len);
+}
 
-            case JD_OPT_GRPs_OPTION:
-                if(add2optGrpDB_OptGrps_Option(*opt_grp_db, new_argv[i]) == 1){
-                    ret = OPTION_OUT_OF_MEMORY;
-                    goto free_and_exit;
+static int /* 0:success, 1: out of memory, 2: 省略形が曖昧 */
+decodeArg(
+        opt_parser_t *parser, /* [mod] 切り出したトークンをparser->toksに追加する */
+        const char   *arg,
+        int           len)    /* argの長さ. 応答ファイルから切り出したargはNUL終端されていない */
+{
+    const opt_property_db_t *db  = parser -> db;
+    const char              *end = arg + len;
+    const char              *eq  = (const char *)memchr(arg, '=', len);
+
+    if(eq){
+        int prop_i = lookupLongForm(db, arg, eq - arg);
+        if(prop_i == OPT_ABBREV_AMBIGUOUS){
+            parser -> ambiguous = (opt_view_t){arg, eq - arg};
+            return 2;
+        }
+        if(prop_i != -1){
+            /* --inte=3 のような省略形のビューは登録されたlong_formを指す */
+            const char *name     = db -> props[prop_i].long_form;
+            int         name_len = eq - arg;
+            if(equalsOptName(name, arg, name_len)){
+                name = arg;
+            }
+            else{
+                name_len = strlen(name);
+            }
+            if(pushToken(parser, name, name_len, false) != 0){
+                return 1;
+            }
+            parser -> toks[parser->tok_num-1].prop = prop_i;
+            /* --long=a,b は argvを書き換えずに "--long", "a", "b" のビューに分割する. strtokと同様に空の要素は読み飛ばす */
+            for(const char *head = eq+1; head < end;){
+                const char *tail = (const char *)memchr(head, ',', end - head);
+                if(!tail){
+                    tail = end;
                 }
-                break;
-
-            case JD_DUPLICATE_SAME_OPTION: 
-                ret = OPTION_DUPLICATE_SAME_OPT;
-                goto free_and_exit;
-
-            case JD_TOO_MANY_CONTENTS:
-                ret = OPTION_TOO_MANY_CONTENTS;
-                goto free_and_exit;
+                if(tail != head && pushToken(parser, head, tail - head, true) != 0){
+                    return 1;
+                }
+                head = tail+1;
+            }
+            return 0;
+        }
+    }
 
-            case JD_TOO_LITTLE_CONTENTS:
-                ret = OPTION_TOO_LITTLE_CONTENTS;
-                goto free_and_exit;
+    /* 登録された名前に完全に一致しない -- で始まる引数は詳細形式の省略形として引く */
+    if(db->abbrev && len > 2 && arg[0] == '-' && arg[1] == '-' && lookupOptProp(db, arg, len) == -1){
+        int prop_i = matchOptAbbrev(db, arg, len);
+        if(prop_i == OPT_ABBREV_AMBIGUOUS){
+            parser -> ambiguous = (opt_view_t){arg, len};
+            return 2;
+        }
+        if(prop_i != -1){
+            const char *name = db -> props[prop_i].long_form;
+            if(pushToken(parser, name, strlen(name), false) != 0){
+                return 1;
+            }
+            parser -> toks[parser->tok_num-1].prop = prop_i;
+            return 0;
+        }
+    }
 
-            default:
-                BUG_REPORT();
+    /* 登録された名前に完全に一致するもの(例えば -pie)は束ねた短縮形式より優先する */
+    if(len > 2 && arg[0] == '-' && db->short_idx[(unsigned char)arg[1]] != 0 && lookupOptProp(db, arg, len) == -1){
+        int ret = decodeShortCluster(parser, arg, len);
+        if(ret != 2){
+            return ret;
         }
     }
 
-    ret = checkContentsNum(opt_prop_db, *opt_grp_db);
-    switch(ret){
-        case 1:
-            ret = OPTION_TOO_MANY_CONTENTS;
-            goto free_and_exit;
+    return pushToken(parser, arg, len, false);
+}
 
-        case 2:
-            ret = OPTION_TOO_LITTLE_CONTENTS;
-            goto free_and_exit;
+static int /* option_errcode_tのどれか */
+decodeRspArg(
+        opt_parser_t *parser,
+        const char   *arg,
+        int           len,
+        int           depth,       /* argが書かれていた応答ファイルの深さ. argvなら0 */
+        bool          expandable); /* argが引用符の外の@で始まっているか */
+
+#define OPT_RSP_WINDOW_TOKENS 4096 /* optIterNextが応答ファイルから1度に切り出すトークンの数の目安 */
+
+struct _opt_rsp_file_t{
+    opt_mapping_t  map;      /* ファイルのマッピング */
+    const char    *pos;      /* 次にトークンを切り出す位置. 読み終えたらマッピングの終端 */
+    const char    *mark;     /* optIterNextが待ち行列を詰め直し始めた時点のpos. これより前を指すトークンは待ち行列に無い */
+    size_t         released; /* optIterNextがmadviseで手放した先頭からのバイト数 */
+    int            depth;    /* 入れ子の深さ. argvの@fileなら1 */
+    int            parent;   /* このファイルを展開した応答ファイルのrspsの添字. argvから展開したなら-1 */
+};
 
+static void
+releaseRspFiles( /* parserが保持している応答ファイルのマッピングと引用符を取り除いたトークンを全て開放する */
+        opt_parser_t *parser)
+{
+    for(int i=0; i<parser->rsp_num; i++){
+        munmap(parser->rsps[i].map.addr, parser->rsps[i].map.size);
+    }
+    parser -> rsp_num = 0;
+    parser -> rsp_top = -1;
+    freeArena(parser -> unquoted);
+    parser -> unquoted = NULL;
+}
+
+/* 応答ファイルの文字の種類. 0: トークンの一部, 1: 空白, 2: 引用符かバックスラッシュ */
+static const unsigned char rsp_char_class[256] = {
+    [' ']  = 1, ['\t'] = 1, ['\n'] = 1, ['\v'] = 1, ['\f'] = 1, ['\r'] = 1,
+    ['\''] = 2, ['"']  = 2, ['\\'] = 2,
+};
+
+static const char* /* トークンの直後 */
+unquoteRspToken( /* pから始まるトークンをシェルと同様に解釈して引用符とバックスラッシュを取り除く */
+        const char *p,
+        const char *end,
+        char       *out, /* [out] 取り除いた結果. NULLなら長さだけを数える */
+        size_t     *len) /* [out] 取り除いた結果の長さ */
+{
+    char quote = '\0';
+
+    *len = 0;
+    while(p < end){
+        char c = *p;
+        if(quote == '\''){
+            if(c == '\''){
+                quote = '\0';
+                p++;
+                continue;
+            }
+        }
+        else if(quote == '"'){
+            if(c == '"'){
+                quote = '\0';
+                p++;
+                continue;
+            }
+            /* 二重引用符の中のバックスラッシュは " \ $ ` 改行 の前でだけ意味を持つ */
+            if(c == '\\' && p+1 < end && memchr("\"\\$`\n", p[1], 5)){
+                c = *++p;
+                if(c == '\n'){
+                    p++;
+                    continue;
+                }
+            }
+        }
+        else{
+            if(rsp_char_class[(unsigned char)c] == 1){
+                break;
+            }
+            if(c == '\'' || c == '"'){
+                quote = c;
+                p++;
+                continue;
+            }
+            if(c == '\\' && p+1 < end){
+                c = *++p;
+                if(c == '\n'){
+                    p++;
+                    continue;
+                }
+            }
+        }
+        if(out){
+            out[*len] = c;
+        }
+        (*len)++;
+        p++;
+    }
+    return p;
+}
+
+static int /* option_errcode_tのどれか */
+decodeRspFiles( /* 読んでいる途中の応答ファイルの続きをシェルと同様に空白で区切ってトークンに切り出す. 全て読み終えるかparser->tok_numがtok_limitに達したら戻る.
+                 * 引用符もバックスラッシュも無いトークンはマッピングをそのまま指し, それ以外のトークンだけを取り除いた結果をparser->unquotedに作る.
+                 * マッピングには書き込まないので, 読んだページは複製されずにページキャッシュと共有される */
+        opt_parser_t *parser,
+        int           tok_limit)
+{
+    int ret;
+
+    while(parser->rsp_top != -1 && parser->tok_num < tok_limit){
+        opt_rsp_file_t *rsp   = &(parser -> rsps[parser->rsp_top]);
+        const char     *p     = rsp -> pos;
+        const char     *end   = (const char *)rsp->map.addr + rsp->map.size;
+        int             depth = rsp -> depth;
+
+        while(p < end && rsp_char_class[(unsigned char)*p] == 1){
+            p++;
+        }
+        if(p == end){
+            rsp -> pos        = end;
+            parser -> rsp_top = rsp -> parent;
+            continue;
+        }
+
+        const char *head       = p;
+        const char *str        = p;
+        size_t      len;
+        bool        expandable = *p == '@'; /* 引用符の外の@で始まるトークンだけを展開する */
+
+        while(p < end && rsp_char_class[(unsigned char)*p] == 0){
+            p++;
+        }
+        if(p == end || rsp_char_class[(unsigned char)*p] == 1){
+            len = p - head;
+        }
+        else{
+            p = unquoteRspToken(head, end, NULL, &len);
+            char *unquoted = (char *)allocFromArenaAligned(&(parser -> unquoted), len, 1);
+            if(!unquoted){
+                return OPTION_OUT_OF_MEMORY;
+            }
+            unquoteRspToken(head, end, unquoted, &len);
+            str = unquoted;
+        }
+        /* 入れ子の応答ファイルを展開するとrspsが再確保され得るので, 先に位置を書き戻す */
+        rsp -> pos = p;
+
+        if(len > INT_MAX){
+            return OPTION_OUT_OF_MEMORY;
+        }
+        if((ret = decodeRspArg(parser, str, len, depth, expandable)) != OPTION_SUCCESS){
+            return ret;
+        }
+    }
+    return OPTION_SUCCESS;
+}
+
+static int /* option_errcode_tのどれか */
+expandRspFile( /* pathの応答ファイルをマップし, 次にdecodeRspFilesで読むファイルにする. トークンはまだ切り出さない */
+        opt_parser_t *parser,
+        const char   *path,
+        int           depth,     /* 展開する応答ファイルの深さ */
+        bool         *expanded)  /* [out] 応答ファイルとして扱ったか. 開けない場合や通常のファイルでない場合はfalse */
+{
+    struct stat st;
+    int         fd;
+
+    *expanded = false;
+
+    if((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1){
+        return OPTION_SUCCESS;
+    }
+    if(fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)){
+        close(fd);
+        return OPTION_SUCCESS;
+    }
+    *expanded = true;
+
+    if(depth > parser->rsp_depth_max){
+        close(fd);
+        return OPTION_RSP_FILE_TOO_DEEP;
+    }
+    if(st.st_size == 0){
+        close(fd);
+        return OPTION_SUCCESS;
+    }
+
+    if(reserveArray((void **)&(parser -> rsps), &(parser -> rsp_capacity), parser->rsp_num + 1, sizeof(opt_rsp_file_t)) != 0){
+        close(fd);
+        return OPTION_OUT_OF_MEMORY;
+    }
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED){
+        return OPTION_OUT_OF_MEMORY;
+    }
+    /* 先頭から1回だけ読むので先読みを増やし, 読み終えたページは早めに手放せるようにする */
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+
+    opt_rsp_file_t *rsp = &(parser -> rsps[parser->rsp_num]);
+    rsp -> map.addr   = addr;
+    rsp -> map.size   = st.st_size;
+    rsp -> pos        = (const char *)addr;
+    rsp -> mark       = (const char *)addr;
+    rsp -> released   = 0;
+    rsp -> depth      = depth;
+    rsp -> parent     = parser -> rsp_top;
+    parser -> rsp_top = parser -> rsp_num++;
+    return OPTION_SUCCESS;
+}
+
+static int /* option_errcode_tのどれか */
+decodeRspArg(
+        opt_parser_t *parser,
+        const char   *arg,
+        int           len,
+        int           depth,
+        bool          expandable)
+{
+    if(expandable && parser->rsp_depth_max > 0 && len > 1 && len-1 < PATH_MAX){
+        char path[PATH_MAX];
+        bool expanded;
+        int  ret;
+
+        memcpy(path, arg+1, len-1);
+        path[len-1] = '\0';
+        if((ret = expandRspFile(parser, path, depth+1, &expanded)) != OPTION_SUCCESS || expanded){
+            return ret;
+        }
+    }
+
+    switch(decodeArg(parser, arg, len)){
         case 0:
+            return OPTION_SUCCESS;
+
+        case 2:
+            return OPTION_AMBIGUOUS_OPT;
+
         default:
-            break;
+            return OPTION_OUT_OF_MEMORY;
+    }
+}
+
+static int /* option_errcode_tのどれか */
+decodeOptions(
+        opt_parser_t *parser, /* [mod] 切り出したトークンをparser->toksに格納する */
+        int           argc,
+        char        **argv)
+{
+    int ret;
+
+    parser -> tok_num = 0;
+
+    /* 分割や応答ファイルの展開が無い限りトークンの数はargc-1なので, 最初にその分を確保しておく */
+    if(reserveArray((void **)&(parser -> toks), &(parser -> tok_capacity), argc > 1 ? argc-1 : 1, sizeof(opt_token_t)) != 0){
+        return OPTION_OUT_OF_MEMORY;
+    }
+
+    for(int i=1; i<argc; i++){
+        size_t len = strlen(argv[i]);
+        if(len > INT_MAX){
+            return OPTION_OUT_OF_MEMORY;
+        }
+        if((ret = decodeRspArg(parser, argv[i], len, 0, argv[i][0] == '@')) != OPTION_SUCCESS ||
+                (ret = decodeRspFiles(parser, INT_MAX)) != OPTION_SUCCESS){
+            return ret;
+        }
     }
 
-    adaptContentsChecker(opt_prop_db, *opt_grp_db);
     return OPTION_SUCCESS;
+}
 
-free_and_exit:
-    freeOptGroupDB(*opt_grp_db);
-    *opt_grp_db = NULL;
+/* ============================================== */
+
+#define OPT_FAST_MANTISSA_MAX (UINT64_C(1) << 53) /* doubleで誤差無く表せる整数の上限 */
+#define OPT_FAST_POW10_MAX    22                  /* doubleで誤差無く表せる10の冪の指数の上限 */
+#define OPT_STRTOD_BUF_SIZE   64                  /* strtodに渡すためにNUL終端する作業領域の既定のサイズ */
+
+static const double opt_pow10[OPT_FAST_POW10_MAX+1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static int /* 0:success, 1: 解釈できない */
+parseDecimalU64( /* 10進の数字列を解釈する. 19桁まではオーバーフローし得ないので, 数字かどうかの判定をまとめて行い桁毎の分岐を省く */
+        const char *str,
+        int         len,
+        uint64_t   *value) /* [out] 解釈した値 */
+{
+    if(len <= 0){
+        return 1;
+    }
+
+    uint64_t v    = 0;
+    unsigned bad  = 0;
+    int      fast = len < 19 ? len : 19;
+    int      i;
+    for(i=0; i<fast; i++){
+        unsigned d = (unsigned char)str[i] - '0';
+        bad |= d > 9;
+        v    = v*10 + d;
+    }
+    if(bad){
+        return 1;
+    }
+    for(; i<len; i++){
+        unsigned d = (unsigned char)str[i] - '0';
+        if(d > 9 || __builtin_mul_overflow(v, 10, &v) || __builtin_add_overflow(v, d, &v)){
+            return 1;
+        }
+    }
+    *value = v;
+    return 0;
+}
+
+static int /* 0:success, 1: 解釈できない */
+parseInt64(
+        const char *str,
+        int         len,
+        int64_t    *value) /* [out] 解釈した値 */
+{
+    bool     neg = len > 0 && str[0] == '-';
+    int      off = len > 0 && (str[0] == '-' || str[0] == '+');
+    uint64_t v;
+
+    if(parseDecimalU64(str + off, len - off, &v) != 0){
+        return 1;
+    }
+    if(v > (uint64_t)INT64_MAX + neg){
+        return 1;
+    }
+    /* -2^63は符号付きでは一旦表せないので符号無しのまま反転する */
+    *value = neg ? (int64_t)(0 - v) : (int64_t)v;
+    return 0;
+}
+
+static int /* 0:success, 1: 解釈できない */
+parseDoubleFast( /* 仮数が2^53以下で指数の絶対値が22以下の10進表記なら, 1回の乗算か除算で正しく丸められた値が得られる(Clingerの方法) */
+        const char *str,
+        int         len,
+        double     *value) /* [out] 解釈した値 */
+{
+    const char *p     = str;
+    const char *end   = str + len;
+    bool        neg   = false;
+    uint64_t    m     = 0;
+    int         digit = 0; /* 仮数の桁数 */
+    int         exp   = 0;
+
+    if(p < end && (*p == '-' || *p == '+')){
+        neg = *p++ == '-';
+    }
+    for(; p < end && (unsigned)(*p - '0') <= 9; p++, digit++){
+        m = m*10 + (*p - '0');
+    }
+    if(p < end && *p == '.'){
+        for(p++; p < end && (unsigned)(*p - '0') <= 9; p++, digit++){
+            m = m*10 + (*p - '0');
+            exp--;
+        }
+    }
+    if(digit == 0 || digit > 19){
+        return 1;
+    }
+    if(p < end && (*p == 'e' || *p == 'E')){
+        int64_t e;
+        if(parseInt64(p + 1, (int)(end - p - 1), &e) != 0 || e < -OPT_FAST_POW10_MAX*2 || e > OPT_FAST_POW10_MAX*2){
+            return 1;
+        }
+        exp += (int)e;
+        p    = end;
+    }
+    if(p != end || m > OPT_FAST_MANTISSA_MAX || exp < -OPT_FAST_POW10_MAX || exp > OPT_FAST_POW10_MAX){
+        return 1;
+    }
+
+    double v = (double)m;
+    v        = exp < 0 ? v / opt_pow10[-exp] : v * opt_pow10[exp];
+    *value   = neg ? -v : v;
+    return 0;
+}
+
+static int /* 0:success, 1: 解釈できない */
+parseDouble( /* 大半の表記はparseDoubleFastで解釈し, 桁が多い場合やinfやnanなどはstrtodに任せる */
+        const char *str,
+        int         len,
+        double     *value) /* [out] 解釈した値 */
+{
+    if(parseDoubleFast(str, len, value) == 0){
+        return 0;
+    }
+    if(len <= 0 || isspace((unsigned char)str[0])){
+        return 1;
+    }
+
+    /* ビューはNUL終端されているとは限らないので複製してから渡す */
+    char  buf[OPT_STRTOD_BUF_SIZE];
+    char *copy = len < OPT_STRTOD_BUF_SIZE ? buf : (char *)malloc(len + 1);
+    if(!copy){
+        return 1;
+    }
+    if(copy != buf){
+        OPT_STATS_COUNT_ALLOC(len + 1);
+    }
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+
+    char  *end;
+    errno     = 0;
+    double v  = strtod(copy, &end);
+    int    ret = end != copy + len || (errno == ERANGE && (v == HUGE_VAL || v == -HUGE_VAL));
+    if(copy != buf){
+        free(copy);
+    }
+    if(ret == 0){
+        *value = v;
+    }
     return ret;
 }
 
+static bool
+equalsIgnoreCase( /* strの先頭len文字が英小文字のwordと大文字小文字を無視して一致するか */
+        const char *str,
+        int         len,
+        const char *word)
+{
+    int i;
+    for(i=0; i<len && word[i]; i++){
+        if(tolower((unsigned char)str[i]) != word[i]){
+            return false;
+        }
+    }
+    return i == len && word[i] == '\0';
+}
+
+static int /* 0:success, 1: 解釈できない */
+parseBool(
+        const char *str,
+        int         len,
+        bool       *value) /* [out] 解釈した値 */
+{
+    static const char *const true_words[]  = {"1", "true",  "yes", "on",  NULL};
+    static const char *const false_words[] = {"0", "false", "no",  "off", NULL};
+
+    for(int i=0; true_words[i]; i++){
+        if(equalsIgnoreCase(str, len, true_words[i])){
+            *value = true;
+            return 0;
+        }
+        if(equalsIgnoreCase(str, len, false_words[i])){
+            *value = false;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int /* 0:success, 1: 解釈できない */
+parseEnum(
+        const char         *str,
+        int                 len,
+        const char *const  *names, /* [in] 受け付ける文字列のNULL終端された配列 */
+        int                *value) /* [out] namesにおける添字 */
+{
+    if(!names){
+        return 1;
+    }
+    for(int i=0; names[i]; i++){
+        OPT_STATS_COUNT_CMP();
+        if(strncmp(names[i], str, len) == 0 && names[i][len] == '\0'){
+            *value = i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int /* 0:success, 1: 解釈できない */
+parseSize( /* 数字列の後ろのK, M, G, T, P, Eを1024の冪として掛ける. 接尾辞の後ろのBかiBは読み飛ばす */
+        const char *str,
+        int         len,
+        uint64_t   *value) /* [out] 解釈したバイト数 */
+{
+    static const char units[] = "kmgtpe";
+
+    int digit = 0;
+    while(digit < len && (unsigned)(str[digit] - '0') <= 9){
+        digit++;
+    }
+
+    const char *suffix = str + digit;
+    int         rest   = len - digit;
+    int         shift  = 0;
+    if(rest > 0 && rest <= 3){
+        const char *unit = memchr(units, tolower((unsigned char)suffix[0]), sizeof(units) - 1);
+        if(unit){
+            shift = 10 * (int)(unit - units + 1);
+            suffix++;
+            rest--;
+        }
+    }
+    if(!(rest == 0 || equalsIgnoreCase(suffix, rest, "b") || (shift && equalsIgnoreCase(suffix, rest, "ib")))){
+        return 1;
+    }
+
+    uint64_t v;
+    if(parseDecimalU64(str, digit, &v) != 0 || v > UINT64_MAX >> shift){
+        return 1;
+    }
+    *value = v << shift;
+    return 0;
+}
+
+static int /* 0:success, 1: 解釈できない */
+parseOptValue( /* strの先頭len文字をpropのvalue_typeの値として解釈する */
+        const opt_property_t *prop,
+        const char           *str,
+        int                   len,
+        opt_value_t          *value) /* [out] 解釈した値 */
+{
+    switch(prop->value_type){
+        case OPT_VALUE_INT64:
+            return parseInt64(str, len, &(value -> i64));
+
+        case OPT_VALUE_UINT64:
+            return parseDecimalU64(str, len, &(value -> u64));
+
+        case OPT_VALUE_DOUBLE:
+            return parseDouble(str, len, &(value -> dbl));
+
+        case OPT_VALUE_BOOL:
+            return parseBool(str, len, &(value -> b));
+
+        case OPT_VALUE_ENUM:
+            return parseEnum(str, len, prop->enum_names, &(value -> e));
+
+        case OPT_VALUE_SIZE:
+            return parseSize(str, len, &(value -> u64));
+
+        default:
+            return 1;
+    }
+}
+
+/* ============================================== */
+
+/* contents_checkerを1回呼ぶための情報. 並列に呼ぶ場合も結果は各グループのerr_codeに書くので順序によらない */
+typedef struct _opt_checker_job_t{
+    int     prop_id;
+    char  **contents;
+    int     content_num;
+    int    *err_code;    /* [out] contents_checkerの戻り値の格納先 */
+}opt_checker_job_t;
+
+#define OPT_MEMO_INIT_CAPACITY 64 /* opt_checker_memo_tのentriesの初期サイズ(2の冪) */
+
+/* opt_checker_memo_tのエントリ */
+typedef struct _opt_memo_entry_t{
+    uint64_t    hash;
+    const char *key;      /* prop_idとコンテンツを直列化したもの. NULLなら空き */
+    size_t      key_len;
+    int         err_code;
+    bool        done;     /* falseならいずれかのスレッドが検査中 */
+}opt_memo_entry_t;
+
+struct _opt_checker_memo_t{
+    pthread_mutex_t    lock;
+    pthread_cond_t     done_cond;  /* 検査中のエントリが終わったことを待つ */
+    int                entry_num;
+    int                capacity;   /* entriesのサイズ(2の冪) */
+    opt_memo_entry_t  *entries;
+    opt_arena_chunk_t *keys;       /* entriesのkeyの格納先 */
+};
+
+/* キーは [prop_id][content_num]([len][文字列])... をint型とバイト列で並べたもの. 比較とハッシュはコンテンツから直接求め, 登録するときだけ直列化する */
+static uint64_t /* FNV-1a */
+hashMemoBytes(
+        uint64_t    hash,
+        const void *bytes,
+        size_t      len)
+{
+    for(size_t i=0; i<len; i++){
+        hash ^= ((const unsigned char *)bytes)[i];
+        hash *= 1099511628211u;
+    }
+    return hash;
+}
+
+static uint64_t
+hashMemoKey(
+        const opt_checker_job_t *job,
+        size_t                  *key_len) /* [out] 直列化したキーの長さ */
+{
+    uint64_t hash = hashMemoBytes(14695981039346656037u, &(job -> prop_id), sizeof(int));
+    hash      = hashMemoBytes(hash, &(job -> content_num), sizeof(int));
+    *key_len  = sizeof(int)*2;
+    for(int i=0; i<job->content_num; i++){
+        int len = strlen(job->contents[i]);
+        hash      = hashMemoBytes(hash, &len, sizeof(int));
+        hash      = hashMemoBytes(hash, job->contents[i], len);
+        *key_len += sizeof(int) + len;
+    }
+    return hash;
+}
+
+static bool
+equalsMemoKey(
+        const opt_memo_entry_t  *entry,
+        uint64_t                 hash,
+        size_t                   key_len,
+        const opt_checker_job_t *job)
+{
+    if(entry->hash != hash || entry->key_len != key_len){
+        return false;
+    }
+
+    const char *key = entry -> key;
+    int         num;
+
+    memcpy(&num, key, sizeof(int));
+    if(num != job->prop_id){
+        return false;
+    }
+    key += sizeof(int)*2; /* key_lenが等しければcontent_numも等しい */
+    for(int i=0; i<job->content_num; i++){
+        memcpy(&num, key, sizeof(int));
+        key += sizeof(int);
+        if(strncmp(key, job->contents[i], num) != 0 || job->contents[i][num] != '\0'){
+            return false;
+        }
+        key += num;
+    }
+    return true;
+}
+
+static opt_memo_entry_t* /* jobのキーのエントリ. 無ければ挿入先の空きエントリ */
+findMemoEntry(
+        opt_checker_memo_t      *memo,
+        uint64_t                 hash,
+        size_t                   key_len,
+        const opt_checker_job_t *job)
+{
+    unsigned int mask = memo->capacity - 1;
+    unsigned int slot = hash & mask;
+
+    while(memo->entries[slot].key && !equalsMemoKey(&(memo -> entries[slot]), hash, key_len, job)){
+        slot = (slot+1) & mask;
+    }
+    return &(memo -> entries[slot]);
+}
+
+static int /* 0:success, 1: out of memory */
+growMemo( /* 負荷率が1/2を超えないように倍に拡張する */
+        opt_checker_memo_t *memo)
+{
+    if((memo->entry_num + 1) * 2 <= memo->capacity){
+        return 0;
+    }
+
+    int               capacity = memo->capacity * 2;
+    opt_memo_entry_t *entries  = (opt_memo_entry_t *)calloc(capacity, sizeof(opt_memo_entry_t));
+    if(!entries){
+        return 1;
+    }
+    OPT_STATS_COUNT_ALLOC(sizeof(opt_memo_entry_t) * capacity);
+    for(int i=0; i<memo->capacity; i++){
+        if(memo->entries[i].key){
+            unsigned int slot = memo->entries[i].hash & (capacity - 1);
+            while(entries[slot].key){
+                slot = (slot+1) & (capacity - 1);
+            }
+            entries[slot] = memo -> entries[i];
+        }
+    }
+    free(memo -> entries);
+    memo -> entries  = entries;
+    memo -> capacity = capacity;
+    return 0;
+}
+
+static int /* contents_checkerの戻り値 */
+callContentsChecker( /* memoがあれば同じオプションと同じコンテンツの組は1回だけ検査する. 他のスレッドが検査中ならその結果を待つ */
+        const opt_property_db_t *opt_prop_db,
+        const opt_checker_job_t *job)
+{
+    int               (*checker)(char **, int) = opt_prop_db -> props[job->prop_id].contents_checker;
+    opt_checker_memo_t *memo                   = opt_prop_db -> checker_memo;
+    opt_memo_entry_t   *entry;
+    size_t              key_len;
+    uint64_t            hash;
+    int                 err_code;
+
+    if(!memo){
+        return checker(job->contents, job->content_num);
+    }
+
+    hash = hashMemoKey(job, &key_len);
+    pthread_mutex_lock(&(memo -> lock));
+    while((entry = findMemoEntry(memo, hash, key_len, job))->key && !entry->done){
+        pthread_cond_wait(&(memo -> done_cond), &(memo -> lock));
+    }
+    if(entry->key){
+        err_code = entry -> err_code;
+        pthread_mutex_unlock(&(memo -> lock));
+        return err_code;
+    }
+
+    /* 検査中として登録してから, ロックを離して検査する. 確保に失敗したら記録せずに検査だけ行う */
+    char *key = NULL;
+    if(growMemo(memo) == 0 && (key = (char *)allocFromArenaAligned(&(memo -> keys), key_len, 1))){
+        char *p = key;
+        memcpy(p, &(job -> prop_id), sizeof(int));
+        memcpy(p + sizeof(int), &(job -> content_num), sizeof(int));
+        p += sizeof(int)*2;
+        for(int i=0; i<job->content_num; i++){
+            int len = strlen(job->contents[i]);
+            memcpy(p, &len, sizeof(int));
+            memcpy(p + sizeof(int), job->contents[i], len);
+            p += sizeof(int) + len;
+        }
+        entry = findMemoEntry(memo, hash, key_len, job);
+        *entry = (opt_memo_entry_t){hash, key, key_len, 0, false};
+        memo -> entry_num++;
+    }
+    pthread_mutex_unlock(&(memo -> lock));
+
+    err_code = checker(job->contents, job->content_num);
+
+    if(key){
+        pthread_mutex_lock(&(memo -> lock));
+        /* 検査中に他のスレッドがgrowMemoで配置し直しているかもしれないので引き直す */
+        entry = findMemoEntry(memo, hash, key_len, job);
+        entry -> err_code = err_code;
+        entry -> done     = true;
+        pthread_cond_broadcast(&(memo -> done_cond));
+        pthread_mutex_unlock(&(memo -> lock));
+    }
+    return err_code;
+}
+
+/* runCheckerJobsのスレッド間で共有する状態 */
+typedef struct _opt_checker_ctx_t{
+    const opt_property_db_t *opt_prop_db;
+    opt_stats_t             *stats;   /* オプション毎のcontents_checkerの時間の足し込み先. NULLなら記録しない */
+    opt_checker_job_t       *jobs;
+    int                      job_num;
+    atomic_int               next;    /* 次に取り出すjobsの添字 */
+}opt_checker_ctx_t;
+
+static void*
+runCheckerThread(
+        void *arg)
+{
+    opt_checker_ctx_t *ctx = (opt_checker_ctx_t *)arg;
+
+    for(int i; (i = atomic_fetch_add_explicit(&(ctx -> next), 1, memory_order_relaxed)) < ctx->job_num;){
+        OPT_STATS_BEGIN(ctx->stats, begin);
+        *(ctx -> jobs[i].err_code) = callContentsChecker(ctx->opt_prop_db, &(ctx -> jobs[i]));
+        OPT_STATS_END_CHECKER(ctx->stats, begin, ctx->jobs[i].prop_id);
+    }
+    return NULL;
+}
+
 static void
-freeOptGroup(
-        opt_group_t *opt_grp)
+runCheckerJobs( /* checker_thread_numが2以上ならその数のスレッド(呼び出し元を含む)でjobsを分け合って並列に実行する */
+        const opt_property_db_t *opt_prop_db,
+        opt_stats_t             *stats,
+        opt_checker_job_t       *jobs,
+        int                      job_num)
 {
-    free(opt_grp->option);
-    opt_grp->option = NULL;
-    for(int i=0; i<opt_grp->content_num; i++){
-        free(opt_grp->contents[i]);
-        opt_grp->contents[i] = NULL;
+    opt_checker_ctx_t ctx;
+    int               thread_num = opt_prop_db->checker_thread_num < job_num ? opt_prop_db->checker_thread_num : job_num;
+
+    ctx.opt_prop_db = opt_prop_db;
+    ctx.stats       = stats;
+    ctx.jobs        = jobs;
+    ctx.job_num     = job_num;
+    atomic_init(&(ctx.next), 0);
+
+    if(thread_num <= 1){
+        runCheckerThread(&ctx);
+        return;
+    }
+
+    /* スレッドを作れなくても呼び出し元が残りのjobsを全て実行するので漏れは無い */
+    pthread_t threads[OPT_CHECKER_THREAD_MAX];
+    bool      started[OPT_CHECKER_THREAD_MAX];
+    for(int i=1; i<thread_num; i++){
+        started[i] = pthread_create(&threads[i], NULL, runCheckerThread, &ctx) == 0;
+    }
+    runCheckerThread(&ctx);
+    for(int i=1; i<thread_num; i++){
+        if(started[i]){
+            pthread_join(threads[i], NULL);
+        }
     }
-    free(opt_grp->contents);
-    opt_grp->contents = NULL;
 }
 
-void
-freeOptGroupDB(
+static bool
+hasContentsChecker(
+        const opt_property_t *prop)
+{
+    return prop->contents_checker && prop->contents_checker != alwaysReturnTrue;
+}
+
+static char** /* 格納した配列の直後 */
+terminateViewContents( /* grpのコンテンツをNUL終端された文字列の配列にしてcontentsに格納する. NUL終端されていないものは*bufに複製する */
+        const opt_view_group_t  *grp,
+        char                   **contents,
+        char                   **buf)      /* [mod] 複製先. 複製した分だけ進める */
+{
+    for(int j=0; j<grp->content_num; j++){
+        const opt_view_t *content = &(grp -> contents[j]);
+        /* ビューの直後はargvの要素の範囲内なので参照してよい. NUL終端されていればそのまま渡す */
+        if(content->str[content->len] == '\0'){
+            contents[j] = (char *)content->str;
+        }
+        else{
+            memcpy(*buf, content->str, content->len);
+            (*buf)[content->len] = '\0';
+            contents[j] = *buf;
+            *buf += content->len + 1;
+        }
+    }
+    return contents + grp->content_num;
+}
+
+static int /* 0:success, 1: out of memory */
+adaptContentsChecker(
+        opt_parser_t   *parser,
         opt_group_db_t *opt_grp_db)
 {
-    for(int i=0; i<opt_grp_db->optless_num; i++){
-        free(opt_grp_db -> optless[i]);
-        opt_grp_db -> optless[i] = NULL;
+    const opt_property_db_t *opt_prop_db = parser -> db;
+    int                      job_num     = 0;
+
+    for(int i=0; i<opt_grp_db->grp_num; i++){
+        job_num += hasContentsChecker(&(opt_prop_db -> props[opt_grp_db->grps[i].prop_id]));
+    }
+    if(job_num == 0){
+        return 0;
     }
-    free(opt_grp_db -> optless);
-    opt_grp_db -> optless = NULL;
+    if(reserveArray((void **)&(parser -> buf), &(parser -> buf_capacity), sizeof(opt_checker_job_t)*job_num, sizeof(char)) != 0){
+        return 1;
+    }
+
+    opt_checker_job_t *jobs = (opt_checker_job_t *)parser -> buf;
+    job_num = 0;
     for(int i=0; i<opt_grp_db->grp_num; i++){
-        freeOptGroup(&(opt_grp_db->grps[i]));
+        opt_group_t *grp = &(opt_grp_db -> grps[i]);
+        if(hasContentsChecker(&(opt_prop_db -> props[grp->prop_id]))){
+            jobs[job_num++] = (opt_checker_job_t){grp->prop_id, grp->contents, grp->content_num, &(grp -> err_code)};
+        }
     }
-    free(opt_grp_db -> grps);
-    opt_grp_db -> grps = NULL;
-    free(opt_grp_db);
-    opt_grp_db = NULL;
+    runCheckerJobs(opt_prop_db, parser->stats, jobs, job_num);
+    return 0;
+}
+
+static int /* 0:success, 1: out of memory */
+applyContentsCheckerView( /* grpのコンテンツをNUL終端された文字列の配列にしてcontents_checkerに渡し, 戻り値をerr_codeに格納する */
+        opt_parser_t     *parser,
+        opt_view_group_t *grp)
+{
+    const int SUCCESS       = 0;
+    const int OUT_OF_MEMORY = 1;
+
+    int len = 0;
+
+    if(!hasContentsChecker(&(parser -> db -> props[grp->prop_id]))){
+        return SUCCESS;
+    }
+    for(int j=0; j<grp->content_num; j++){
+        len += grp->contents[j].len + 1;
+    }
+
+    /* contents_checkerにはNUL終端された文字列の配列を渡す必要があるので, 全グループで使い回す作業領域をparserに確保しておく */
+    int ptr_num = grp->content_num + 1;
+    if(reserveArray((void **)&(parser -> buf), &(parser -> buf_capacity), sizeof(char *)*ptr_num + len, sizeof(char)) != 0){
+        return OUT_OF_MEMORY;
+    }
+    char              **contents = (char **)parser -> buf;
+    char               *buf      = (char *)&contents[ptr_num];
+    opt_checker_job_t   job      = {grp->prop_id, contents, grp->content_num, &(grp -> err_code)};
+
+    terminateViewContents(grp, contents, &buf);
+    grp->err_code = callContentsChecker(parser->db, &job);
+
+    return SUCCESS;
+}
+
+static int /* 0:success, 1: out of memory */
+adaptContentsCheckerView(
+        opt_parser_t        *parser,
+        opt_view_group_db_t *opt_grp_db)
+{
+    const int SUCCESS       = 0;
+    const int OUT_OF_MEMORY = 1;
+
+    const opt_property_db_t *opt_prop_db = parser -> db;
+
+    /* 並列に検査できるように, 全グループのjobとNUL終端された文字列の配列を作業領域に [jobs][ポインタ][文字列] の順に並べておく */
+    int    job_num  = 0;
+    int    ptr_num  = 0;
+    size_t byte_num = 0;
+    for(int i=0; i<opt_grp_db->grp_num; i++){
+        opt_view_group_t *grp = &(opt_grp_db -> grps[i]);
+        if(!hasContentsChecker(&(opt_prop_db -> props[grp->prop_id]))){
+            continue;
+        }
+        job_num++;
+        ptr_num += grp->content_num + 1;
+        for(int j=0; j<grp->content_num; j++){
+            byte_num += grp->contents[j].len + 1;
+        }
+    }
+
+    if(job_num == 0){
+        return SUCCESS;
+    }
+
+    size_t size = sizeof(opt_checker_job_t)*job_num + sizeof(char *)*ptr_num + byte_num;
+    if(size > INT_MAX || reserveArray((void **)&(parser -> buf), &(parser -> buf_capacity), size, sizeof(char)) != 0){
+        return OUT_OF_MEMORY;
+    }
+    opt_checker_job_t  *jobs     = (opt_checker_job_t *)parser -> buf;
+    char              **contents = (char **)&jobs[job_num];
+    char               *buf      = (char *)&contents[ptr_num];
+
+    job_num = 0;
+    for(int i=0; i<opt_grp_db->grp_num; i++){
+        opt_view_group_t *grp = &(opt_grp_db -> grps[i]);
+        if(!hasContentsChecker(&(opt_prop_db -> props[grp->prop_id]))){
+            continue;
+        }
+        jobs[job_num++] = (opt_checker_job_t){grp->prop_id, contents, grp->content_num, &(grp -> err_code)};
+        contents        = terminateViewContents(grp, contents, &buf) + 1;
+    }
+    runCheckerJobs(opt_prop_db, parser->stats, jobs, job_num);
+
+    return SUCCESS;
+}
+
+opt_checker_memo_t*
+genOptCheckerMemo(void)
+{
+    opt_checker_memo_t *memo = (opt_checker_memo_t *)calloc(1, sizeof(opt_checker_memo_t));
+    if(!memo){
+        return NULL;
+    }
+    memo -> capacity = OPT_MEMO_INIT_CAPACITY;
+    if(!(memo->entries = (opt_memo_entry_t *)calloc(memo->capacity, sizeof(opt_memo_entry_t)))){
+        free(memo);
+        return NULL;
+    }
+    pthread_mutex_init(&(memo -> lock), NULL);
+    pthread_cond_init(&(memo -> done_cond), NULL);
+    return memo;
+}
+
+void
+freeOptCheckerMemo(
+        opt_checker_memo_t *memo)
+{
+    if(!memo){
+        return;
+    }
+    pthread_mutex_destroy(&(memo -> lock));
+    pthread_cond_destroy(&(memo -> done_cond));
+    free(memo -> entries);
+    freeArena(memo -> keys);
+    free(memo);
+}
+
+void
+setOptCheckerThreads(
+        opt_property_db_t *db,
+        int                thread_num)
+{
+    db -> checker_thread_num = thread_num < 1 ? 1 : thread_num > OPT_CHECKER_THREAD_MAX ? OPT_CHECKER_THREAD_MAX : thread_num;
+}
+
+void
+setOptCheckerMemo(
+        opt_property_db_t  *db,
+        opt_checker_memo_t *memo)
+{
+    db -> checker_memo = memo;
+}
+
+/* ============================================== */
+
+static int
+checkContentsNum(
+        const opt_property_db_t *opt_prop_db,
+        int                      tok_num,
+        const opt_token_t       *toks)
+{
+    /* return values */
+    const int SUCCESS = 0;
+    const int TOO_MANY_CONTENTS    = 1;
+    const int TOO_LITTLE_CONTENTS  = 2;
+
+    const opt_property_t *props = NULL;
+    int                   num   = 0;
+
+    for(int i=0; i<=tok_num; i++){
+        if(i < tok_num && toks[i].dest == JD_OPT_GRPs_CONTENTS){
+            num++;
+            continue;
+        }
+        if(i < tok_num && toks[i].dest != JD_OPT_GRPs_OPTION){
+            continue;
+        }
+
+        /* 次のオプションか末尾に到達したので直前のオプションのコンテンツの数を調べる */
+        if(props){
+            if(num < props->content_num_min){
+                return TOO_LITTLE_CONTENTS;
+            }
+            if(num > props->content_num_max){
+                return TOO_MANY_CONTENTS;
+            }
+        }
+        if(i < tok_num){
+            props = &(opt_prop_db -> props[toks[i].prop]);
+            num   = 0;
+        }
+    }
+
+    return SUCCESS;
+}
+
+static inline uint64_t*
+appearedBits( /* parserの指定済みのオプションのビット集合. parserが複製されても指す先が変わらないようにappeared_inlineのアドレスは保持しない */
+        opt_parser_t *parser)
+{
+    return parser->appeared ? parser->appeared : parser->appeared_inline;
+}
+
+static int
+judgeDestination(
+        opt_parser_t *parser, /* [mod] 直前までのトークンの分類結果を保持する */
+        opt_token_t  *tok)
+{
+    const opt_property_db_t *opt_prop_db = parser -> db;
+
+    /* 束ねた短縮形式から切り出したオプションはdecodeShortClusterで添字が分かっている */
+    int i = tok->forced || tok->prop != -1 ? tok->prop : lookupOptProp(opt_prop_db, tok->view.str, tok->view.len);
+    if(i != -1){
+        uint64_t *word = &appearedBits(parser)[i / 64];
+        uint64_t  bit  = (uint64_t)1 << (i % 64);
+
+        if(!parser->optless_is_empty){
+            parser -> lock_optless = 1;
+        }
+        if(*word & bit){
+            return JD_DUPLICATE_SAME_OPTION;
+        }
+        if(parser->contents_num < parser->contents_num_min){
+            return JD_TOO_LITTLE_CONTENTS;
+        }
+        *word                     |= bit;
+        parser -> contents_num     = 0;
+        parser -> contents_num_max = opt_prop_db->props[i].content_num_max;
+        parser -> contents_num_min = opt_prop_db->props[i].content_num_min;
+        tok -> prop                = i;
+        return JD_OPT_GRPs_OPTION;
+    }
+
+    /* --long=a,b の a, b は直前のオプションのコンテンツにしかなれない */
+    if(tok->forced){
+        if(parser->contents_num >= parser->contents_num_max){
+            return JD_TOO_MANY_CONTENTS;
+        }
+        parser -> contents_num++;
+        return JD_OPT_GRPs_CONTENTS;
+    }
+
+    if(parser->contents_num < parser->contents_num_max){
+        parser -> contents_num++;
+        return JD_OPT_GRPs_CONTENTS;
+    }
+
+    if(!parser->lock_optless){
+        parser -> optless_is_empty = 0;
+        return JD_OPT_GRP_DBs_CONTENTS;
+    }
+
+    return JD_TOO_MANY_CONTENTS;
+}
+
+static void
+resetOptParser( /* 前回の解析で変更されたparserの状態を初期状態に戻す. 作業領域は開放せずに使い回す */
+        opt_parser_t *parser)
+{
+    parser -> tok_num          = 0;
+    parser -> optless_is_empty = 1;
+    parser -> lock_optless     = 0;
+    parser -> contents_num     = 0;
+    parser -> contents_num_max = 0;
+    parser -> contents_num_min = 0;
+    parser -> ambiguous.str    = NULL;
+    parser -> ambiguous.len    = 0;
+    memset(appearedBits(parser), 0, sizeof(uint64_t)*parser->appeared_words);
+    /* 前回の解析が失敗して残ったマッピング. 成功した場合は結果に引き渡すか複製後に解放済み */
+    releaseRspFiles(parser);
+}
+
+/* classifyTokensで数えたトークンの数. 結果のメモリ領域の大きさを決めるのに用いる */
+typedef struct _opt_token_count_t{
+    int  grp_num;     /* オプションの数 */
+    int  content_num; /* オプションに付属するコンテンツの数 */
+    int  optless_num; /* 対応するオプションが無いコンテンツの数 */
+    int  value_num;   /* value_typeを宣言したオプションに付属するコンテンツの数 */
+    bool typed;       /* 直前のオプションがvalue_typeを宣言しているか */
+}opt_token_count_t;
+
+static int /* option_errcode_tのどれか */
+classifyToken( /* トークンの行き先をjudgeDestinationで決めて数える */
+        opt_parser_t      *parser,
+        opt_token_t       *tok,
+        opt_token_count_t *count) /* [mod] 行き先毎のトークンの数 */
+{
+    tok -> dest = judgeDestination(parser, tok);
+    switch(tok->dest){
+        case JD_OPT_GRP_DBs_CONTENTS:
+            count -> optless_num++;
+            return OPTION_SUCCESS;
+
+        case JD_OPT_GRPs_CONTENTS:
+            count -> content_num++;
+            count -> value_num += count->typed;
+            return OPTION_SUCCESS;
+
+        case JD_OPT_GRPs_OPTION:
+            count -> grp_num++;
+            count -> typed = parser->db->props[tok->prop].value_type != OPT_VALUE_NONE;
+            return OPTION_SUCCESS;
+
+        case JD_DUPLICATE_SAME_OPTION: 
+            return OPTION_DUPLICATE_SAME_OPT;
+
+        case JD_TOO_MANY_CONTENTS:
+            return OPTION_TOO_MANY_CONTENTS;
+
+        case JD_TOO_LITTLE_CONTENTS:
+            return OPTION_TOO_LITTLE_CONTENTS;
+
+        default:
+            BUG_REPORT();
+            return OPTION_SUCCESS;
+    }
+}
+
+static int /* option_errcode_tのどれか */
+checkTokensContentsNum( /* parser->toksの全てのオプションのコンテンツの数が範囲に収まっているか調べる */
+        const opt_parser_t *parser)
+{
+    switch(checkContentsNum(parser->db, parser->tok_num, parser->toks)){
+        case 1:
+            return OPTION_TOO_MANY_CONTENTS;
+
+        case 2:
+            return OPTION_TOO_LITTLE_CONTENTS;
+
+        case 0:
+        default:
+            return OPTION_SUCCESS;
+    }
+}
+
+static int /* option_errcode_tのどれか */
+classifyTokens( /* 各トークンの行き先をjudgeDestinationで決めてコンテンツの数を調べる */
+        opt_parser_t      *parser,
+        opt_token_count_t *count) /* [out] 行き先毎のトークンの数 */
+{
+    int ret;
+
+    OPT_STATS_BEGIN(parser->stats, classify_begin);
+    memset(count, 0, sizeof(opt_token_count_t));
+    for(int i=0; i<parser->tok_num; i++){
+        if((ret = classifyToken(parser, &(parser -> toks[i]), count)) != OPTION_SUCCESS){
+            return ret;
+        }
+    }
+    OPT_STATS_END(parser->stats, classify_begin, classify_ns);
+
+    OPT_STATS_BEGIN(parser->stats, check_begin);
+    ret = checkTokensContentsNum(parser);
+    OPT_STATS_END(parser->stats, check_begin, count_check_ns);
+    return ret;
+}
+
+/* ============================================== */
+
+/* 設定ファイルをマップして切り出したトークン. iノードとサイズと更新日時が変わらなければ解析の度に使い回す */
+struct _opt_config_t{
+    bool               loaded;       /* 以下のファイルを読み込み済みか */
+    dev_t              dev;          /* 読み込んだファイルのデバイス */
+    ino_t              ino;          /* 読み込んだファイルのiノード */
+    off_t              size;         /* 読み込んだファイルのサイズ */
+    struct timespec    mtime;        /* 読み込んだファイルの更新日時 */
+    int                status;       /* 切り出した結果のoption_errcode_t. 同じファイルなら解析の度にこれを返す */
+    opt_mapping_t      map;          /* ファイルのマッピング. 空のファイルならaddrがNULL */
+    opt_arena_chunk_t *unquoted;     /* 引用符やバックスラッシュを取り除いたトークン */
+    int                tok_num;      /* toksの要素数 */
+    int                tok_capacity; /* toksの容量 */
+    opt_token_t       *toks;         /* propを設定済みのオプションとforcedのコンテンツの並び. 偽を指定したオプションはview.strがNULL */
+};
+
+static int /* 0:success, 1: out of memory */
+pushLayerToken( /* 環境変数と設定ファイルのトークンをtoksに追加する */
+        opt_token_t **toks,
+        int          *tok_num,
+        int          *tok_capacity,
+        const char   *str,
+        int           len,
+        int           prop,   /* オプションならpropsの添字. コンテンツなら-1 */
+        bool          forced)
+{
+    if(reserveArray((void **)toks, tok_capacity, *tok_num + 1, sizeof(opt_token_t)) != 0){
+        return 1;
+    }
+
+    opt_token_t *tok = &((*toks)[(*tok_num)++]);
+    tok -> view.str = str;
+    tok -> view.len = len;
+    tok -> forced   = forced;
+    tok -> dest     = 0;
+    tok -> prop     = prop;
+    return 0;
+}
+
+static int /* option_errcode_tのどれか */
+decodeDefaultOpt( /* 環境変数や設定ファイルの1つの指定を, オプションとそのコンテンツのトークンにしてtoksに追加する.
+                   * 値は応答ファイルと同様に空白で区切り, 引用符の外の#から後ろはコメントとして読み飛ばす */
+        const opt_property_db_t  *db,
+        int                       prop_i,
+        const char               *p,            /* 値の先頭 */
+        const char               *end,          /* 値の末尾 */
+        opt_arena_chunk_t       **unquoted,     /* [mod] 引用符を取り除いたトークンの格納先 */
+        opt_token_t             **toks,
+        int                      *tok_num,
+        int                      *tok_capacity)
+{
+    const opt_property_t *prop  = &(db -> props[prop_i]);
+    const char           *name  = prop->long_form ? prop->long_form : prop->short_form;
+    int                   begin = *tok_num + 1; /* 最初のコンテンツの添字 */
+
+    if(pushLayerToken(toks, tok_num, tok_capacity, name, strlen(name), prop_i, false) != 0){
+        return OPTION_OUT_OF_MEMORY;
+    }
+
+    for(;;){
+        while(p < end && rsp_char_class[(unsigned char)*p] == 1){
+            p++;
+        }
+        if(p == end || *p == '#'){
+            break;
+        }
+
+        const char *head = p;
+        const char *str  = p;
+        size_t      len;
+
+        while(p < end && rsp_char_class[(unsigned char)*p] == 0){
+            p++;
+        }
+        if(p == end || rsp_char_class[(unsigned char)*p] == 1){
+            len = p - head;
+        }
+        else{
+            p = unquoteRspToken(head, end, NULL, &len);
+            char *buf = (char *)allocFromArenaAligned(unquoted, len, 1);
+            if(!buf){
+                return OPTION_OUT_OF_MEMORY;
+            }
+            unquoteRspToken(head, end, buf, &len);
+            str = buf;
+        }
+        if(len > INT_MAX){
+            return OPTION_OUT_OF_MEMORY;
+        }
+        if(pushLayerToken(toks, tok_num, tok_capacity, str, len, -1, true) != 0){
+            return OPTION_OUT_OF_MEMORY;
+        }
+    }
+
+    /* コンテンツを取らないオプションの値は真偽値として扱う. 値が無ければ真とみなす */
+    if(prop->content_num_max == 0 && *tok_num > begin){
+        bool value;
+        if(*tok_num - begin != 1 || parseBool((*toks)[begin].view.str, (*toks)[begin].view.len, &value) != 0){
+            return OPTION_INVALID_VALUE;
+        }
+        *tok_num = begin;
+        if(!value){
+            (*toks)[begin-1].view.str = NULL;
+            (*toks)[begin-1].view.len = 0;
+        }
+    }
+    return OPTION_SUCCESS;
+}
+
+static int /* option_errcode_tのどれか */
+decodeOptConfig( /* 設定ファイルの内容を1行ずつオプションとコンテンツのトークンに切り出す. マッピングには書き込まない */
+        opt_parser_t *parser,
+        opt_config_t *config,
+        const char   *buf,
+        size_t        size)
+{
+    const opt_property_db_t *db  = parser -> db;
+    const char              *end = buf + size;
+    int                      ret;
+
+    for(const char *line = buf; line < end;){
+        const char *eol = (const char *)memchr(line, '\n', end - line);
+        const char *p   = line;
+        if(!eol){
+            eol = end;
+        }
+        line = eol + 1;
+
+        while(p < eol && rsp_char_class[(unsigned char)*p] == 1){
+            p++;
+        }
+        if(p == eol || *p == '#'){
+            continue;
+        }
+
+        /* 先頭の -- を省略した詳細形式は作業領域で補ってから引く */
+        const char *key = p;
+        while(p < eol && rsp_char_class[(unsigned char)*p] != 1 && *p != '='){
+            p++;
+        }
+        int         key_len  = p - key;
+        const char *name     = key;
+        int         name_len = key_len;
+        if(key[0] != '-'){
+            if(reserveArray((void **)&(parser -> buf), &(parser -> buf_capacity), key_len + 2, sizeof(char)) != 0){
+                return OPTION_OUT_OF_MEMORY;
+            }
+            parser -> buf[0] = '-';
+            parser -> buf[1] = '-';
+            memcpy(parser->buf + 2, key, key_len);
+            name     = parser -> buf;
+            name_len = key_len + 2;
+        }
+        int prop_i = lookupOptProp(db, name, name_len);
+        if(prop_i == -1){
+            return OPTION_UNKNOWN_CONFIG_KEY;
+        }
+
+        while(p < eol && rsp_char_class[(unsigned char)*p] == 1){
+            p++;
+        }
+        if(p < eol && *p == '='){
+            p++;
+        }
+        ret = decodeDefaultOpt(db, prop_i, p, eol, &(config -> unquoted), &(config -> toks), &(config -> tok_num), &(config -> tok_capacity));
+        if(ret != OPTION_SUCCESS){
+            return ret;
+        }
+    }
+    return OPTION_SUCCESS;
+}
+
+static void
+releaseOptConfig( /* 読み込んだ設定ファイルのマッピングとトークンを手放す. toksの領域は使い回す */
+        opt_config_t *config)
+{
+    if(config->map.addr){
+        munmap(config->map.addr, config->map.size);
+    }
+    config -> map.addr = NULL;
+    config -> map.size = 0;
+    freeArena(config -> unquoted);
+    config -> unquoted = NULL;
+    config -> tok_num  = 0;
+    config -> loaded   = false;
+}
+
+static void
+freeOptConfig(
+        opt_config_t *config)
+{
+    if(config){
+        releaseOptConfig(config);
+        free(config -> toks);
+        free(config);
+    }
+}
+
+static int /* option_errcode_tのどれか */
+loadOptConfig( /* parser->config_pathをparser->configに読み込む. 前回と同じファイルなら何もしない. ファイルが無ければトークンを空にする */
+        opt_parser_t *parser)
+{
+    opt_config_t *config = parser -> config;
+    struct stat   st;
+    int           fd;
+
+    if(!config){
+        if(!(config = (opt_config_t *)calloc(1, sizeof(opt_config_t)))){
+            return OPTION_OUT_OF_MEMORY;
+        }
+        OPT_STATS_COUNT_ALLOC(sizeof(opt_config_t));
+        parser -> config = config;
+    }
+
+    if((fd = open(parser->config_path, O_RDONLY | O_CLOEXEC)) == -1){
+        releaseOptConfig(config);
+        return OPTION_SUCCESS;
+    }
+    if(fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)){
+        close(fd);
+        releaseOptConfig(config);
+        return OPTION_SUCCESS;
+    }
+    if(config->loaded && config->dev == st.st_dev && config->ino == st.st_ino && config->size == st.st_size &&
+            config->mtime.tv_sec == st.st_mtim.tv_sec && config->mtime.tv_nsec == st.st_mtim.tv_nsec){
+        close(fd);
+        return config->status;
+    }
+
+    releaseOptConfig(config);
+    if(st.st_size > 0){
+        void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(addr == MAP_FAILED){
+            close(fd);
+            return OPTION_OUT_OF_MEMORY;
+        }
+        config -> map.addr = addr;
+        config -> map.size = st.st_size;
+    }
+    close(fd);
+
+    config -> status = decodeOptConfig(parser, config, (const char *)config->map.addr, config->map.size);
+    if(config->status == OPTION_OUT_OF_MEMORY){
+        /* メモリ不足は次の解析で読み直す */
+        releaseOptConfig(config);
+        return OPTION_OUT_OF_MEMORY;
+    }
+    config -> loaded = true;
+    config -> dev    = st.st_dev;
+    config -> ino    = st.st_ino;
+    config -> size   = st.st_size;
+    config -> mtime  = st.st_mtim;
+    return config->status;
+}
+
+static int /* option_errcode_tのどれか */
+decodeOptEnv( /* env_prefixで始まる環境変数をオプションとコンテンツのトークンにしてparser->toksに追加する. MYTOOL_DRY_RUN なら --dry-run として引く */
+        opt_parser_t *parser)
+{
+    const opt_property_db_t *db         = parser -> db;
+    size_t                   prefix_len = strlen(parser -> env_prefix);
+    int                      ret;
+
+    for(char **env = environ; env && *env; env++){
+        if(strncmp(*env, parser->env_prefix, prefix_len) != 0){
+            continue;
+        }
+
+        const char *name = *env + prefix_len;
+        const char *eq   = strchr(name, '=');
+        if(!eq || eq == name || eq - name > INT_MAX - 2){
+            continue;
+        }
+
+        int len = eq - name;
+        if(reserveArray((void **)&(parser -> buf), &(parser -> buf_capacity), len + 2, sizeof(char)) != 0){
+            return OPTION_OUT_OF_MEMORY;
+        }
+        parser -> buf[0] = '-';
+        parser -> buf[1] = '-';
+        for(int i=0; i<len; i++){
+            parser -> buf[i+2] = name[i] == '_' ? '-' : tolower((unsigned char)name[i]);
+        }
+
+        int prop_i = lookupOptProp(db, parser->buf, len + 2);
+        if(prop_i == -1){
+            continue;
+        }
+        ret = decodeDefaultOpt(db, prop_i, eq + 1, eq + 1 + strlen(eq + 1), &(parser -> unquoted), &(parser -> toks), &(parser -> tok_num), &(parser -> tok_capacity));
+        if(ret != OPTION_SUCCESS){
+            return ret;
+        }
+    }
+    return OPTION_SUCCESS;
+}
+
+static int /* option_errcode_tのどれか */
+mergeDefaultLayer( /* parser->toksのlayer番目以降に追加した1つの層のトークンの行き先を決める.
+                    * 上位の層で指定済みのオプションはコンテンツごと取り除き, 同じ層での2回目の指定は重複とする */
+        opt_parser_t      *parser,
+        int                layer,
+        opt_token_count_t *count) /* [mod] 行き先毎のトークンの数 */
+{
+    opt_token_t *toks = parser -> toks;
+    int          kept = layer;
+    int          ret;
+
+    for(int head=layer, tail; head < parser->tok_num; head=tail){
+        int       prop_i = toks[head].prop;
+        uint64_t *word   = &appearedBits(parser)[prop_i / 64];
+        uint64_t  bit    = (uint64_t)1 << (prop_i % 64);
+
+        for(tail=head+1; tail < parser->tok_num && toks[tail].forced; tail++){
+        }
+
+        if(*word & bit){
+            for(int i=layer; i<kept; i++){
+                if(!toks[i].forced && toks[i].prop == prop_i){
+                    return OPTION_DUPLICATE_SAME_OPT;
+                }
+            }
+            continue;
+        }
+        /* 偽を指定したオプションは下位の層の指定を打ち消すだけで結果には現れない.
+         * 同じ層での2回目の指定を重複として見つけられるよう, 層を読み終えるまでは印として残す */
+        if(!toks[head].view.str){
+            *word |= bit;
+            toks[kept++] = toks[head];
+            continue;
+        }
+
+        for(int i=head; i<tail; i++){
+            toks[kept] = toks[i];
+            if((ret = classifyToken(parser, &toks[kept], count)) != OPTION_SUCCESS){
+                return ret;
+            }
+            kept++;
+        }
+    }
+
+    /* 偽の印を取り除く */
+    int tok_num = layer;
+    for(int i=layer; i<kept; i++){
+        if(toks[i].forced || toks[i].view.str){
+            toks[tok_num++] = toks[i];
+        }
+    }
+    parser -> tok_num = tok_num;
+    return OPTION_SUCCESS;
+}
+
+static int /* option_errcode_tのどれか */
+mergeOptDefaults( /* argvのトークンの行き先を決めた後に, 環境変数と設定ファイルの層を優先度の順に追加して1回の走査で行き先を決める */
+        opt_parser_t      *parser,
+        opt_token_count_t *count) /* [mod] 行き先毎のトークンの数 */
+{
+    int argv_num = parser -> tok_num;
+    int layer;
+    int ret;
+
+    if(parser->env_prefix){
+        layer = parser -> tok_num;
+        if((ret = decodeOptEnv(parser)) != OPTION_SUCCESS || (ret = mergeDefaultLayer(parser, layer, count)) != OPTION_SUCCESS){
+            return ret;
+        }
+    }
+
+    if(parser->config_path){
+        if((ret = loadOptConfig(parser)) != OPTION_SUCCESS){
+            return ret;
+        }
+        opt_config_t *config = parser -> config;
+        layer = parser -> tok_num;
+        if(reserveArray((void **)&(parser -> toks), &(parser -> tok_capacity), layer + config->tok_num, sizeof(opt_token_t)) != 0){
+            return OPTION_OUT_OF_MEMORY;
+        }
+        memcpy(parser->toks + layer, config->toks, sizeof(opt_token_t)*config->tok_num);
+        parser -> tok_num += config -> tok_num;
+        if((ret = mergeDefaultLayer(parser, layer, count)) != OPTION_SUCCESS){
+            return ret;
+        }
+    }
+
+    /* argvのトークンはclassifyTokensで調べ済みなので, 補ったトークンだけを調べる */
+    switch(checkContentsNum(parser->db, parser->tok_num - argv_num, parser->toks + argv_num)){
+        case 1:
+            return OPTION_TOO_MANY_CONTENTS;
+
+        case 2:
+            return OPTION_TOO_LITTLE_CONTENTS;
+
+        default:
+            return OPTION_SUCCESS;
+    }
+}
+
+void
+setOptDefaultSources(
+        opt_parser_t *parser,
+        const char   *config_path,
+        const char   *env_prefix)
+{
+    parser -> config_path = config_path;
+    parser -> env_prefix  = env_prefix;
+}
+
+/* ============================================== */
+
+int
+initOptParser(
+        opt_parser_t            *parser,
+        const opt_property_db_t *opt_prop_db)
+{
+    if(!opt_prop_db){
+        return OPTION_OPT_PROP_DB_IS_NULL;
+    }
+    ensureOptIdx(opt_prop_db);
+
+    parser -> db            = opt_prop_db;
+    parser -> toks          = NULL;
+    parser -> tok_capacity  = 0;
+    parser -> buf           = NULL;
+    parser -> buf_capacity  = 0;
+    parser -> rsp_depth_max = 0;
+    parser -> rsp_num       = 0;
+    parser -> rsp_capacity  = 0;
+    parser -> rsp_top       = -1;
+    parser -> rsps          = NULL;
+    parser -> unquoted      = NULL;
+    parser -> config_path   = NULL;
+    parser -> env_prefix    = NULL;
+    parser -> config        = NULL;
+    parser -> stats         = NULL;
+
+    /* 指定済みのオプションはビット集合で持つので, 解析毎の初期化は(prop_num+63)/64語を0にするだけで済む */
+    parser -> appeared_words = (opt_prop_db->prop_num + 63) / 64;
+    parser -> appeared       = NULL;
+    if(parser->appeared_words > OPT_APPEARED_INLINE_WORDS &&
+            !(parser->appeared = (uint64_t *)calloc(parser->appeared_words, sizeof(uint64_t)))){
+        return OPTION_OUT_OF_MEMORY;
+    }
+
+    resetOptParser(parser);
+    return OPTION_SUCCESS;
+}
+
+void
+freeOptParser(
+        opt_parser_t *parser)
+{
+    free(parser -> appeared);
+    parser -> appeared = NULL;
+    free(parser -> toks);
+    parser -> toks = NULL;
+    free(parser -> buf);
+    parser -> buf = NULL;
+    releaseRspFiles(parser);
+    free(parser -> rsps);
+    parser -> rsps = NULL;
+    freeOptConfig(parser -> config);
+    parser -> config = NULL;
+}
+
+void
+setOptRspFileDepth(
+        opt_parser_t *parser,
+        int           depth_max)
+{
+    parser -> rsp_depth_max = depth_max > 0 ? depth_max : 0;
+}
+
+int
+setOptStats(
+        opt_parser_t *parser,
+        opt_stats_t  *stats)
+{
+#ifdef OPT_STATS
+    parser -> stats = stats;
+    return OPTION_SUCCESS;
+#else
+    (void)parser;
+    (void)stats;
+    return OPTION_STATS_DISABLED;
+#endif
+}
+
+static void*
+mallocOptGroupDB( /* buildOptGroupDBの既定の確保関数 */
+        void   *ctx,
+        size_t  size)
+{
+    (void)ctx;
+    OPT_STATS_COUNT_ALLOC(size);
+    return malloc(size);
+}
+
+static int /* option_errcode_tのどれか */
+fillOptGroupDB( /* 行き先を決め終えたparser->toksを複製して結果を格納する1つのメモリ領域をalloc_funcで確保する */
+        opt_parser_t             *parser,
+        const opt_token_count_t  *count,                              /* [in] classifyTokensで数えたトークンの数 */
+        void                   *(*alloc_func)(void *ctx, size_t size), /* 結果のメモリ領域を確保する関数. 失敗したらNULLを返す */
+        void                     *alloc_ctx,                           /* alloc_funcの第1引数 */
+        opt_group_db_t          **opt_grp_db)
+{
+    int          grp_num     = count -> grp_num;
+    int          content_num = count -> content_num;
+    int          optless_num = count -> optless_num;
+    int          value_num   = count -> value_num;
+    int          tok_num     = parser -> tok_num;
+    opt_token_t *toks        = parser -> toks;
+    int          ret;
+
+    OPT_STATS_BEGIN(parser->stats, fill_begin);
+
+    /* 結果は [opt_group_db_t][opt_group_tの配列][コンテンツのポインタの平坦な配列][解釈した値の平坦な配列][grp_idx][文字列の複製] の順に1つのメモリ領域に詰める.
+     * 各opt_group_tのcontentsとvaluesは平坦な配列の一部を指すので, freeOptGroupDBは1回のfreeで全てを開放できる */
+    int    prop_num = parser -> db -> prop_num;
+    size_t str_size = 0;
+    for(int i=0; i<tok_num; i++){
+        str_size += toks[i].view.len + 1;
+    }
+
+    opt_group_db_t *db = (opt_group_db_t *)alloc_func(alloc_ctx,
+            sizeof(opt_group_db_t) + sizeof(opt_group_t)*grp_num + sizeof(char *)*(content_num+optless_num) + sizeof(opt_value_t)*value_num
+            + sizeof(int)*prop_num + str_size);
+    if(!db){
+        return OPTION_OUT_OF_MEMORY;
+    }
+    db -> grp_num     = 0;
+    db -> grps        = (opt_group_t *)&db[1];
+    db -> optless_num = 0;
+    db -> optless     = (char **)&(db -> grps[grp_num]) + content_num;
+    db -> prop_num    = prop_num;
+    db -> grp_idx     = (int *)((opt_value_t *)&(db -> optless[optless_num]) + value_num);
+    memset(db->grp_idx, 0xff, sizeof(int)*prop_num); /* 全て-1にする */
+
+    const opt_property_t *props    = parser -> db -> props;
+    char                **contents = (char **)&(db -> grps[grp_num]);
+    opt_value_t          *values   = (opt_value_t *)&(db -> optless[optless_num]);
+    char                 *str      = (char *)&(db -> grp_idx[prop_num]);
+    opt_group_t          *grp      = NULL; /* 直前のオプションのグループ */
+    for(int i=0; i<tok_num; i++){
+        memcpy(str, toks[i].view.str, toks[i].view.len);
+        str[toks[i].view.len] = '\0';
+
+        switch(toks[i].dest){
+            case JD_OPT_GRP_DBs_CONTENTS:
+                db -> optless[db->optless_num++] = str;
+                break;
+
+            case JD_OPT_GRPs_CONTENTS:
+                /* 文字列と同時に1回だけ解釈するので, 利用者がatoiなどで再び変換する必要は無い */
+                if(grp->values && parseOptValue(&props[grp->prop_id], str, toks[i].view.len, values++) != 0){
+                    if(alloc_func == mallocOptGroupDB){
+                        free(db);
+                    }
+                    return OPTION_INVALID_VALUE;
+                }
+                grp -> content_num++;
+                *contents++ = str;
+                break;
+
+            case JD_OPT_GRPs_OPTION:
+                grp                                 = &(db -> grps[db->grp_num]);
+                db -> grps[db->grp_num].option      = str;
+                db -> grps[db->grp_num].content_num = 0;
+                db -> grps[db->grp_num].contents    = contents;
+                db -> grps[db->grp_num].err_code    = 0;
+                db -> grps[db->grp_num].prop_id     = toks[i].prop;
+                db -> grps[db->grp_num].values      = props[toks[i].prop].value_type != OPT_VALUE_NONE ? values : NULL;
+                db -> grp_idx[toks[i].prop]         = db -> grp_num;
+                db -> grp_num++;
+                break;
+        }
+        str += toks[i].view.len + 1;
+    }
+
+    /* 文字列は複製したので応答ファイルとその作業領域はもう不要 */
+    releaseRspFiles(parser);
+    OPT_STATS_END(parser->stats, fill_begin, fill_ns);
+
+    OPT_STATS_BEGIN(parser->stats, checker_begin);
+    ret = adaptContentsChecker(parser, db);
+    OPT_STATS_END(parser->stats, checker_begin, checker_ns);
+    if(ret != 0){
+        /* アリーナから確保した場合はアリーナと共に開放される */
+        if(alloc_func == mallocOptGroupDB){
+            free(db);
+        }
+        return OPTION_OUT_OF_MEMORY;
+    }
+    *opt_grp_db = db;
+    return OPTION_SUCCESS;
+}
+
+static int /* option_errcode_tのどれか */
+buildOptGroupDB( /* groupingOptWithParserの本体. 結果を格納する1つのメモリ領域をalloc_funcで確保する */
+        opt_parser_t     *parser,
+        int               argc,
+        char            **argv,
+        void           *(*alloc_func)(void *ctx, size_t size), /* 結果のメモリ領域を確保する関数. 失敗したらNULLを返す */
+        void             *alloc_ctx,                           /* alloc_funcの第1引数 */
+        opt_group_db_t  **opt_grp_db)
+{
+    opt_token_count_t count;
+    int               ret;
+
+    *opt_grp_db = NULL;
+
+    resetOptParser(parser);
+
+    OPT_STATS_BEGIN(parser->stats, decode_begin);
+    ret = decodeOptions(parser, argc, argv);
+    OPT_STATS_END(parser->stats, decode_begin, decode_ns);
+    if(ret != OPTION_SUCCESS){
+        return ret;
+    }
+    if((ret = classifyTokens(parser, &count)) != OPTION_SUCCESS){
+        return ret;
+    }
+    if(parser->env_prefix || parser->config_path){
+        OPT_STATS_BEGIN(parser->stats, defaults_begin);
+        ret = mergeOptDefaults(parser, &count);
+        OPT_STATS_END(parser->stats, defaults_begin, defaults_ns);
+        if(ret != OPTION_SUCCESS){
+            return ret;
+        }
+    }
+    return fillOptGroupDB(parser, &count, alloc_func, alloc_ctx, opt_grp_db);
+}
+
+int
+groupingOptWithParser(
+        opt_parser_t     *parser,
+        int               argc,
+        char            **argv,
+        opt_group_db_t  **opt_grp_db)
+{
+    OPT_STATS_PARSE_BEGIN(parser->stats, begin, counter);
+    int ret = buildOptGroupDB(parser, argc, argv, mallocOptGroupDB, NULL, opt_grp_db);
+    OPT_STATS_PARSE_END(parser->stats, begin, counter, ret, parser->tok_num, *opt_grp_db ? (*opt_grp_db)->grp_num : 0);
+    return ret;
+}
+
+int
+groupingOpt(
+        const opt_property_db_t *opt_prop_db,
+        int                      argc,
+        char                   **argv,
+        opt_group_db_t         **opt_grp_db) 
+{
+    opt_parser_t parser;
+    int          ret;
+
+    *opt_grp_db = NULL;
+
+    if((ret = initOptParser(&parser, opt_prop_db)) != OPTION_SUCCESS){
+        return ret;
+    }
+    ret = groupingOptWithParser(&parser, argc, argv, opt_grp_db);
+    freeOptParser(&parser);
+    return ret;
+}
+
+static int /* option_errcode_tのどれか */
+buildOptViewGroupDB( /* groupingOptViewWithParserの本体 */
+        opt_parser_t         *parser,
+        int                   argc,
+        char                **argv,
+        opt_view_group_db_t **opt_grp_db)
+{
+    *opt_grp_db = NULL;
+
+    opt_token_count_t count;
+    int               ret;
+
+    resetOptParser(parser);
+
+    OPT_STATS_BEGIN(parser->stats, decode_begin);
+    ret = decodeOptions(parser, argc, argv);
+    OPT_STATS_END(parser->stats, decode_begin, decode_ns);
+    if(ret != OPTION_SUCCESS){
+        return ret;
+    }
+
+    if((ret = classifyTokens(parser, &count)) != OPTION_SUCCESS){
+        return ret;
+    }
+
+    int          grp_num     = count.grp_num;
+    int          content_num = count.content_num;
+    int          optless_num = count.optless_num;
+    int          value_num   = count.value_num;
+    int          tok_num     = parser -> tok_num;
+    opt_token_t *toks        = parser -> toks;
+
+    OPT_STATS_BEGIN(parser->stats, fill_begin);
+
+    /* 結果はグループの配列とビューの配列と応答ファイルのマッピングとgrp_idxをまとめた1つのメモリ領域に格納するので, トークンの数によらず確保は1回で済む */
+    int                  prop_num = parser -> db -> prop_num;
+    opt_view_group_db_t *db       = (opt_view_group_db_t *)malloc(
+            sizeof(opt_view_group_db_t) + sizeof(opt_view_group_t)*grp_num + sizeof(opt_view_t)*(content_num+optless_num)
+            + sizeof(opt_mapping_t)*parser->rsp_num + sizeof(opt_value_t)*value_num + sizeof(int)*prop_num);
+    if(!db){
+        return OPTION_OUT_OF_MEMORY;
+    }
+    OPT_STATS_COUNT_ALLOC(sizeof(opt_view_group_db_t) + sizeof(opt_view_group_t)*grp_num + sizeof(opt_view_t)*(content_num+optless_num)
+            + sizeof(opt_mapping_t)*parser->rsp_num + sizeof(opt_value_t)*value_num + sizeof(int)*prop_num);
+    db -> grp_num     = 0;
+    db -> grps        = (opt_view_group_t *)&db[1];
+    db -> optless_num = 0;
+    db -> optless     = (opt_view_t *)&(db -> grps[grp_num]) + content_num;
+    db -> map_num     = 0;
+    db -> maps        = (opt_mapping_t *)&(db -> optless[optless_num]);
+    db -> unquoted    = NULL;
+    db -> prop_num    = prop_num;
+    db -> grp_idx     = (int *)((opt_value_t *)&(db -> maps[parser->rsp_num]) + value_num);
+    memset(db->grp_idx, 0xff, sizeof(int)*prop_num); /* 全て-1にする */
+
+    const opt_property_t *props    = parser -> db -> props;
+    opt_view_t           *contents = (opt_view_t *)&(db -> grps[grp_num]);
+    opt_value_t          *values   = (opt_value_t *)&(db -> maps[parser->rsp_num]);
+    opt_view_group_t     *grp      = NULL; /* 直前のオプションのグループ */
+    for(int i=0; i<tok_num; i++){
+        switch(toks[i].dest){
+            case JD_OPT_GRP_DBs_CONTENTS:
+                db -> optless[db->optless_num++] = toks[i].view;
+                break;
+
+            case JD_OPT_GRPs_CONTENTS:
+                if(grp->values && parseOptValue(&props[grp->prop_id], toks[i].view.str, toks[i].view.len, values++) != 0){
+                    free(db);
+                    return OPTION_INVALID_VALUE;
+                }
+                grp -> content_num++;
+                *contents++ = toks[i].view;
+                break;
+
+            case JD_OPT_GRPs_OPTION:
+                grp                                 = &(db -> grps[db->grp_num]);
+                db -> grps[db->grp_num].option      = toks[i].view;
+                db -> grps[db->grp_num].content_num = 0;
+                db -> grps[db->grp_num].contents    = contents;
+                db -> grps[db->grp_num].err_code    = 0;
+                db -> grps[db->grp_num].prop_id     = toks[i].prop;
+                db -> grps[db->grp_num].values      = props[toks[i].prop].value_type != OPT_VALUE_NONE ? values : NULL;
+                db -> grp_idx[toks[i].prop]         = db -> grp_num;
+                db -> grp_num++;
+                break;
+        }
+    }
+
+    OPT_STATS_END(parser->stats, fill_begin, fill_ns);
+
+    OPT_STATS_BEGIN(parser->stats, checker_begin);
+    ret = adaptContentsCheckerView(parser, db);
+    OPT_STATS_END(parser->stats, checker_begin, checker_ns);
+    if(ret != 0){
+        free(db);
+        return OPTION_OUT_OF_MEMORY;
+    }
+
+    /* ビューが応答ファイルを指しているのでマッピングと引用符を取り除いたトークンを結果に引き渡す */
+    for(int i=0; i<parser->rsp_num; i++){
+        db -> maps[db->map_num++] = parser -> rsps[i].map;
+    }
+    parser -> rsp_num  = 0;
+    db -> unquoted     = parser -> unquoted;
+    parser -> unquoted = NULL;
+
+    *opt_grp_db = db;
+    return OPTION_SUCCESS;
+}
+
+int
+groupingOptViewWithParser(
+        opt_parser_t         *parser,
+        int                   argc,
+        char                **argv,
+        opt_view_group_db_t **opt_grp_db)
+{
+    OPT_STATS_PARSE_BEGIN(parser->stats, begin, counter);
+    int ret = buildOptViewGroupDB(parser, argc, argv, opt_grp_db);
+    OPT_STATS_PARSE_END(parser->stats, begin, counter, ret, parser->tok_num, *opt_grp_db ? (*opt_grp_db)->grp_num : 0);
+    return ret;
+}
+
+int
+groupingOptView(
+        const opt_property_db_t *opt_prop_db,
+        int                      argc,
+        char                   **argv,
+        opt_view_group_db_t    **opt_grp_db)
+{
+    opt_parser_t parser;
+    int          ret;
+
+    *opt_grp_db = NULL;
+
+    if((ret = initOptParser(&parser, opt_prop_db)) != OPTION_SUCCESS){
+        return ret;
+    }
+    ret = groupingOptViewWithParser(&parser, argc, argv, opt_grp_db);
+    freeOptParser(&parser);
+    return ret;
+}
+
+opt_group_t*
+getOptGroup(
+        const opt_group_db_t *opt_grp_db,
+        int                   prop_id)
+{
+    if(!opt_grp_db || prop_id < 0 || prop_id >= opt_grp_db->prop_num || opt_grp_db->grp_idx[prop_id] == -1){
+        return NULL;
+    }
+    return &(opt_grp_db -> grps[opt_grp_db->grp_idx[prop_id]]);
+}
+
+opt_view_group_t*
+getOptViewGroup(
+        const opt_view_group_db_t *opt_grp_db,
+        int                        prop_id)
+{
+    if(!opt_grp_db || prop_id < 0 || prop_id >= opt_grp_db->prop_num || opt_grp_db->grp_idx[prop_id] == -1){
+        return NULL;
+    }
+    return &(opt_grp_db -> grps[opt_grp_db->grp_idx[prop_id]]);
+}
+
+void
+freeOptGroupDB(
+        opt_group_db_t *opt_grp_db)
+{
+    /* groupingOptは結果を1つのメモリ領域に格納している */
+    free(opt_grp_db);
+}
+
+void
+freeOptViewGroupDB(
+        opt_view_group_db_t *opt_grp_db)
+{
+    if(!opt_grp_db){
+        return;
+    }
+    for(int i=0; i<opt_grp_db->map_num; i++){
+        munmap(opt_grp_db->maps[i].addr, opt_grp_db->maps[i].size);
+    }
+    freeArena(opt_grp_db -> unquoted);
+    /* groupingOptViewは結果を1つのメモリ領域に格納している */
+    free(opt_grp_db);
+}
+
+/* ============================================== */
+
+/* opt_command_tのdbがNULLの場合に用いる, オプションを1つも持たないopt_property_db_t */
+static int               opt_empty_idx[1]  = {-1};
+static opt_property_db_t opt_empty_prop_db = {
+    .idx_size  = 1,
+    .idx       = opt_empty_idx,
+    .idx_state = OPT_IDX_BUILT,
+};
+
+static const opt_command_t* /* nameの先頭len文字に一致するサブコマンド. 無ければNULL */
+findOptCommand( /* subsはnameの昇順なので二分探索する */
+        const opt_command_t *command,
+        const char          *name,
+        int                  len)
+{
+    int lo = 0;
+    int hi = command->sub_num - 1;
+
+    while(lo <= hi){
+        int mid = (lo + hi) / 2;
+        int cmp = strncmp(command->subs[mid].name, name, len);
+        if(cmp == 0 && command->subs[mid].name[len] != '\0'){
+            cmp = 1;
+        }
+        if(cmp == 0){
+            return &(command -> subs[mid]);
+        }
+        if(cmp < 0){
+            lo = mid + 1;
+        }
+        else{
+            hi = mid - 1;
+        }
+    }
+    return NULL;
+}
+
+static int /* option_errcode_tのどれか */
+classifyCommandTokens( /* argvの*arg_i番目から順にトークンに切り出して行き先を決め, サブコマンドの名前に当たったらそこで止める */
+        opt_parser_t         *parser,
+        const opt_command_t  *command,
+        int                   argc,
+        char                **argv,
+        int                  *arg_i,  /* [mod] 次に読むargvの添字. サブコマンドに当たったらその次を指す */
+        opt_token_count_t    *count,  /* [out] commandの引数の行き先毎のトークンの数 */
+        const opt_command_t **sub)    /* [out] 当たったサブコマンド. 無ければNULL */
+{
+    int ret;
+
+    memset(count, 0, sizeof(opt_token_count_t));
+    *sub = NULL;
+
+    while(*arg_i < argc){
+        int         first = parser -> tok_num;
+        const char *arg   = argv[(*arg_i)++];
+        size_t      len   = strlen(arg);
+        if(len > INT_MAX){
+            return OPTION_OUT_OF_MEMORY;
+        }
+        if((ret = decodeRspArg(parser, arg, len, 0, arg[0] == '@')) != OPTION_SUCCESS ||
+                (ret = decodeRspFiles(parser, INT_MAX)) != OPTION_SUCCESS){
+            return ret;
+        }
+
+        for(int i=first; i<parser->tok_num; i++){
+            opt_token_t *tok = &(parser -> toks[i]);
+            if((ret = classifyToken(parser, tok, count)) != OPTION_SUCCESS){
+                return ret;
+            }
+            /* オプションでもそのコンテンツでもない1つの引数がサブコマンドの名前なら, このコマンドの引数はここまでになる */
+            if(tok->dest == JD_OPT_GRP_DBs_CONTENTS && parser->tok_num == first + 1 &&
+                    (*sub = findOptCommand(command, tok->view.str, tok->view.len)) != NULL){
+                parser -> tok_num = first;
+                count -> optless_num--;
+                return checkTokensContentsNum(parser);
+            }
+        }
+    }
+    return checkTokensContentsNum(parser);
+}
+
+static void*
+allocOptCommandGroupDB( /* fillOptGroupDBの確保関数. opt_command_group_db_tをグルーピング結果と同じメモリ領域の先頭に置く */
+        void   *ctx,  /* [out] 確保したopt_command_group_db_tの格納先(opt_command_group_db_t **) */
+        size_t  size)
+{
+    opt_command_group_db_t *node = (opt_command_group_db_t *)malloc(sizeof(opt_command_group_db_t) + size);
+
+    *(opt_command_group_db_t **)ctx = node;
+    return node ? &node[1] : NULL;
+}
+
+int
+groupingOptCommand(
+        const opt_command_t      *root,
+        int                       argc,
+        char                    **argv,
+        opt_command_group_db_t  **cmd_grp_db)
+{
+    opt_command_group_db_t **tail    = cmd_grp_db;
+    const opt_command_t     *command = root;
+    int                      arg_i   = 1;
+    int                      ret     = OPTION_SUCCESS;
+
+    *cmd_grp_db = NULL;
+
+    while(command && ret == OPTION_SUCCESS){
+        opt_parser_t            parser;
+        opt_token_count_t       count;
+        const opt_command_t    *sub  = NULL;
+        opt_command_group_db_t *node = NULL;
+        opt_group_db_t         *grp_db;
+
+        /* 辿ったコマンドのopt_property_db_tだけをここで初めて初期化する. 初期化に失敗してもfreeOptParserを呼べるようにする */
+        memset(&parser, 0, sizeof(opt_parser_t));
+        ret = initOptParser(&parser, command->db ? command->db : &opt_empty_prop_db);
+        if(ret == OPTION_SUCCESS){
+            ret = classifyCommandTokens(&parser, command, argc, argv, &arg_i, &count, &sub);
+        }
+        if(ret == OPTION_SUCCESS){
+            ret = fillOptGroupDB(&parser, &count, allocOptCommandGroupDB, &node, &grp_db);
+            if(ret == OPTION_SUCCESS){
+                node -> command = command;
+                node -> grp_db  = grp_db;
+                node -> sub     = NULL;
+                *tail           = node;
+                tail            = &(node -> sub);
+            }
+            else{
+                free(node);
+            }
+        }
+        freeOptParser(&parser);
+        command = sub;
+    }
+
+    if(ret != OPTION_SUCCESS){
+        freeOptCommandGroupDB(*cmd_grp_db);
+        *cmd_grp_db = NULL;
+    }
+    return ret;
+}
+
+void
+freeOptCommandGroupDB(
+        opt_command_group_db_t *cmd_grp_db)
+{
+    while(cmd_grp_db){
+        opt_command_group_db_t *sub = cmd_grp_db -> sub;
+        /* グルーピング結果は同じメモリ領域に格納している */
+        free(cmd_grp_db);
+        cmd_grp_db = sub;
+    }
+}
+
+/* ============================================== */
+
+#define OPT_NAMES_INSERTION_SORT_MAX 16 /* sortOptNamesで振り分けずに挿入ソートで並べる名前の数 */
+
+static void
+sortOptNames( /* namesをdepth文字目以降の辞書順に並べる. 文字毎に数えてその場で振り分ける基数ソートで, 比較の回数が名前の数の対数倍にならない */
+        opt_name_t *names,
+        int         num,
+        int         depth)
+{
+    int count[256];
+    int next[256];
+
+    while(num > OPT_NAMES_INSERTION_SORT_MAX){
+        memset(count, 0, sizeof(count));
+        for(int i=0; i<num; i++){
+            count[(unsigned char)names[i].name[depth]]++;
+        }
+
+        /* 全ての名前がこの文字で一致していれば, 次の文字に進むだけでよい. 長い共通の接頭辞で再帰が深くならないようにする */
+        unsigned char c = names[0].name[depth];
+        if(count[c] == num){
+            if(c == '\0'){
+                return;
+            }
+            depth++;
+            continue;
+        }
+
+        next[0] = 0;
+        for(int b=1; b<256; b++){
+            next[b] = next[b-1] + count[b-1];
+        }
+        /* 各名前を自身の文字のバケツに入るまで玉突きで入れ替える */
+        for(int b=0, start=0; b<256; start += count[b], b++){
+            while(next[b] < start + count[b]){
+                opt_name_t    name = names[next[b]];
+                unsigned char k    = name.name[depth];
+                while(k != b){
+                    opt_name_t tmp = names[next[k]];
+                    names[next[k]++] = name;
+                    name = tmp;
+                    k    = name.name[depth];
+                }
+                names[next[b]++] = name;
+            }
+        }
+
+        /* NUL終端のバケツは同じ名前なので並べなくてよい */
+        for(int b=1, start=count[0]; b<256; start += count[b], b++){
+            if(count[b] > 1){
+                sortOptNames(names + start, count[b], depth+1);
+            }
+        }
+        return;
+    }
+
+    for(int i=1; i<num; i++){
+        opt_name_t name = names[i];
+        int        j    = i;
+        while(j > 0 && strcmp(names[j-1].name + depth, name.name + depth) > 0){
+            names[j] = names[j-1];
+            j--;
+        }
+        names[j] = name;
+    }
+}
+
+static void
+ensureOptNames( /* 全ての名前を辞書順に並べた索引を最初の1回だけ構築する. 複数のスレッドから同時に呼ばれてもよい */
+        const opt_property_db_t *opt_prop_db)
+{
+    /* 静的なopt_property_db_tでもnamesとnames_stateは書き換えられる領域に置かれている */
+    opt_property_db_t *db    = (opt_property_db_t *)opt_prop_db;
+    int                state = OPT_IDX_EMPTY;
+
+    if(atomic_load_explicit(&db->names_state, memory_order_acquire) == OPT_IDX_BUILT){
+        return;
+    }
+
+    if(atomic_compare_exchange_strong_explicit(&db->names_state, &state, OPT_IDX_BUILDING, memory_order_acq_rel, memory_order_acquire)){
+        int name_num = 0;
+        for(int i=0; i<db->reg_num; i++){
+            db -> names[name_num++] = (opt_name_t){db->props[i].short_form, i};
+            if(db->props[i].long_form){
+                db -> names[name_num++] = (opt_name_t){db->props[i].long_form, i};
+            }
+        }
+        sortOptNames(db->names, name_num, 0);
+
+        /* 同じ名前は隣り合うので, lookupOptPropと同様に先に登録されたオプションを残す */
+        db -> name_num = 0;
+        for(int i=0; i<name_num; i++){
+            if(db->name_num > 0 && strcmp(db->names[db->name_num-1].name, db->names[i].name) == 0){
+                opt_name_t *last = &(db -> names[db->name_num-1]);
+                last -> prop = last->prop < db->names[i].prop ? last->prop : db->names[i].prop;
+                continue;
+            }
+            db -> names[db->name_num++] = db -> names[i];
+        }
+        atomic_store_explicit(&db->names_state, OPT_IDX_BUILT, memory_order_release);
+        return;
+    }
+
+    while(atomic_load_explicit(&db->names_state, memory_order_acquire) != OPT_IDX_BUILT){
+        sched_yield();
+    }
+}
+
+static int /* strncmp(name, prefix, len)がupper未満になる名前の数. upperが0なら接頭辞の範囲の先頭, 1なら末尾の次の添字になる */
+searchOptNames( /* namesは辞書順なので, prefixで始まる名前は連続していて二分探索で範囲が分かる */
+        const opt_property_db_t *db,
+        const char              *prefix,
+        int                      len,
+        int                      upper)
+{
+    int lo = 0;
+    int hi = db -> name_num;
+
+    while(lo < hi){
+        int mid = (lo + hi) / 2;
+        if(strncmp(db->names[mid].name, prefix, len) < upper){
+            lo = mid + 1;
+        }
+        else{
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static int /* 候補の総数 */
+completeOptEnum( /* enum_namesのうちprefixで始まるものを候補にする. enum_namesは短いので順に調べる */
+        const opt_property_t  *prop,
+        const char            *prefix,
+        const char           **cands,
+        int                    cand_max)
+{
+    int cand_num = 0;
+    int len;
+
+    if(!prop->enum_names){
+        return 0;
+    }
+    len = strlen(prefix);
+    for(int i=0; prop->enum_names[i]; i++){
+        if(strncmp(prop->enum_names[i], prefix, len) == 0){
+            if(cand_num < cand_max){
+                cands[cand_num] = prop -> enum_names[i];
+            }
+            cand_num++;
+        }
+    }
+    return cand_num;
+}
+
+static int /* wordがオプションならそのpropsの添字. そうでなければ-1 */
+scanCompletedWord( /* decodeArgと同様にwordを見分け, オプションならそのコンテンツの数をcontent_numに格納する. メモリを確保しないように切り出したトークンは保持しない */
+        const opt_property_db_t *db,
+        const char              *word,
+        int                     *content_num) /* [out] --long=a,b や -ofile のようにword自身に含まれるコンテンツの数 */
+{
+    int         len = strlen(word);
+    const char *eq  = strchr(word, '=');
+    int         prop_i;
+
+    *content_num = 0;
+    if((prop_i = lookupOptProp(db, word, len)) != -1){
+        return prop_i;
+    }
+
+    if(eq && (prop_i = lookupLongForm(db, word, eq - word)) >= 0){
+        for(const char *head = eq+1; *head;){
+            const char *tail = strchrnul(head, ',');
+            *content_num += tail != head;
+            head          = *tail ? tail+1 : tail;
+        }
+        return prop_i;
+    }
+
+    if(db->abbrev && len > 2 && word[0] == '-' && word[1] == '-' && (prop_i = matchOptAbbrev(db, word, len)) >= 0){
+        return prop_i;
+    }
+
+    /* 束ねた短縮形式は最後のオプションだけがコンテンツを取れる */
+    if(len > 2 && word[0] == '-' && db->short_idx[(unsigned char)word[1]] != 0){
+        for(int i=1; i<len; i++){
+            prop_i = db->short_idx[(unsigned char)word[i]] - 1;
+            if(prop_i == -1 || word[i] == '-'){
+                return -1;
+            }
+            if(db->props[prop_i].content_num_max > 0){
+                *content_num = i+1 < len;
+                break;
+            }
+        }
+        return prop_i;
+    }
+    return -1;
+}
+
+int
+completeOpt(
+        const opt_property_db_t  *opt_prop_db,
+        int                       word_num,
+        char                    **words,
+        int                       word_i,
+        int                      *cand_pos,
+        const char              **cands,
+        int                       cand_max)
+{
+    const char *word;
+    int         prop_i  = -1; /* words[word_i]の直前で開いているオプション */
+    int         content = 0;  /* prop_iに付属したコンテンツの数 */
+
+    *cand_pos = 0;
+    if(!opt_prop_db || word_num < 0 || word_i < 0){
+        return 0;
+    }
+    word = word_i < word_num ? words[word_i] : "";
+    ensureOptIdx(opt_prop_db);
+
+    if(word[0] == '-'){
+        const char *eq = strchr(word, '=');
+
+        /* --mode=fa,sa のように = の後ろを補完する場合は最後の要素だけを置き換える */
+        if(eq){
+            int opt_i = lookupLongForm(opt_prop_db, word, eq - word);
+            if(opt_i < 0 || opt_prop_db->props[opt_i].value_type != OPT_VALUE_ENUM){
+                return 0;
+            }
+            const char *head = strrchr(eq, ',');
+            head      = head ? head+1 : eq+1;
+            *cand_pos = head - word;
+            return completeOptEnum(&opt_prop_db->props[opt_i], head, cands, cand_max);
+        }
+
+        ensureOptNames(opt_prop_db);
+        int len   = strlen(word);
+        int begin = searchOptNames(opt_prop_db, word, len, 0);
+        int end   = searchOptNames(opt_prop_db, word, len, 1);
+        for(int i=begin; i<end && i-begin<cand_max; i++){
+            cands[i-begin] = opt_prop_db -> names[i].name;
+        }
+        return end - begin;
+    }
+
+    /* 直前までの単語を順に見て, words[word_i]がどのオプションのコンテンツになるかを調べる */
+    for(int i=1; i<word_i && i<word_num; i++){
+        int num;
+        int opt_i = scanCompletedWord(opt_prop_db, words[i], &num);
+
+        if(opt_i >= 0){
+            prop_i  = opt_i;
+            content = num;
+        }
+        else if(prop_i != -1 && content < opt_prop_db->props[prop_i].content_num_max){
+            content++;
+        }
+        else{
+            prop_i = -1;
+        }
+    }
+
+    if(prop_i == -1 || content >= opt_prop_db->props[prop_i].content_num_max || opt_prop_db->props[prop_i].value_type != OPT_VALUE_ENUM){
+        return 0;
+    }
+    return completeOptEnum(&opt_prop_db->props[prop_i], word, cands, cand_max);
+}
+
+/* ============================================== */
+
+int
+initOptIter(
+        opt_iter_t              *it,
+        const opt_property_db_t *opt_prop_db,
+        int                      argc,
+        char                   **argv)
+{
+    it -> argc             = argc;
+    it -> argv             = argv;
+    it -> arg_i            = 1;
+    it -> tok_i            = 0;
+    it -> judged           = false;
+    it -> content_capacity = 0;
+    it -> contents         = NULL;
+    it -> value_capacity   = 0;
+    it -> values           = NULL;
+    it -> refilled         = false;
+    it -> rsp_live         = 0;
+    it -> retired          = NULL;
+    /* initOptParserが途中で失敗してもfreeOptIterを呼べるようにする */
+    memset(&(it -> parser), 0, sizeof(opt_parser_t));
+    it -> status           = initOptParser(&(it -> parser), opt_prop_db);
+    return it->status;
+}
+
+static void
+retireIterWindow( /* 待ち行列を詰め直す前に, それまでの窓で引用符を取り除いたトークンを退避し, 各応答ファイルの読んだ位置に印を付ける.
+                   * 組み立て中のグループのコンテンツがまだ指しているので, 開放はreleaseIterWindowまで待つ */
+        opt_iter_t *it)
+{
+    opt_parser_t *parser = &(it -> parser);
+
+    if(parser->unquoted){
+        opt_arena_chunk_t *last = parser -> unquoted;
+        while(last->next){
+            last = last -> next;
+        }
+        last -> next       = it -> retired;
+        it -> retired      = parser -> unquoted;
+        parser -> unquoted = NULL;
+    }
+    for(int i=it->rsp_live; i<parser->rsp_num; i++){
+        parser -> rsps[i].mark = parser -> rsps[i].pos;
+    }
+    it -> refilled = true;
+}
+
+static void
+releaseIterWindow( /* 前のグループを返した後は, 待ち行列にある今の窓のトークンだけが生きている.
+                    * 前の窓までの引用符を取り除いたトークンを開放し, 応答ファイルの印より前のページを手放してRSSがファイルの大きさに比例しないようにする */
+        opt_iter_t *it)
+{
+    opt_parser_t *parser    = &(it -> parser);
+    size_t        page_size = sysconf(_SC_PAGESIZE);
+
+    freeArena(it -> retired);
+    it -> retired = NULL;
+
+    for(int i=it->rsp_live; i<parser->rsp_num; i++){
+        opt_rsp_file_t *rsp  = &(parser -> rsps[i]);
+        bool            done = rsp->mark == (const char *)rsp->map.addr + rsp->map.size;
+        /* 読み終えたファイルは最後のページまで, 読んでいる途中のファイルは印を含むページの手前まで手放す */
+        size_t          dead = done ? (rsp->map.size + page_size - 1) / page_size * page_size
+                                    : (size_t)(rsp->mark - (const char *)rsp->map.addr) / page_size * page_size;
+
+        if(dead > rsp->released){
+            madvise((char *)rsp->map.addr + rsp->released, dead - rsp->released, MADV_DONTNEED);
+            rsp -> released = dead;
+        }
+        if(done && i == it->rsp_live){
+            it -> rsp_live++;
+        }
+    }
+    it -> refilled = false;
+}
+
+static int /* option_errcode_tのどれか */
+peekIterToken( /* まだ返していない先頭のトークンを得る. 待ち行列が空ならargvの要素を1つずつ, 応答ファイルはOPT_RSP_WINDOW_TOKENSずつトークンに切り出す */
+        opt_iter_t   *it,
+        opt_token_t **tok) /* [out] 先頭のトークン. argvの終端に到達したらNULL */
+{
+    opt_parser_t *parser = &(it -> parser);
+    int           ret;
+
+    while(it->tok_i == parser->tok_num){
+        if(parser->rsp_top == -1 && it->arg_i >= it->argc){
+            *tok = NULL;
+            return OPTION_SUCCESS;
+        }
+        /* 待ち行列のトークンは全て返し終わったので先頭から詰め直す */
+        parser -> tok_num = 0;
+        it -> tok_i       = 0;
+        retireIterWindow(it);
+
+        /* 応答ファイルを読み終えるまではargvの次の要素に進まない */
+        if(parser->rsp_top != -1){
+            if((ret = decodeRspFiles(parser, OPT_RSP_WINDOW_TOKENS)) != OPTION_SUCCESS){
+                return ret;
+            }
+            continue;
+        }
+
+        const char *arg = it -> argv[it->arg_i++];
+        size_t      len = strlen(arg);
+        if(len > INT_MAX){
+            return OPTION_OUT_OF_MEMORY;
+        }
+        if((ret = decodeRspArg(parser, arg, len, 0, arg[0] == '@')) != OPTION_SUCCESS){
+            return ret;
+        }
+    }
+
+    *tok = &(parser -> toks[it->tok_i]);
+    return OPTION_SUCCESS;
+}
+
+static int /* option_errcode_tのどれか */
+judgeIterToken( /* 先頭のトークンの行き先を決める. 決め済みなら何もしない */
+        opt_iter_t   *it,
+        opt_token_t **tok) /* [out] 先頭のトークン. argvの終端に到達したらNULL */
+{
+    int ret;
+
+    if((ret = peekIterToken(it, tok)) != OPTION_SUCCESS || !*tok || it->judged){
+        return ret;
+    }
+
+    (*tok) -> dest = judgeDestination(&(it -> parser), *tok);
+    it -> judged   = true;
+    switch((*tok)->dest){
+        case JD_DUPLICATE_SAME_OPTION:
+            return OPTION_DUPLICATE_SAME_OPT;
+
+        case JD_TOO_MANY_CONTENTS:
+            return OPTION_TOO_MANY_CONTENTS;
+
+        case JD_TOO_LITTLE_CONTENTS:
+            return OPTION_TOO_LITTLE_CONTENTS;
+
+        default:
+            return OPTION_SUCCESS;
+    }
+}
+
+static int /* option_errcode_tのどれか */
+pushIterContent(
+        opt_iter_t *it,
+        int         content_num,
+        opt_view_t  view)
+{
+    if(reserveArray((void **)&(it -> contents), &(it -> content_capacity), content_num + 1, sizeof(opt_view_t)) != 0){
+        return OPTION_OUT_OF_MEMORY;
+    }
+    it -> contents[content_num] = view;
+    return OPTION_SUCCESS;
+}
+
+static int /* option_errcode_tのどれか */
+nextIterGroup(
+        opt_iter_t       *it,
+        opt_view_group_t *grp)
+{
+    opt_token_t *tok;
+    int          ret;
+
+    if(it->refilled){
+        releaseIterWindow(it);
+    }
+    if((ret = judgeIterToken(it, &tok)) != OPTION_SUCCESS){
+        return ret;
+    }
+    if(!tok){
+        return OPTION_ITER_END;
+    }
+    it -> tok_i++;
+    it -> judged = false;
+
+    grp -> err_code    = 0;
+    grp -> content_num = 0;
+    grp -> contents    = it -> contents;
+    grp -> values      = NULL;
+
+    if(tok->dest == JD_OPT_GRP_DBs_CONTENTS){
+        if((ret = pushIterContent(it, 0, tok->view)) != OPTION_SUCCESS){
+            return ret;
+        }
+        grp -> option.str  = NULL;
+        grp -> option.len  = 0;
+        grp -> prop_id     = -1;
+        grp -> content_num = 1;
+        grp -> contents    = it -> contents;
+        return OPTION_SUCCESS;
+    }
+    if(tok->dest != JD_OPT_GRPs_OPTION){
+        BUG_REPORT();
+        return OPTION_TOO_MANY_CONTENTS;
+    }
+
+    const opt_property_t *prop = &(it -> parser.db -> props[tok->prop]);
+    grp -> option  = tok -> view;
+    grp -> prop_id = tok -> prop;
+
+    /* 最大数に達したら後続のトークンはこのグループのコンテンツになり得ないので, 次のトークンを読まずに返す */
+    while(grp->content_num < prop->content_num_max){
+        if((ret = judgeIterToken(it, &tok)) != OPTION_SUCCESS){
+            return ret;
+        }
+        if(!tok || tok->dest != JD_OPT_GRPs_CONTENTS){
+            break; /* 次のグループの先頭なので行き先を決めたまま残す */
+        }
+        if((ret = pushIterContent(it, grp->content_num, tok->view)) != OPTION_SUCCESS){
+            return ret;
+        }
+        grp -> content_num++;
+        it -> tok_i++;
+        it -> judged = false;
+    }
+    grp -> contents = it -> contents;
+
+    if(grp->content_num < prop->content_num_min){
+        return OPTION_TOO_LITTLE_CONTENTS;
+    }
+    if(prop->value_type != OPT_VALUE_NONE){
+        if(reserveArray((void **)&(it -> values), &(it -> value_capacity), grp->content_num, sizeof(opt_value_t)) != 0){
+            return OPTION_OUT_OF_MEMORY;
+        }
+        for(int i=0; i<grp->content_num; i++){
+            if(parseOptValue(prop, grp->contents[i].str, grp->contents[i].len, &(it -> values[i])) != 0){
+                return OPTION_INVALID_VALUE;
+            }
+        }
+        grp -> values = it -> values;
+    }
+    if(applyContentsCheckerView(&(it -> parser), grp) != 0){
+        return OPTION_OUT_OF_MEMORY;
+    }
+    return OPTION_SUCCESS;
+}
+
+int
+optIterNext(
+        opt_iter_t       *it,
+        opt_view_group_t *grp)
+{
+    if(it->status != OPTION_SUCCESS){
+        return it->status;
+    }
+    return it->status = nextIterGroup(it, grp);
+}
+
+void
+freeOptIter(
+        opt_iter_t *it)
+{
+    freeOptParser(&(it -> parser));
+    free(it -> contents);
+    it -> contents         = NULL;
+    it -> content_capacity = 0;
+    free(it -> values);
+    it -> values           = NULL;
+    it -> value_capacity   = 0;
+    freeArena(it -> retired);
+    it -> retired          = NULL;
+}
+
+/* ============================================== */
+
+#define OPT_CACHE_LINE_SIZE 64
+
+/* ワーカ毎の状態. rangeは他のワーカからも書き換えられるのでキャッシュラインを分ける */
+typedef struct _opt_batch_worker_t{
+    _Alignas(OPT_CACHE_LINE_SIZE) _Atomic uint64_t range; /* まだ処理していないitemsの範囲. 上位32bitが先頭, 下位32bitが終端 */
+    opt_parser_t              parser;     /* ワーカ専用の解析の状態と作業領域 */
+    opt_arena_chunk_t        *arena;      /* ワーカ専用の結果の格納先 */
+    int                       id;         /* workersにおける添字 */
+    struct _opt_batch_ctx_t  *ctx;
+}opt_batch_worker_t;
+
+typedef struct _opt_batch_ctx_t{
+    int                 worker_num;
+    opt_batch_worker_t *workers;
+    const opt_argv_t   *items;
+    opt_group_batch_t  *batch;
+}opt_batch_ctx_t;
+
+static inline uint64_t
+packRange(
+        uint32_t begin,
+        uint32_t end)
+{
+    return (uint64_t)begin << 32 | end;
+}
+
+static int /* 取り出したitemsの添字. 空なら-1 */
+popOwnItem( /* 自分の範囲の先頭から1つ取り出す */
+        opt_batch_worker_t *worker)
+{
+    uint64_t range = atomic_load_explicit(&worker->range, memory_order_acquire);
+    for(;;){
+        uint32_t begin = range >> 32;
+        uint32_t end   = (uint32_t)range;
+        if(begin >= end){
+            return -1;
+        }
+        if(atomic_compare_exchange_weak_explicit(&worker->range, &range, packRange(begin+1, end),
+                    memory_order_acq_rel, memory_order_acquire)){
+            return begin;
+        }
+    }
+}
+
+static int /* 取り出したitemsの添字. どのワーカにも残っていなければ-1 */
+stealItem( /* 他のワーカの範囲の後ろ半分を奪って自分の範囲にし, その先頭を返す */
+        opt_batch_worker_t *worker)
+{
+    opt_batch_ctx_t *ctx = worker -> ctx;
+
+    for(int i=1; i<ctx->worker_num; i++){
+        opt_batch_worker_t *victim = &(ctx -> workers[(worker->id + i) % ctx->worker_num]);
+        uint64_t            range  = atomic_load_explicit(&victim->range, memory_order_acquire);
+        for(;;){
+            uint32_t begin = range >> 32;
+            uint32_t end   = (uint32_t)range;
+            if(begin >= end){
+                break;
+            }
+            uint32_t mid = end - (end - begin + 1) / 2;
+            if(atomic_compare_exchange_weak_explicit(&victim->range, &range, packRange(begin, mid),
+                        memory_order_acq_rel, memory_order_acquire)){
+                /* 自分の範囲は空なので他のワーカがCASに成功することは無い. [mid+1, end) を残りとして公開する */
+                atomic_store_explicit(&worker->range, packRange(mid+1, end), memory_order_release);
+                return mid;
+            }
+        }
+    }
+    return -1;
+}
+
+static void*
+runBatchWorker(
+        void *arg)
+{
+    opt_batch_worker_t *worker = (opt_batch_worker_t *)arg;
+    opt_batch_ctx_t    *ctx    = worker -> ctx;
+    int                 i;
+
+    while((i = popOwnItem(worker)) >= 0 || (i = stealItem(worker)) >= 0){
+        ctx -> batch -> err_codes[i] = buildOptGroupDB(&(worker -> parser), ctx->items[i].argc, ctx->items[i].argv,
+                allocFromArena, &(worker -> arena), &(ctx -> batch -> grp_dbs[i]));
+    }
+    return NULL;
+}
+
+int
+groupingOptBatch(
+        const opt_property_db_t *opt_prop_db,
+        int                      item_num,
+        const opt_argv_t        *items,
+        int                      worker_num,
+        opt_group_batch_t      **batch)
+{
+    const int SUCCESS       = OPTION_SUCCESS;
+    const int OUT_OF_MEMORY = OPTION_OUT_OF_MEMORY;
+    int       ret           = SUCCESS;
+
+    opt_batch_ctx_t     ctx;
+    opt_batch_worker_t *workers    = NULL;
+    pthread_t          *threads    = NULL;
+    bool               *started    = NULL;
+    int                 parser_num = 0;
+
+    *batch = NULL;
+    if(!opt_prop_db){
+        return OPTION_OPT_PROP_DB_IS_NULL;
+    }
+
+    if(worker_num <= 0){
+        long cpu_num = sysconf(_SC_NPROCESSORS_ONLN);
+        worker_num = cpu_num > 0 ? (int)cpu_num : 1;
+    }
+    if(worker_num > item_num){
+        worker_num = item_num > 0 ? item_num : 1;
+    }
+
+    /* 結果は [opt_group_batch_t][grp_dbs][arenas][err_codes] の順に1つのメモリ領域に詰める */
+    opt_group_batch_t *b = (opt_group_batch_t *)calloc(1,
+            sizeof(opt_group_batch_t) + sizeof(opt_group_db_t *)*item_num + sizeof(opt_arena_chunk_t *)*worker_num + sizeof(int)*item_num);
+    if(!b){
+        return OUT_OF_MEMORY;
+    }
+    b -> item_num  = item_num;
+    b -> grp_dbs   = (opt_group_db_t **)&b[1];
+    b -> arena_num = worker_num;
+    b -> arenas    = (opt_arena_chunk_t **)&(b -> grp_dbs[item_num]);
+    b -> err_codes = (int *)&(b -> arenas[worker_num]);
+
+    size_t workers_size = (sizeof(opt_batch_worker_t)*worker_num + OPT_CACHE_LINE_SIZE - 1) / OPT_CACHE_LINE_SIZE * OPT_CACHE_LINE_SIZE;
+    if(!(workers = (opt_batch_worker_t *)aligned_alloc(OPT_CACHE_LINE_SIZE, workers_size)) ||
+            !(threads = (pthread_t *)malloc(sizeof(pthread_t)*worker_num)) ||
+            !(started = (bool *)calloc(worker_num, sizeof(bool)))){
+        ret = OUT_OF_MEMORY;
+        goto free_and_exit;
+    }
+
+    ctx.worker_num = worker_num;
+    ctx.workers    = workers;
+    ctx.items      = items;
+    ctx.batch      = b;
+
+    /* 最初は各ワーカに連続した範囲を均等に割り当てる */
+    for(parser_num=0; parser_num<worker_num; parser_num++){
+        opt_batch_worker_t *worker = &workers[parser_num];
+        if(initOptParser(&(worker -> parser), opt_prop_db) != OPTION_SUCCESS){
+            ret = OUT_OF_MEMORY;
+            goto free_and_exit;
+        }
+        uint32_t begin = (uint64_t)item_num * parser_num / worker_num;
+        uint32_t end   = (uint64_t)item_num * (parser_num+1) / worker_num;
+        atomic_init(&(worker -> range), packRange(begin, end));
+        worker -> arena = NULL;
+        worker -> id    = parser_num;
+        worker -> ctx   = &ctx;
+    }
+
+    /* 呼び出し元のスレッドもワーカ0として働く. スレッドを作れなかったワーカの範囲は他のワーカが奪うので処理は漏れない */
+    for(int i=1; i<worker_num; i++){
+        started[i] = pthread_create(&threads[i], NULL, runBatchWorker, &workers[i]) == 0;
+    }
+    runBatchWorker(&workers[0]);
+    for(int i=1; i<worker_num; i++){
+        if(started[i]){
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    for(int i=0; i<worker_num; i++){
+        b -> arenas[i] = workers[i].arena;
+    }
+
+free_and_exit:
+
+    for(int i=0; i<parser_num; i++){
+        freeOptParser(&(workers[i].parser));
+    }
+    free(workers);
+    free(threads);
+    free(started);
+
+    if(ret == SUCCESS){
+        *batch = b;
+    }
+    else{
+        free(b);
+    }
+    return ret;
+}
+
+void
+freeOptGroupBatch(
+        opt_group_batch_t *batch)
+{
+    if(!batch){
+        return;
+    }
+    for(int i=0; i<batch->arena_num; i++){
+        freeArena(batch -> arenas[i]);
+    }
+    /* opt_group_batch_tとその配列は1つのメモリ領域に格納されている */
+    free(batch);
 }
@@ -32,6 +32,8 @@
 #include <ctype.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
 
 #ifndef BUG_REPORT
 #include <stdio.h>
@@ -47,8 +49,35 @@ typedef enum{
     OPTION_DUPLICATE_SAME_OPT  = 5,
     OPTION_TOO_MANY_CONTENTS   = 6,
     OPTION_TOO_LITTLE_CONTENTS = 7,
+    OPTION_OPT_PROP_DB_IS_FULL = 8,
+    OPTION_RSP_FILE_TOO_DEEP   = 9,
+    OPTION_ITER_END            = 10, /* optIterNextでこれ以上グループが無い */
+    OPTION_INVALID_VALUE       = 11, /* value_typeを宣言したオプションのコンテンツをその型として解釈できない */
+    OPTION_AMBIGUOUS_OPT       = 12, /* 省略した詳細形式が複数のオプションの接頭辞になっている. 候補はgetOptAmbiguousCandidatesで得る */
+    OPTION_UNKNOWN_CONFIG_KEY  = 13, /* setOptDefaultSourcesで指定した設定ファイルに登録されていないオプションの名前が書かれている */
+    OPTION_STATS_DISABLED      = 14, /* OPT_STATSを定義せずにビルドしたライブラリでsetOptStatsを呼んだ */
 }option_errcode_t;
 
+/* opt_property_tのvalue_type. コンテンツをどの型の値として解釈するか */
+typedef enum{
+    OPT_VALUE_NONE   = 0, /* 解釈しない. 文字列のままcontentsで参照する */
+    OPT_VALUE_INT64  = 1, /* 符号付き10進整数. 例えば "-42" */
+    OPT_VALUE_UINT64 = 2, /* 符号無し10進整数. 例えば "42" */
+    OPT_VALUE_DOUBLE = 3, /* 浮動小数点数. 例えば "1.5e-3" */
+    OPT_VALUE_BOOL   = 4, /* "true", "false", "yes", "no", "on", "off", "1", "0" のどれか */
+    OPT_VALUE_ENUM   = 5, /* opt_property_tのenum_namesのどれか */
+    OPT_VALUE_SIZE   = 6, /* 符号無し10進整数と1024の冪の接尾辞(K, M, G, T, P, E. 大文字小文字は問わず, 後ろにBかiBを付けてもよい). 例えば "64K", "1GiB" */
+}opt_value_type_t;
+
+/* value_typeを宣言したオプションのコンテンツを解釈した値. どのメンバが有効かはvalue_typeで決まる */
+typedef union _opt_value_t{
+    int64_t  i64; /* OPT_VALUE_INT64 */
+    uint64_t u64; /* OPT_VALUE_UINT64とOPT_VALUE_SIZE(バイト数) */
+    double   dbl; /* OPT_VALUE_DOUBLE */
+    bool     b;   /* OPT_VALUE_BOOL */
+    int      e;   /* OPT_VALUE_ENUM. enum_namesにおける添字 */
+}opt_value_t;
+
 /* プログラムで使用できるオプションの情報を保持する構造体 */
 typedef struct _opt_property_t{
     char *short_form;                                           /* オプションの短縮形式. 例えば"-v" */
@@ -56,21 +85,110 @@ typedef struct _opt_property_t{
     int  (*contents_checker)(char **contents, int content_num); /* オプションに付属するcontentsの正しさを調べるコールバック関数 */
     int  content_num_min;                                       /* オプションに付属するcontentsの最小数 */
     int  content_num_max;                                       /* オプションに付属するcontentsの最大数 */
-    int  appeared_yet;                                          /* 同じオプションがすでに指定されたかチェックするためのメモとして用いる */
+    int  value_type;                                            /* contentsを解釈する型(opt_value_type_t). OPT_VALUE_NONEなら解釈しない */
+    const char *const *enum_names;                              /* value_typeがOPT_VALUE_ENUMの場合に受け付ける文字列のNULL終端された配列 */
 }opt_property_t;
 
-/* opt_property_tのエントリを保持するための構造体 */
+/* contents_checkerの結果を(オプション, コンテンツ)の組毎に記録するキャッシュ. genOptCheckerMemoで生成し, 複数のスレッドから共有できる. 利用者が中身を知る必要は無い */
+typedef struct _opt_checker_memo_t opt_checker_memo_t;
+
+/* setOptCheckerThreadsで指定できるスレッドの数の上限 */
+#define OPT_CHECKER_THREAD_MAX 64
+
+/* opt_property_db_tのidx_state */
+typedef enum{
+    OPT_IDX_EMPTY    = 0, /* OPT_PROP_DB_DEFINEで定義された直後 */
+    OPT_IDX_BUILDING = 1, /* いずれかのスレッドが構築中 */
+    OPT_IDX_BUILT    = 2, /* genOptPropDBで生成した場合とoptgenで生成した場合は最初からこの状態 */
+}opt_idx_state_t;
+
+/* long_formの基数木の節. opt_property_db_tのメンバとして用いるので利用者が知る必要は無い */
+typedef struct _opt_trie_node_t{
+    const char *label;     /* 親からこの節への辺のラベル. いずれかのlong_formの一部を指す */
+    int         label_len; /* labelの長さ */
+    int         child;     /* 最初の子の添字. 無ければ-1 */
+    int         sibling;   /* 次の兄弟の添字. 無ければ-1 */
+    int         prop;      /* ここで終わるlong_formのpropsの添字. 無ければ-1 */
+    int         only;      /* 部分木のlong_formが全て同じオプションのものならその添字. 複数のオプションにまたがれば-1 */
+}opt_trie_node_t;
+
+/* prop_num個のオプションのlong_formの基数木の節の数の上限. 1つ登録する毎に節は高々2つ(辺の分割と葉)増える */
+#define OPT_PROP_TRIE_SIZE(prop_num) ((prop_num)*2 + 1)
+
+/* オプションの名前とそのオプション. opt_property_db_tのnamesの要素として用いるので利用者が知る必要は無い */
+typedef struct _opt_name_t{
+    const char *name; /* short_formかlong_form */
+    int         prop; /* propsの添字 */
+}opt_name_t;
+
+/* prop_num個のオプションの名前の数の上限. short_formとlong_formの2つ */
+#define OPT_PROP_NAMES_SIZE(prop_num) ((prop_num)*2)
+
+/* opt_property_tのエントリを保持するための構造体. 登録が済んだ後は解析で書き換えられないので複数のスレッドで共有できる */
 typedef struct _opt_property_db_t{
-    int             prop_num; /* propsのサイズ */
-    opt_property_t *props;    /* opt_property_tの配列 */
+    int                   prop_num;  /* propsのサイズ */
+    int                   reg_num;   /* regOptPropで登録済みのopt_property_tの数 */
+    const opt_property_t *props;     /* opt_property_tの配列. OPT_PROP_DB_DEFINEで定義した場合は読み取り専用の領域に置かれる */
+    int                   idx_size;  /* idxのサイズ(2の冪) */
+    int                  *idx;       /* short_formとlong_formの両方をキーとしてpropsの添字を引くためのハッシュ表. 空きは-1. regOptPropで構築される */
+    int                   short_idx[256]; /* "-v"のように'-'と1文字からなる名前の2文字目で直接引くpropsの添字+1. 0なら無し. idxと同時に構築される */
+    atomic_int            idx_state; /* idxの構築状況(opt_idx_state_t). OPT_PROP_DB_DEFINEで定義した場合は最初の解析で構築される */
+    int                 (*matcher)(const char *str, int len); /* optgenで生成したマッチャ. strの先頭len文字に一致するpropsの添字か-1を返す. NULLならidxを引く */
+    int                   checker_thread_num; /* 1回の解析でcontents_checkerを並列に呼ぶスレッドの数(呼び出し元を含む). 1以下なら順に呼ぶ */
+    opt_checker_memo_t   *checker_memo;       /* NULLでなければ同じオプションと同じコンテンツの組はcontents_checkerを1回だけ呼び, 結果を使い回す */
+    bool                  abbrev;     /* --inter のような詳細形式の一意な接頭辞を受け付けるか. setOptAbbrevで設定する */
+    int                   trie_size;  /* trieのサイズ */
+    int                   trie_num;   /* trieの使用済みの節の数. 0番が根 */
+    opt_trie_node_t      *trie;       /* long_formの基数木. abbrevを有効にした後, 最初に省略形を引く時に構築される */
+    atomic_int            trie_state; /* trieの構築状況(opt_idx_state_t) */
+    int                   name_num;    /* namesの要素数. 同じ名前は先に登録されたオプションの1つにまとめる */
+    opt_name_t           *names;       /* 全ての名前を辞書順(strcmpの順)に並べた配列. 補完で接頭辞の範囲を二分探索する. 最初に補完する時に構築される */
+    atomic_int            names_state; /* namesの構築状況(opt_idx_state_t). optgenで生成した場合は最初から構築済み */
 }opt_property_db_t;
 
+/* OPT_PROP_DB_DEFINEで用いる. prop_num個のオプションに対してgenOptPropDBと同じ大きさ(4*prop_num以上の2の冪)を定数式で求める */
+#define OPT_PROP_IDX_SMEAR_(x)      ((x) | (x)>>1 | (x)>>2 | (x)>>4 | (x)>>8 | (x)>>16)
+#define OPT_PROP_IDX_SIZE(prop_num) (OPT_PROP_IDX_SMEAR_((prop_num)*4 - 1) + 1)
+#define OPT_PROP_ENTRY_(short_form, long_form, content_num_min, content_num_max, contents_checker, ...) \
+    {(short_form), (long_form), (contents_checker), (content_num_min), (content_num_max), __VA_ARGS__},
+#define OPT_PROP_COUNT_(short_form, long_form, content_num_min, content_num_max, contents_checker, ...) + 1
+
+/* X-macroで列挙したオプションからopt_property_db_tを静的に定義する. genOptPropDBとregOptPropを呼ぶ必要が無く, 起動時にメモリを確保しない.
+ * 例えば
+ *     #define MY_OPTS(X) \
+ *         X("-h", "--help",   0, 0, NULL) \
+ *         X("-o", "--output", 1, 1, chkOutput) \
+ *         X("-j", "--jobs",   1, 1, NULL, OPT_VALUE_INT64)
+ *     OPT_PROP_DB_DEFINE(my_opt_prop_db, MY_OPTS)
+ * で static opt_property_db_t my_opt_prop_db が定義され, groupingOpt(&my_opt_prop_db, argc, argv, &opt_grp_db) のように使える.
+ * Xの引数はregOptPropTypedと同じ順で, contents_checkerはNULLでもよい. value_typeとenum_namesは省略できる. freeOptPropDBで開放してはならない */
+#define OPT_PROP_DB_DEFINE(name, LIST) \
+    static const opt_property_t name##_props_[] = {LIST(OPT_PROP_ENTRY_)}; \
+    static int name##_idx_[OPT_PROP_IDX_SIZE(0 LIST(OPT_PROP_COUNT_))]; \
+    static opt_trie_node_t name##_trie_[OPT_PROP_TRIE_SIZE(0 LIST(OPT_PROP_COUNT_))]; \
+    static opt_name_t name##_names_[OPT_PROP_NAMES_SIZE(0 LIST(OPT_PROP_COUNT_))]; \
+    static opt_property_db_t name = { \
+        .prop_num   = 0 LIST(OPT_PROP_COUNT_), \
+        .reg_num    = 0 LIST(OPT_PROP_COUNT_), \
+        .props      = name##_props_, \
+        .idx_size   = OPT_PROP_IDX_SIZE(0 LIST(OPT_PROP_COUNT_)), \
+        .idx        = name##_idx_, \
+        .idx_state  = OPT_IDX_EMPTY, \
+        .trie_size  = OPT_PROP_TRIE_SIZE(0 LIST(OPT_PROP_COUNT_)), \
+        .trie       = name##_trie_, \
+        .trie_state = OPT_IDX_EMPTY, \
+        .names      = name##_names_, \
+        .names_state = OPT_IDX_EMPTY, \
+    }
+
 /* プログラム実行時に指定した各オプションの情報を保持するための構造体 */
 typedef struct _opt_group_t{
     char  *option;        /* 例えば "gcc -Wall -O3 -I ./hoge ./geho -o ./foo bar1.c bar2.c" の -Wall, -O3, -I, -o がそれぞれ別のopt_group_tのoptionに割り当てられる */
     int    content_num;   /* 例えば option が -I なら2になる */
     char **contents;      /* 例えば option が -I なら ./hoge, ./geho になる */
     int    err_code;      /* 対応するopt_property_tに登録されているcontents_checker関数の引数にcontent_numとcontentsを適用した際の戻り値  */
+    int    prop_id;       /* 対応するopt_property_tのID. regOptPropで登録した順(OPT_PROP_DB_DEFINEとoptgenでは書いた順)に0から振られるので, switchで分岐できる */
+    opt_value_t *values;  /* contentsをvalue_typeとして解釈した値の配列. 要素数はcontent_num. value_typeがOPT_VALUE_NONEならNULL */
 }opt_group_t;
 
 /* opt_group_tのエントリを保持するための構造体 */
@@ -79,8 +197,174 @@ typedef struct _opt_group_db_t{
     opt_group_t *grps;       /* opt_group_tの配列 */
     int         optless_num; /* 対応するオプションが無いコンテンツの数 */
     char      **optless;     /* 対応するオプションが無いコンテンツ. 例えば, gcc -o hoge hoge.c geho.c のhoge.cとgeho.c */
+    int         prop_num;    /* grp_idxのサイズ. 解析に用いたopt_property_db_tのprop_numと同じ */
+    int        *grp_idx;     /* prop_idからgrpsの添字を引く表. 指定されなかったオプションは-1. getOptGroupで引く */
 }opt_group_db_t;
 
+/* 文字列の一部を指すビュー. NUL終端されているとは限らない */
+typedef struct _opt_view_t{
+    const char *str; /* ビューの先頭. 例えば "--print=a,b" の a ならargvの要素の先頭から8文字目を指す */
+    int         len; /* ビューの長さ */
+}opt_view_t;
+
+/* opt_group_tのビュー版. 文字列を複製せずにmainの引数で受け取ったargvを指す */
+typedef struct _opt_view_group_t{
+    opt_view_t  option;      /* opt_group_tのoptionに相当する. -hvi のように束ねた短縮形式から切り出したオプションはopt_property_tのshort_formを指す */
+    int         content_num; /* opt_group_tのcontent_numに相当する */
+    opt_view_t *contents;    /* opt_group_tのcontentsに相当する */
+    int         err_code;    /* opt_group_tのerr_codeに相当する */
+    int         prop_id;     /* opt_group_tのprop_idに相当する */
+    opt_value_t *values;     /* opt_group_tのvaluesに相当する */
+}opt_view_group_t;
+
+/* groupingOptBatchの結果や応答ファイルから引用符を取り除いたトークンを格納するアリーナのチャンク. 利用者が知る必要は無い */
+typedef struct _opt_arena_chunk_t opt_arena_chunk_t;
+
+/* @fileで展開した応答ファイルをマップした領域 */
+typedef struct _opt_mapping_t{
+    void   *addr; /* mmapで得た先頭 */
+    size_t  size; /* マップしたサイズ */
+}opt_mapping_t;
+
+/* opt_group_db_tのビュー版. groupingOptViewで生成され, 全体が1つのメモリ領域に格納される */
+typedef struct _opt_view_group_db_t{
+    int                grp_num;     /* opt_view_group_tの配列のサイズ */
+    opt_view_group_t  *grps;        /* opt_view_group_tの配列 */
+    int                optless_num; /* 対応するオプションが無いコンテンツの数 */
+    opt_view_t        *optless;     /* 対応するオプションが無いコンテンツ */
+    int                map_num;     /* mapsのサイズ */
+    opt_mapping_t     *maps;        /* ビューが指している応答ファイルのマッピング. freeOptViewGroupDBでアンマップされる */
+    opt_arena_chunk_t *unquoted;    /* ビューが指している, 応答ファイルから引用符を取り除いたトークン. freeOptViewGroupDBで開放される */
+    int                prop_num;    /* opt_group_db_tのprop_numに相当する */
+    int               *grp_idx;     /* opt_group_db_tのgrp_idxに相当する. getOptViewGroupで引く */
+}opt_view_group_db_t;
+
+/* argvの要素から切り出したトークン. opt_parser_tのメンバとして用いるので利用者が知る必要は無い */
+typedef struct _opt_token_t{
+    opt_view_t  view;   /* argvの要素か応答ファイルの一部を指す */
+    int         prop;   /* トークンがオプションの場合に対応するopt_property_tの添字 */
+    signed char dest;   /* トークンの行き先(オプション, オプションのコンテンツ, 対応するオプションが無いコンテンツのどれか). 巨大な応答ファイルに備えて1バイトに詰める */
+    bool        forced; /* --long=a,b の a, b や -ofile の file のように直前のオプションのコンテンツとしてしか解釈できないトークンか */
+}opt_token_t;
+
+/* 展開中の応答ファイルのマッピングと読み進めた位置. opt_parser_tのメンバとして用いるので利用者が知る必要は無い */
+typedef struct _opt_rsp_file_t opt_rsp_file_t;
+
+/* setOptDefaultSourcesで指定した設定ファイルをマップして切り出したトークンのキャッシュ. opt_parser_tのメンバとして用いるので利用者が知る必要は無い */
+typedef struct _opt_config_t opt_config_t;
+
+/* setOptStatsで指定したparserでの解析の段階毎の所要時間と数. 解析の度に足し込むので, 0で初期化してから渡す.
+ * 時間はCLOCK_MONOTONICのナノ秒. 確保と比較の回数は解析を呼んだスレッドでのもので, contents_checkerを並列に呼ぶスレッドの分は含まない.
+ * ライブラリをOPT_STATSを定義してビルドした場合だけ記録する. 定義しなければ計測のコードは全て取り除かれる */
+typedef struct _opt_stats_t{
+    uint64_t  parse_num;       /* 解析の回数 */
+    uint64_t  failed_num;      /* OPTION_SUCCESS以外で終わった解析の回数 */
+    uint64_t  decode_ns;       /* argvと応答ファイルをトークンに切り出す(decodeOptions) */
+    uint64_t  classify_ns;     /* 各トークンの行き先を決める(judgeDestination) */
+    uint64_t  count_check_ns;  /* 各オプションのコンテンツの数を調べる(checkContentsNum) */
+    uint64_t  defaults_ns;     /* 環境変数と設定ファイルから補う(setOptDefaultSources) */
+    uint64_t  fill_ns;         /* 結果を確保してトークンを格納し, 値を解釈する */
+    uint64_t  checker_ns;      /* contents_checkerを全て呼び終えるまで. 並列に呼ぶ場合は経過時間 */
+    uint64_t  total_ns;        /* 解析全体 */
+    uint64_t  token_num;       /* 切り出したトークンの数 */
+    uint64_t  grp_num;         /* 結果のグループの数 */
+    uint64_t  alloc_num;       /* ライブラリ内のmalloc, calloc, reallocの回数 */
+    uint64_t  alloc_bytes;     /* ライブラリ内で確保を要求したバイト数 */
+    uint64_t  str_cmp_num;     /* オプションの名前やenum_namesとの文字列の比較の回数 */
+    uint64_t *prop_checker_ns; /* [in] NULLでなければprop_num要素の配列. propsの添字毎にcontents_checkerの所要時間を足し込む */
+}opt_stats_t;
+
+/* opt_parser_tのappeared_inlineの語数. prop_numがこの64倍以下ならappearedのためにメモリを確保しない */
+#define OPT_APPEARED_INLINE_WORDS 4
+
+/* 1回の解析の途中状態と作業領域を保持する構造体. スレッド毎に用意すれば1つのopt_property_db_tを共有して並行に解析できる.
+ * 作業領域は解析の度に使い回されるので, 同じparserで繰り返し解析すると確保の回数を減らせる. メンバを利用者が直接参照する必要は無い */
+typedef struct _opt_parser_t{
+    const opt_property_db_t *db;               /* 解析に用いるopt_property_db_t */
+    int                      appeared_words;   /* 指定済みのオプションのビット集合の語数 */
+    uint64_t                *appeared;         /* propsの添字をビットの位置とする, 指定済みのオプションのビット集合. prop_numが小さい場合はNULLでappeared_inlineを用いる */
+    uint64_t                 appeared_inline[OPT_APPEARED_INLINE_WORDS];
+    bool                     optless_is_empty; /* 対応するオプションが無いコンテンツがまだ無いか */
+    bool                     lock_optless;     /* 対応するオプションが無いコンテンツの後にオプションが現れたか */
+    int                      contents_num;     /* 直前のオプションに付属するコンテンツの数 */
+    int                      contents_num_max; /* 直前のオプションに付属するコンテンツの最大数 */
+    int                      contents_num_min; /* 直前のオプションに付属するコンテンツの最小数 */
+    int                      tok_num;          /* toksの要素数 */
+    int                      tok_capacity;     /* toksの容量 */
+    opt_token_t             *toks;             /* argvから切り出したトークン */
+    int                      buf_capacity;     /* bufの容量 */
+    char                    *buf;              /* contents_checkerに渡す文字列の作業領域 */
+    int                      rsp_depth_max;    /* @fileを展開する入れ子の深さの上限. 0なら展開しない */
+    int                      rsp_num;          /* rspsの要素数 */
+    int                      rsp_capacity;     /* rspsの容量 */
+    int                      rsp_top;          /* 読んでいる途中の最も深い応答ファイルのrspsの添字. 無ければ-1 */
+    opt_rsp_file_t          *rsps;             /* 展開した順の応答ファイル. toksのビューがマッピングを指している */
+    opt_arena_chunk_t       *unquoted;         /* 応答ファイルのトークンのうち引用符やバックスラッシュを取り除いたものの格納先 */
+    opt_view_t               ambiguous;        /* 直前の解析をOPTION_AMBIGUOUS_OPTで失敗させたトークン. 失敗していなければstrがNULL */
+    const char              *config_path;      /* argvと環境変数で指定されなかったオプションを補う設定ファイル. NULLなら読まない */
+    const char              *env_prefix;       /* argvで指定されなかったオプションを補う環境変数の接頭辞. NULLなら読まない */
+    opt_config_t            *config;           /* config_pathを切り出したトークン. ファイルが変わらなければ次の解析で使い回す */
+    opt_stats_t             *stats;            /* 解析の統計の足し込み先. NULLなら記録しない */
+}opt_parser_t;
+
+/* argvを先頭から少しずつ解析して1グループずつ返すイテレータ. initOptIterで初期化してoptIterNextで取り出す.
+ * 取り出さなかったグループのためには解析もメモリ確保も行わないので, 先頭のオプションだけを見て止める場合はargvの長さによらない.
+ * 応答ファイルは一定の数のトークンずつ切り出し, 返し終えた分の作業領域とページを手放すので, グループが短ければファイルの大きさによらないメモリで読める.
+ * メンバを利用者が直接参照する必要は無い */
+typedef struct _opt_iter_t{
+    opt_parser_t        parser;           /* 解析の状態と作業領域. parser.toksは切り出したがまだ返していないトークンの待ち行列として使う */
+    int                 argc;             /* 解析するプログラムの引数の数(プログラム名含む) */
+    char              **argv;             /* 解析するプログラムの引数(プログラム名含む) */
+    int                 arg_i;            /* 次にトークンに切り出すargvの添字 */
+    int                 tok_i;            /* parser.toksのうち次に返すトークンの添字 */
+    bool                judged;           /* parser.toks[tok_i]の行き先をjudgeDestinationで決め済みか */
+    int                 status;           /* OPTION_SUCCESS以外になったら以降のoptIterNextはこれを返す */
+    int                 content_capacity; /* contentsの容量 */
+    opt_view_t         *contents;         /* 直前にoptIterNextで返したグループのコンテンツ */
+    int                 value_capacity;   /* valuesの容量 */
+    opt_value_t        *values;           /* 直前にoptIterNextで返したグループのコンテンツを解釈した値 */
+    bool                refilled;         /* 待ち行列を詰め直してから, まだ前の窓の領域を手放していないか */
+    int                 rsp_live;         /* parser.rspsのうち, まだページを手放し終えていない最初の添字 */
+    opt_arena_chunk_t  *retired;          /* 前の窓までに応答ファイルから引用符を取り除いたトークン. 次のグループを取り出し始める時に開放する */
+}opt_iter_t;
+
+/* groupingOptBatchに渡す1回分のプログラムの引数 */
+typedef struct _opt_argv_t{
+    int    argc; /* プログラムの引数の数(プログラム名含む) */
+    char **argv; /* プログラムの引数(プログラム名含む) */
+}opt_argv_t;
+
+/* groupingOptBatchの結果. 各opt_group_db_tはワーカ毎のアリーナに格納されるので個別にfreeOptGroupDBしてはならない. freeOptGroupBatchで一括して開放する */
+typedef struct _opt_group_batch_t{
+    int                 item_num;  /* 解析したopt_argv_tの数 */
+    opt_group_db_t    **grp_dbs;   /* items[i]のグルーピング結果. 解析に失敗した場合はNULL */
+    int                *err_codes; /* items[i]の解析結果のoption_errcode_t */
+    int                 arena_num; /* arenasのサイズ(ワーカの数) */
+    opt_arena_chunk_t **arenas;    /* ワーカ毎のアリーナのチャンクの連結リスト */
+}opt_group_batch_t;
+
+/* サブコマンドの木の節. 各節が自身のオプションのopt_property_db_tを持つ. 静的に定義でき, 解析で書き換えないので複数のスレッドで共有できる.
+ * 例えば
+ *     static const opt_command_t git_subs[] = {
+ *         {"add",    &add_opt_prop_db,    0, NULL},
+ *         {"commit", &commit_opt_prop_db, 0, NULL},
+ *     };
+ *     static const opt_command_t git_cmd = {NULL, &git_opt_prop_db, 2, git_subs};
+ * のように定義し, groupingOptCommand(&git_cmd, argc, argv, &cmd_grp_db) のように使う */
+typedef struct _opt_command_t{
+    const char                  *name;    /* サブコマンドの名前. 例えば "commit". 根では使わない */
+    const opt_property_db_t     *db;      /* このコマンドのオプション. NULLならオプションを持たない. OPT_PROP_DB_DEFINEで定義したものは選ばれるまで索引を構築しない */
+    int                          sub_num; /* subsのサイズ */
+    const struct _opt_command_t *subs;    /* サブコマンドの配列. nameの昇順(strcmpの順)に並べる */
+}opt_command_t;
+
+/* groupingOptCommandの結果. 根から選ばれたサブコマンドまでのコマンド毎のグルーピング結果を連結リストで持つ */
+typedef struct _opt_command_group_db_t{
+    const opt_command_t            *command; /* このグルーピング結果のコマンド */
+    opt_group_db_t                 *grp_db;  /* commandのオプションのグルーピング結果. 同じメモリ領域に格納されているので個別にfreeOptGroupDBしてはならない */
+    struct _opt_command_group_db_t *sub;     /* 選ばれたサブコマンドの結果. 無ければNULL */
+}opt_command_group_db_t;
+
 extern opt_property_db_t* /* 生成されたopt_property_db_tのメモリ領域のポインタ */
 genOptPropDB(     
         int prop_num); /* 登録するopt_property_tの数 */
@@ -94,19 +378,179 @@ regOptProp( /* opt_property_db_tのエントリを追加する関数 */
         int                content_num_max, /* オプションに付属するコンテンツの最大数 */
         int              (*contents_checker)(char **contents, int content_num)); /* オプションのコンテンツをチェックするコールバック関数 */
 
+extern int /* option_errcode_tのどれか */
+regOptPropTyped( /* regOptPropと同じだが, 解析時にコンテンツをvalue_typeの値として解釈してopt_group_tのvaluesに格納する */
+        opt_property_db_t  *db,               /* [out] 登録先(genOptPropDBで作成したopt_property_db_t) */
+        char               *short_form,       /* [in] オプションの短縮形式 */
+        char               *long_form,        /* [in] オプションの詳細形式 */
+        int                content_num_min,   /* オプションに付属するコンテンツの最少数 */
+        int                content_num_max,   /* オプションに付属するコンテンツの最大数 */
+        int              (*contents_checker)(char **contents, int content_num), /* オプションのコンテンツをチェックするコールバック関数 */
+        int                value_type,        /* opt_value_type_tのどれか */
+        const char *const *enum_names);       /* [in] value_typeがOPT_VALUE_ENUMの場合に受け付ける文字列のNULL終端された配列. 複製しないのでdbより長く生存しなければならない */
+
 extern void
 freeOptPropDB( /* opt_property_db_tのメンバのメモリ領域を再帰的に開放する関数 */
         opt_property_db_t *db); /* [in] 開放するopt_property_db_t */
 
+extern void
+setOptCheckerThreads( /* contents_checkerをthread_num個のスレッドで並列に呼ぶようにする. err_codeは並列にしても同じ値になる. contents_checkerはスレッドセーフでなければならない */
+        opt_property_db_t *db,          /* [mod] 設定するopt_property_db_t. 解析中に変更してはならない */
+        int                thread_num); /* 呼び出し元を含むスレッドの数. 1以下なら順に呼び, OPT_CHECKER_THREAD_MAXを超えたら切り詰める */
+
+extern opt_checker_memo_t* /* 生成したopt_checker_memo_t. 失敗したらNULL */
+genOptCheckerMemo(void);
+
+extern void
+freeOptCheckerMemo( /* genOptCheckerMemoで生成したopt_checker_memo_tを開放する */
+        opt_checker_memo_t *memo); /* [in] 開放するopt_checker_memo_t */
+
+extern void
+setOptCheckerMemo( /* dbでの解析でcontents_checkerの結果をmemoに記録して使い回す. groupingOptBatchの全てのワーカで共有される. 記録は開放するまで増え続ける */
+        opt_property_db_t  *db,    /* [mod] 設定するopt_property_db_t. 解析中に変更してはならない */
+        opt_checker_memo_t *memo); /* [in] genOptCheckerMemoで生成したopt_checker_memo_t. NULLなら記録しない. dbでの解析が終わるまで開放してはならない */
+
+extern void
+setOptAbbrev( /* 詳細形式を一意に定まる接頭辞まで省略できるようにする. 例えば --interactive と --input があれば --inte は前者になり, --in は曖昧なのでOPTION_AMBIGUOUS_OPTになる */
+        opt_property_db_t *db,      /* [mod] 設定するopt_property_db_t. 解析中に変更してはならない */
+        bool               enable); /* trueなら省略を受け付ける. 省略した詳細形式はlong_formを指すビュー(groupingOptでは複製)になる */
+
+extern int /* 候補の総数. 直前の解析がOPTION_AMBIGUOUS_OPTで失敗していなければ0 */
+getOptAmbiguousCandidates( /* 直前の解析で曖昧だった省略形のトークンと, それを接頭辞に持つオプションを得る */
+        const opt_parser_t *parser,    /* [in] OPTION_AMBIGUOUS_OPTを返した解析に用いたopt_parser_t. optIterNextならopt_iter_tのparser */
+        opt_view_t         *tok,       /* [out] 曖昧だったトークン. 次の解析まで有効 */
+        int                *props,     /* [out] 候補のpropsの添字. long_formの辞書順に高々prop_max個格納する */
+        int                 prop_max); /* propsのサイズ */
+
+extern int /* 候補の総数. cand_maxより多い分はcandsに格納されない */
+completeOpt( /* シェルの補完のために, 入力途中のコマンドラインのwords[word_i]を補完する候補を辞書順に返す.
+              * words[word_i]が - で始まれば短縮形式と詳細形式の名前を, enum_namesを持つオプションのコンテンツの位置(--mode=f の f を含む)ならenum_namesの要素を返す.
+              * contents_checkerは呼ばず, 結果のためのメモリも確保しない. 名前の辞書順の索引は最初の呼び出しで構築される */
+        const opt_property_db_t  *opt_prop_db, /* [in] オプション情報が登録されたopt_property_db_t */
+        int                       word_num,    /* wordsのサイズ(プログラム名含む). bashの${#COMP_WORDS[@]}に相当する. 負なら候補を返さない */
+        char                    **words,       /* [in] 入力途中のコマンドライン(プログラム名含む). bashのCOMP_WORDSに相当する */
+        int                       word_i,      /* 補完する単語の添字. bashのCOMP_CWORDに相当する. word_num以上なら空の単語を補完し, 負なら候補を返さない */
+        int                      *cand_pos,    /* [out] 候補で置き換えるwords[word_i]の位置. --mode=f ならfの位置で, それ以外は0 */
+        const char              **cands,       /* [out] 候補. opt_property_tの名前かenum_namesの要素を指す */
+        int                       cand_max);   /* candsのサイズ */
+
 extern int /* option_errcode_tのどれか */
 groupingOpt( /* オプション情報が登録されたopt_property_dbをもとにmainの引数で取得したargcとargvをグループに分類してopt_group_db_tのエントリに登録する関数 */
-        opt_property_db_t *opt_prop_db,  /* [in] オプション情報が登録されたopt_property_db_t */
-        int                argc,         /* mainの引数で受け取ったプログラムの引数の数(プログラム名含む) */
-        char             **argv,         /* [in] mainの引数で受け取ったプログラムの引数(プログラム名含む) */
-        opt_group_db_t   **opt_grp_db);  /* [out] グルーピングされたオプション情報 */
+        const opt_property_db_t *opt_prop_db,  /* [in] オプション情報が登録されたopt_property_db_t */
+        int                      argc,         /* mainの引数で受け取ったプログラムの引数の数(プログラム名含む) */
+        char                   **argv,         /* [in] mainの引数で受け取ったプログラムの引数(プログラム名含む) */
+        opt_group_db_t         **opt_grp_db);  /* [out] グルーピングされたオプション情報 */
 
 extern void
-freeOptGroupDB( /* opt_group_db_tのメンバのメモリ領域を再帰的に解放 */
+freeOptGroupDB( /* groupingOptで生成したopt_group_db_tを開放する. 結果は1つのメモリ領域に格納されているので1回のfreeで済む */
         opt_group_db_t *opt_group_db); /* [in] 開放するopt_group_db_t */
 
+extern int /* option_errcode_tのどれか */
+groupingOptView( /* groupingOptと同様にグルーピングするが, 結果はargvの要素を複製せずにビューで指す. トークン毎のメモリ確保は行わない */
+        const opt_property_db_t *opt_prop_db, /* [in] オプション情報が登録されたopt_property_db_t */
+        int                      argc,        /* mainの引数で受け取ったプログラムの引数の数(プログラム名含む) */
+        char                   **argv,        /* [in] mainの引数で受け取ったプログラムの引数(プログラム名含む). 結果を開放するまで書き換えたり開放したりしてはならない */
+        opt_view_group_db_t    **opt_grp_db); /* [out] グルーピングされたオプション情報 */
+
+extern void
+freeOptViewGroupDB( /* groupingOptViewで生成したopt_view_group_db_tを開放する */
+        opt_view_group_db_t *opt_grp_db); /* [in] 開放するopt_view_group_db_t */
+
+extern opt_group_t* /* prop_idのオプションのopt_group_t. 指定されていないかprop_idが範囲外ならNULL */
+getOptGroup( /* 文字列を比較せずにO(1)で引く */
+        const opt_group_db_t *opt_grp_db, /* [in] groupingOptで生成したopt_group_db_t */
+        int                   prop_id);   /* 引くオプションのID */
+
+extern opt_view_group_t* /* prop_idのオプションのopt_view_group_t. 指定されていないかprop_idが範囲外ならNULL */
+getOptViewGroup( /* getOptGroupのビュー版 */
+        const opt_view_group_db_t *opt_grp_db, /* [in] groupingOptViewで生成したopt_view_group_db_t */
+        int                        prop_id);   /* 引くオプションのID */
+
+extern int /* option_errcode_tのどれか */
+initOptIter( /* argcとargvを1グループずつ解析するイテレータを初期化する. argvはこの時点では読まない */
+        opt_iter_t              *it,           /* [out] 初期化するopt_iter_t */
+        const opt_property_db_t *opt_prop_db,  /* [in] 解析に用いるopt_property_db_t. itより長く生存しなければならない */
+        int                      argc,         /* mainの引数で受け取ったプログラムの引数の数(プログラム名含む) */
+        char                   **argv);        /* [in] mainの引数で受け取ったプログラムの引数(プログラム名含む). itより長く生存しなければならない */
+
+extern int /* OPTION_SUCCESS: grpに1グループ格納した, OPTION_ITER_END: 終端に到達した, それ以外: option_errcode_tのエラー */
+optIterNext( /* 次のグループを取り出す. コンテンツの数はそのグループの終わりで調べ, contents_checkerもそのグループにだけ適用する.
+              * 対応するオプションが無いコンテンツは, option.strがNULLでprop_idが-1の, コンテンツを1つだけ持つグループとして返す */
+        opt_iter_t       *it,   /* [mod] initOptIterで初期化したopt_iter_t */
+        opt_view_group_t *grp); /* [out] 取り出したグループ. ビューはargvか応答ファイルを指し, contentsは次のoptIterNextかfreeOptIterまで有効 */
+
+extern void
+freeOptIter( /* initOptIterとoptIterNextで確保したメモリ領域と応答ファイルのマッピングを開放する */
+        opt_iter_t *it); /* [mod] 開放するopt_iter_t */
+
+extern int /* option_errcode_tのどれか */
+initOptParser( /* opt_parser_tを初期化する */
+        opt_parser_t            *parser,       /* [out] 初期化するopt_parser_t */
+        const opt_property_db_t *opt_prop_db); /* [in] 解析に用いるopt_property_db_t. parserより長く生存しなければならない */
+
+extern void
+freeOptParser( /* initOptParserで確保したparserのメンバのメモリ領域を開放する */
+        opt_parser_t *parser); /* [mod] 開放するopt_parser_t */
+
+extern void
+setOptRspFileDepth( /* parserでの解析時に@fileの形の引数を応答ファイルとして展開するようにする. 開けない場合は@fileのまま扱う.
+                     * groupingOpt系は結果に全てのトークンを持つのでファイルの大きさに比例したメモリを使う. 一定のメモリで読むにはopt_iter_tのparserに指定する */
+        opt_parser_t *parser,     /* [mod] initOptParserで初期化したopt_parser_t */
+        int           depth_max); /* 応答ファイルの中の@fileを展開する入れ子の深さの上限. argvの@fileが深さ1. 0なら展開しない */
+
+extern void
+setOptDefaultSources( /* parserでのgroupingOptWithParserで, argvで指定されなかったオプションを環境変数と設定ファイルから補う.
+                       * 優先度は argv > 環境変数 > 設定ファイル で, 上位で指定されたオプションは下位の指定を丸ごと置き換える.
+                       * 同じ層で同じオプションを2回指定するとOPTION_DUPLICATE_SAME_OPTになり, コンテンツの数は補った後の結果で調べる.
+                       * コンテンツを取らないオプションの値は "1", "true", "0", "false" のような真偽値で, 偽なら下位の指定も打ち消す */
+        opt_parser_t *parser,      /* [mod] initOptParserで初期化したopt_parser_t */
+        const char   *config_path, /* [in] 設定ファイルのパス. NULLなら読まない. 無ければ読まない. 1行に "output = a.out" や "print a 'b c'" のように
+                                    * 詳細形式(先頭の -- は省略できる)と, 応答ファイルと同じく空白で区切ったコンテンツを書く. #から行末まではコメント.
+                                    * マップして複製せずに切り出し, 解析の度にstatしてiノードとサイズと更新日時が変わっていなければ前回のトークンを使い回す */
+        const char   *env_prefix); /* [in] 環境変数の接頭辞. 例えば "MYTOOL_" なら MYTOOL_DRY_RUN を --dry-run として読む. 登録されていない名前の環境変数は無視する */
+
+extern int /* OPTION_SUCCESS. ライブラリをOPT_STATSを定義せずにビルドした場合はOPTION_STATS_DISABLED */
+setOptStats( /* parserでのgroupingOptWithParserとgroupingOptViewWithParserの段階毎の所要時間と数をstatsに足し込むようにする */
+        opt_parser_t *parser, /* [mod] initOptParserで初期化したopt_parser_t */
+        opt_stats_t  *stats); /* [out] 足し込み先. NULLなら記録をやめる */
+
+extern int /* option_errcode_tのどれか */
+groupingOptWithParser( /* groupingOptと同じだが, 解析の状態と作業領域に呼び出し元が用意したparserを用いる */
+        opt_parser_t     *parser,      /* [mod] initOptParserで初期化したopt_parser_t */
+        int               argc,        /* mainの引数で受け取ったプログラムの引数の数(プログラム名含む) */
+        char            **argv,        /* [in] mainの引数で受け取ったプログラムの引数(プログラム名含む) */
+        opt_group_db_t  **opt_grp_db); /* [out] グルーピングされたオプション情報 */
+
+extern int /* option_errcode_tのどれか */
+groupingOptViewWithParser( /* groupingOptViewと同じだが, 解析の状態と作業領域に呼び出し元が用意したparserを用いる */
+        opt_parser_t         *parser,      /* [mod] initOptParserで初期化したopt_parser_t */
+        int                   argc,        /* mainの引数で受け取ったプログラムの引数の数(プログラム名含む) */
+        char                **argv,        /* [in] mainの引数で受け取ったプログラムの引数(プログラム名含む) */
+        opt_view_group_db_t **opt_grp_db); /* [out] グルーピングされたオプション情報 */
+
+extern int /* option_errcode_tのどれか */
+groupingOptCommand( /* argcとargvを1回走査してサブコマンドの木を辿り, 各コマンドの引数をそのコマンドのopt_property_db_tでグルーピングする.
+                     * オプションでもそのコンテンツでもない引数がサブコマンドの名前に一致したら, 以降はそのサブコマンドの引数になる.
+                     * 辿ったコマンドのopt_property_db_tだけを用いるので, 選ばれなかったコマンドの索引は構築されない */
+        const opt_command_t      *root,        /* [in] サブコマンドの木の根. 根のオプション(例えば git -C dir commit の -C)はサブコマンドより前に書く */
+        int                       argc,        /* mainの引数で受け取ったプログラムの引数の数(プログラム名含む) */
+        char                    **argv,        /* [in] mainの引数で受け取ったプログラムの引数(プログラム名含む) */
+        opt_command_group_db_t  **cmd_grp_db); /* [out] 根から選ばれたサブコマンドまでのグルーピング結果 */
+
+extern void
+freeOptCommandGroupDB( /* groupingOptCommandで生成したopt_command_group_db_tをサブコマンドの結果も含めて開放する */
+        opt_command_group_db_t *cmd_grp_db); /* [in] 開放するopt_command_group_db_t */
+
+extern int /* option_errcode_tのどれか. 個々のopt_argv_tの解析結果はerr_codesに格納される */
+groupingOptBatch( /* 複数のプログラムの引数を1つのopt_property_db_tをもとにworker_num個のスレッドで並列にグルーピングする. 仕事が偏った場合は暇なスレッドが他のスレッドの残りを奪う */
+        const opt_property_db_t *opt_prop_db, /* [in] オプション情報が登録されたopt_property_db_t. 全てのスレッドで読み取り専用に共有される */
+        int                      item_num,    /* itemsのサイズ */
+        const opt_argv_t        *items,       /* [in] グルーピングするプログラムの引数の配列 */
+        int                      worker_num,  /* スレッドの数. 0以下ならオンラインのCPUの数 */
+        opt_group_batch_t      **batch);      /* [out] グルーピングされたオプション情報とエラーコード */
+
+extern void
+freeOptGroupBatch( /* groupingOptBatchで生成したopt_group_batch_tを各結果も含めて開放する */
+        opt_group_batch_t *batch); /* [in] 開放するopt_group_batch_t */
+
 #endif
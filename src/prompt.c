@@ -31,94 +31,513 @@ const char DEFAULT_SC_DIVE_HIST[]  = {0x1b, 0x5b, 0x41, 0x00};
 const char DEFAULT_SC_FLOAT_HIST[] = {0x1b, 0x5b, 0x42, 0x00};
 static const char right[]          = {0x1b, 0x5b, 0x43, 0x00};
 static const char left[]           = {0x1b, 0x5b, 0x44, 0x00};
-static const char delete[]         = {0x1b, 0x5b, 0x33, 0x7e, 0x1b, 0x00};
+static const char delete[]         = {0x1b, 0x5b, 0x33, 0x7e, 0x00};
+static const char paste_begin[]    = {0x1b, 0x5b, 0x32, 0x30, 0x30, 0x7e, 0x00};
+static const char paste_end[]      = {0x1b, 0x5b, 0x32, 0x30, 0x31, 0x7e, 0x00};
 
 /* ====================================== */
 
-static char
-getch(void)
+/* 端末は1つなので, 生モードの状態と先読みしたキー入力はプロセスで共有する */
+#define KEYIN_BUF_SIZE 4096
+
+static struct termios           cooked_termios;           /* 生モードに入る前の設定. シグナルハンドラからも戻す */
+static struct termios           raw_termios;
+static volatile sig_atomic_t    raw_active     = 0;       /* 端末を生モードにしているか */
+static bool                     paste_enabled  = 0;       /* 端末のbracketed pasteを有効にしたか */
+static int                      session_depth  = 0;       /* beginRawSession()の入れ子の深さ */
+static const int                raw_signals[]  = {SIGINT, SIGQUIT, SIGTERM, SIGHUP, SIGTSTP};
+#define RAW_SIGNAL_NUM ((int)(sizeof(raw_signals)/sizeof(raw_signals[0])))
+static struct sigaction         prev_actions[RAW_SIGNAL_NUM];
+static char                     keyin_buf[KEYIN_BUF_SIZE];
+static int                      keyin_head     = 0;       /* 次に返すkeyin_bufの添字 */
+static int                      keyin_tail     = 0;       /* keyin_bufに読み込んだ末尾の次の添字 */
+
+static void
+switchBracketedPaste( /* 貼り付けを開始と終了の印で囲ませる. シグナルハンドラからも呼ぶ */
+        bool on)
+{
+    if(paste_enabled){
+        const char *seq = on ? "\x1b[?2004h" : "\x1b[?2004l";
+        while(write(STDOUT_FILENO, seq, strlen(seq)) < 0 && errno == EINTR);
+    }
+}
+
+static void
+rawSignalHandler( /* 端末を元に戻してから元の動作でシグナルを処理し, 戻ってきたら生モードに戻す */
+        int sig)
+{
+    int saved_errno = errno;
+    int i;
+    for(i=0; i<RAW_SIGNAL_NUM && raw_signals[i] != sig; i++);
+
+    struct sigaction self;
+    sigaction(sig, &prev_actions[i], &self);
+    switchBracketedPaste(0);
+    tcsetattr(STDIN_FILENO, TCSADRAIN, &cooked_termios);
+
+    /* ハンドラの実行中はsigがブロックされているので, 解除して元の動作(終了, 停止, 利用者のハンドラ)を起こす */
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, sig);
+    raise(sig);
+    sigprocmask(SIG_UNBLOCK, &mask, NULL);
+
+    /* 終了しなかった場合(SIGTSTPからの再開など) */
+    sigaction(sig, &self, NULL);
+    if(raw_active){
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw_termios);
+        switchBracketedPaste(1);
+    }
+    errno = saved_errno;
+}
+
+int
+beginRawSession(void)
+{
+    if(session_depth++ > 0 || !isatty(STDIN_FILENO)){
+        return 0;
+    }
+
+    if(tcgetattr(STDIN_FILENO, &cooked_termios) < 0){
+        session_depth--;
+        return 1;
+    }
+    raw_termios = cooked_termios;
+    raw_termios.c_lflag     &= ~(ICANON | ECHO);
+    raw_termios.c_cc[VMIN]   = 1;
+    raw_termios.c_cc[VTIME]  = 0;
+
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+    act.sa_handler = rawSignalHandler;
+    sigemptyset(&act.sa_mask);
+    for(int i=0; i<RAW_SIGNAL_NUM; i++){
+        sigaction(raw_signals[i], &act, &prev_actions[i]);
+    }
+
+    raw_active = 1;
+    if(tcsetattr(STDIN_FILENO, TCSANOW, &raw_termios) < 0){
+        raw_active = 0;
+        for(int i=0; i<RAW_SIGNAL_NUM; i++){
+            sigaction(raw_signals[i], &prev_actions[i], NULL);
+        }
+        session_depth--;
+        return 1;
+    }
+    paste_enabled = isatty(STDOUT_FILENO);
+    switchBracketedPaste(1);
+    return 0;
+}
+
+void
+endRawSession(void)
 {
-    char   buf         = 0;
-    struct termios old = {0};
+    if(session_depth == 0 || --session_depth > 0 || !raw_active){
+        return;
+    }
 
     fflush(stdout);
+    raw_active = 0;
+    switchBracketedPaste(0);
+    paste_enabled = 0;
+    tcsetattr(STDIN_FILENO, TCSADRAIN, &cooked_termios);
+    for(int i=0; i<RAW_SIGNAL_NUM; i++){
+        sigaction(raw_signals[i], &prev_actions[i], NULL);
+    }
+}
 
-    if(tcgetattr(0, &old)<0){
-        perror("tcsetattr()");
+static bool
+keyPending(void) /* 先読みした入力が残っているか */
+{
+    return keyin_head != keyin_tail;
+}
+
+static int /* 0: success, 1: the input ends or fails */
+fillKeyin(void) /* 読み残しを先頭に寄せて, その後ろに読めるだけ読む */
+{
+    ssize_t n;
+    if(keyin_head > 0){
+        memmove(keyin_buf, &keyin_buf[keyin_head], keyin_tail - keyin_head);
+        keyin_tail -= keyin_head;
+        keyin_head  = 0;
+    }
+    fflush(stdout);
+    while((n = read(STDIN_FILENO, &keyin_buf[keyin_tail], KEYIN_BUF_SIZE - keyin_tail)) < 0 && errno == EINTR);
+    if(n <= 0){
+        return 1;
     }
+    keyin_tail += n;
+    return 0;
+}
 
-    old.c_lflag&=~ICANON;
-    old.c_lflag&=~ECHO;
-    old.c_cc[VMIN]=1;
-    old.c_cc[VTIME]=0;
+static int /* 入力された1バイト. 入力の終わりか読み込みに失敗した場合はEOF */
+getch(void)
+{
+    /* 先読みした分が無くなった時だけ読む. 矢印キーや貼り付けは1回のreadでまとめて届く */
+    if(keyin_head == keyin_tail && fillKeyin() != 0){
+        return EOF;
+    }
+    return (unsigned char)keyin_buf[keyin_head++];
+}
 
-    if(tcsetattr(0, TCSANOW, &old)<0){
-        perror("tcsetattr ICANON");
+static int /* number of characters inserted. -1 if out of memory */
+pasteKeys( /* insert the keys until the end of bracketed paste into lb at once. they are not taken as shortcuts */
+        linebuf_t *lb)
+{
+    const int end_len  = strlen(paste_end);
+    int       inserted = 0;
+
+    while(1){
+        if(keyin_head == keyin_tail && fillKeyin() != 0){
+            return inserted;
+        }
+
+        char *head = &keyin_buf[keyin_head];
+        int   len  = keyin_tail - keyin_head;
+        char *end  = memmem(head, len, paste_end, end_len);
+        int   n    = end ? end - head : len;
+        int   keep = 0;
+        if(!end){
+            /* 終了の印がreadの境目で切れているかもしれないので, その分は次に読んだ分と合わせて調べる */
+            for(keep = end_len-1 < len ? end_len-1 : len; keep > 0 && memcmp(&head[len-keep], paste_end, keep) != 0; keep--);
+            n -= keep;
+        }
+
+        /* 改行やタブは1行の中の空白にする */
+        for(int i=0; i<n; i++){
+            if((unsigned char)head[i] < 0x20 || head[i] == 0x7f){
+                head[i] = ' ';
+            }
+        }
+        if(insertLineBuf(lb, head, n) != 0){
+            return -1;
+        }
+        inserted   += n;
+        keyin_head += n;
+
+        if(end){
+            keyin_head += end_len;
+            return inserted;
+        }
+        if(keep > 0 && fillKeyin() != 0){
+            return inserted;
+        }
     }
+}
+
+/* ====================================== */
+
+#define LINEBUF_MIN_SIZE 64
 
-    if(read(0,&buf,1)<0){
-        perror("read()");
+linebuf_t*
+genLineBuf(
+        int capacity)
+{
+    linebuf_t *lb = (linebuf_t *)malloc(sizeof(linebuf_t));
+    if(!lb){
+        return NULL;
     }
-    
-    old.c_lflag|=ICANON;
-    old.c_lflag|=ECHO;
 
-    if(tcsetattr(0, TCSADRAIN, &old)<0){
-        perror ("tcsetattr ~ICANON");
+    lb -> size = capacity < LINEBUF_MIN_SIZE ? LINEBUF_MIN_SIZE : capacity;
+    if(!(lb -> buf = (char *)malloc(sizeof(char)*lb->size))){
+        free(lb);
+        return NULL;
+    }
+    lb -> gap_head = 0;
+    lb -> gap_tail = lb -> size;
+    return lb;
+}
+
+static int /* 0: success, 1: out of memory */
+growLineBuf( /* make the gap at least need characters. the size is doubled so that inserting one by one is amortized O(1) */
+        linebuf_t *lb,
+        int        need)
+{
+    if(lb->gap_tail - lb->gap_head >= need){
+        return 0;
     }
 
-    return buf;
+    int after    = lb->size - lb->gap_tail;
+    int new_size = lb -> size;
+    while(new_size - lb->gap_head - after < need){
+        if(new_size > INT_MAX/2){
+            return 1;
+        }
+        new_size *= 2;
+    }
+
+    char *new_buf = (char *)realloc(lb->buf, sizeof(char)*new_size);
+    if(!new_buf){
+        return 1;
+    }
+    /* the characters after the cursor stay at the end of the buffer */
+    memmove(&new_buf[new_size - after], &new_buf[lb->gap_tail], after);
+    lb -> buf      = new_buf;
+    lb -> size     = new_size;
+    lb -> gap_tail = new_size - after;
+    return 0;
 }
 
-static void
-strndelete( /* NOTE: posの値がstrの範囲内にあるかの確認は呼び出しもとで行っているものとする */
-        int    pos,
-        char **str) /* [out] */
+int
+insertLineBuf(
+              linebuf_t *lb,
+        const char      *str,
+              int        len)
 {
-    if(*str == NULL){
-        return;
+    if(len <= 0){
+        return 0;
+    }
+    if(growLineBuf(lb, len) != 0){
+        return 1;
+    }
+    memcpy(&(lb -> buf[lb->gap_head]), str, len);
+    lb -> gap_head += len;
+    return 0;
+}
+
+void
+deleteLineBuf(
+        linebuf_t *lb,
+        int        before,
+        int        after)
+{
+    if(before > 0){
+        lb -> gap_head -= before < lb->gap_head ? before : lb->gap_head;
+    }
+    if(after > 0){
+        lb -> gap_tail += after < lb->size - lb->gap_tail ? after : lb->size - lb->gap_tail;
     }
+}
+
+void
+moveLineBuf(
+        linebuf_t *lb,
+        int        pos)
+{
+    int len = lineBufLen(lb);
+    pos = pos < 0 ? 0 : pos > len ? len : pos;
+
+    /* move the characters between the old and the new cursor to the other side of the gap */
+    if(pos < lb->gap_head){
+        int n = lb->gap_head - pos;
+        memmove(&(lb -> buf[lb->gap_tail - n]), &(lb -> buf[pos]), n);
+        lb -> gap_head  = pos;
+        lb -> gap_tail -= n;
+    }
+    else if(pos > lb->gap_head){
+        int n = pos - lb->gap_head;
+        memmove(&(lb -> buf[lb->gap_head]), &(lb -> buf[lb->gap_tail]), n);
+        lb -> gap_head  = pos;
+        lb -> gap_tail += n;
+    }
+}
 
-    int str_len = strlen(*str);
+int
+setLineBuf(
+              linebuf_t *lb,
+        const char      *str)
+{
+    lb -> gap_head = 0;
+    lb -> gap_tail = lb -> size;
+    return str == NULL ? 0 : insertLineBuf(lb, str, strlen(str));
+}
 
-    if(str_len == 1){
-        free(*str);
-        *str = NULL;
-        return;
+int
+lineBufLen(
+        const linebuf_t *lb)
+{
+    return lb->size - (lb->gap_tail - lb->gap_head);
+}
+
+int
+lineBufAt(
+        const linebuf_t *lb,
+              int        pos)
+{
+    if(pos < 0 || pos >= lineBufLen(lb)){
+        return '\0';
     }
-    (*str)[pos] = '\0';
-    *str = (char *)realloc(*str, sizeof(char)*(str_len-1));
-    if(str_len == pos+1){
-        return;
+    return pos < lb->gap_head ? lb->buf[pos] : lb->buf[pos + lb->gap_tail - lb->gap_head];
+}
+
+char*
+dupLineBuf(
+        const linebuf_t *lb)
+{
+    int   after = lb->size - lb->gap_tail;
+    char *str   = (char *)malloc(sizeof(char)*(lb->gap_head + after + 1));
+    if(!str){
+        return NULL;
+    }
+    memcpy(str, lb->buf, lb->gap_head);
+    memcpy(&str[lb->gap_head], &(lb -> buf[lb->gap_tail]), after);
+    str[lb->gap_head + after] = '\0';
+    return str;
+}
+
+void
+freeLineBuf(
+        linebuf_t *lb)
+{
+    if(lb){
+        free(lb -> buf);
+        free(lb);
+    }
+}
+
+/* ====================================== */
+
+#define FRAME_MIN_SIZE   256
+#define FRAME_FLUSH_SIZE 65536 /* 貼り付けなどで先読みした入力が続いてもこれを超えたら書き出す */
+
+static frame_t*
+genFrame(void)
+{
+    frame_t *frame = (frame_t *)malloc(sizeof(frame_t));
+    if(!frame){
+        return NULL;
     }
-    sprintf(*str, "%s%s", *str, &(*str)[pos+1]);
+    if(!(frame -> buf = (char *)malloc(sizeof(char)*FRAME_MIN_SIZE))){
+        free(frame);
+        return NULL;
+    }
+    frame -> size     = FRAME_MIN_SIZE;
+    frame -> len      = 0;
+    frame -> line_len = 0;
+    frame -> cursor   = 0;
+    return frame;
 }
 
 static void
-strninsert( /* NOTE: posの値がstrの範囲内にあるかの確認は呼び出しもとで行っているものとする */
-        int    pos,
-        char **str, /* [out] */
-        char   ch)
-{
-    if(*str == NULL){
-        *str = (char *)malloc(sizeof(char) * 2);
-        (*str)[0] = ch;
-        (*str)[1] = '\0';
-        return;
+freeFrame(
+        frame_t *frame)
+{
+    if(frame){
+        free(frame -> buf);
+        free(frame);
     }
+}
 
-    char *new = (char *)malloc(sizeof(char)*(strlen(*str)+2));
+static void
+writeAll(
+        const char *buf,
+              int   len)
+{
+    while(len > 0){
+        ssize_t n = write(STDOUT_FILENO, buf, len);
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+        if(n <= 0){
+            return;
+        }
+        buf += n;
+        len -= n;
+    }
+}
 
-    if(!new){
-        free(*str);
-        *str = NULL;
-        return;
+static void
+flushFrame( /* write the frame with one write(). printf()ed output such as completion candidates goes first */
+        frame_t *frame)
+{
+    fflush(stdout);
+    writeAll(frame->buf, frame->len);
+    frame -> len = 0;
+}
+
+static void
+appendFrame(
+              frame_t *frame,
+        const char    *str,
+              int      len)
+{
+    if(frame->size - frame->len < len){
+        int new_size = frame -> size;
+        while(new_size - frame->len < len && new_size <= INT_MAX/2){
+            new_size *= 2;
+        }
+        char *new_buf = new_size - frame->len < len ? NULL : (char *)realloc(frame->buf, sizeof(char)*new_size);
+        if(!new_buf){
+            /* 大きくできなければ溜まった分を書き出してから直接書く */
+            flushFrame(frame);
+            writeAll(str, len);
+            return;
+        }
+        frame -> buf  = new_buf;
+        frame -> size = new_size;
     }
+    memcpy(&(frame -> buf[frame->len]), str, len);
+    frame -> len += len;
+}
 
-    strcpy(new, *str);
-    sprintf(&(new[pos]), "%c%s", ch, &((*str)[pos]));
-    free(*str);
-    *str = new;
+static void
+appendCsi( /* CSI n final. e.g. CSI 3 D moves the cursor 3 columns left */
+        frame_t *frame,
+        int      n,
+        char     final)
+{
+    char csi[16];
+    int  len = n == 1 ? sprintf(csi, "\x1b[%c", final) : sprintf(csi, "\x1b[%d%c", n, final);
+    appendFrame(frame, csi, len);
+}
+
+static void
+drawMove( /* move the cursor on the console to the cursor of lb */
+              frame_t   *frame,
+        const linebuf_t *lb)
+{
+    if(lb->gap_head > frame->cursor){
+        appendCsi(frame, lb->gap_head - frame->cursor, 'C');
+    }
+    else if(lb->gap_head < frame->cursor){
+        appendCsi(frame, frame->cursor - lb->gap_head, 'D');
+    }
+    frame -> cursor = lb -> gap_head;
+}
+
+static void
+drawInsert( /* draw n characters just inserted before the cursor of lb */
+              frame_t   *frame,
+        const linebuf_t *lb,
+              int        n)
+{
+    /* 行末でなければ後ろの文字を端末にずらしてもらう */
+    if(frame->cursor < frame->line_len){
+        appendCsi(frame, n, '@');
+    }
+    appendFrame(frame, &(lb -> buf[lb->gap_head - n]), n);
+    frame -> cursor   += n;
+    frame -> line_len += n;
+}
+
+static void
+drawDelete( /* draw deleting before characters before the cursor and after characters after it */
+        frame_t *frame,
+        int      before,
+        int      after)
+{
+    if(before > 0){
+        appendCsi(frame, before, 'D');
+        frame -> cursor -= before;
+    }
+    appendCsi(frame, before + after, 'P');
+    frame -> line_len -= before + after;
+}
+
+static void
+drawLine( /* redraw the prompt and the whole line */
+              frame_t   *frame,
+        const char      *prompt,
+        const linebuf_t *lb)
+{
+    appendFrame(frame, "\r", 1);
+    appendFrame(frame, prompt, strlen(prompt));
+    appendFrame(frame, lb->buf, lb->gap_head);
+    appendFrame(frame, &(lb -> buf[lb->gap_tail]), lb->size - lb->gap_tail);
+    appendFrame(frame, "\x1b[K", 3);
+    frame -> line_len = lineBufLen(lb);
+    frame -> cursor   = frame -> line_len;
+    drawMove(frame, lb);
 }
 
 /* ====================================== */
@@ -250,6 +669,220 @@ readRingBuf(
 
 /* ================================================== */
 
+#define KEYMAP_MIN_BIND_NUM  16
+#define KEYMAP_MIN_STATE_NUM 32
+
+static int /* 0: success, 1: out of memory */
+setKeyBindSeq(
+              keybind_t *kb,
+        const char      *seq) /* [in] NULL or "" unbinds */
+{
+    char *copy = NULL;
+    if(seq && seq[0] != '\0' && !(copy = strdup(seq))){
+        return 1;
+    }
+    free(kb -> seq);
+    kb -> seq = copy;
+    return 0;
+}
+
+static int /* 0: success, 1: out of memory */
+addKeyBind(
+              keymap_t     *km,
+        const char         *seq,
+              rwh_action_t  action)
+{
+    if(km->bind_num == km->bind_size){
+        keybind_t *new_binds = (keybind_t *)realloc(km->binds, sizeof(keybind_t)*km->bind_size*2);
+        if(!new_binds){
+            return 1;
+        }
+        km -> binds      = new_binds;
+        km -> bind_size *= 2;
+    }
+    keybind_t *kb = &(km -> binds[km->bind_num]);
+    kb -> seq    = NULL;
+    kb -> action = action;
+    if(setKeyBindSeq(kb, seq) != 0){
+        return 1;
+    }
+    km -> bind_num++;
+    return 0;
+}
+
+static int /* the new state. 0 if out of memory */
+addKeyState(
+        keymap_t *km)
+{
+    if(km->state_num == km->state_size){
+        int  (*new_next)[256] = (int (*)[256])realloc(km->next, sizeof(int[256])*km->state_size*2);
+        if(!new_next){
+            return 0;
+        }
+        km -> next = new_next;
+        int *new_bind = (int *)realloc(km->bind, sizeof(int)*km->state_size*2);
+        if(!new_bind){
+            return 0;
+        }
+        km -> bind        = new_bind;
+        km -> state_size *= 2;
+    }
+    memset(km->next[km->state_num], 0, sizeof(int[256]));
+    km -> bind[km->state_num] = -1;
+    return km -> state_num++;
+}
+
+static int /* 0: success, 1: out of memory */
+insertKeyBind( /* add the path of binds[bind_i] to the trie */
+        keymap_t *km,
+        int       bind_i,
+        bool      override) /* replace the binding already ending at the same state */
+{
+    const unsigned char *seq   = (const unsigned char *)km->binds[bind_i].seq;
+    int                  state = 0;
+    if(!seq){
+        return 0;
+    }
+    for(int i=0; seq[i] != '\0'; i++){
+        if(km->next[state][seq[i]] == 0){
+            int new_state = addKeyState(km);
+            if(new_state == 0){
+                return 1;
+            }
+            km -> next[state][seq[i]] = new_state;
+        }
+        state = km -> next[state][seq[i]];
+    }
+    if(override || km->bind[state] == -1){
+        km -> bind[state] = bind_i;
+    }
+    return 0;
+}
+
+static int /* 0: success, 1: out of memory */
+compileKeymap( /* build the trie from scratch */
+        keymap_t *km)
+{
+    const int fixed_num = RWH_SC_NUM + 4;
+
+    km -> state_num = 0;
+    addKeyState(km);
+
+    /* bindRwhKey()で後から加えたものほど優先し, その次はsc_*, 矢印キーなどの順. 同じ列は先に入れた方が残る */
+    for(int i=km->bind_num-1; i>=fixed_num; i--){
+        if(insertKeyBind(km, i, 0) != 0){
+            return 1;
+        }
+    }
+    for(int i=0; i<fixed_num; i++){
+        if(insertKeyBind(km, i, 0) != 0){
+            return 1;
+        }
+    }
+    km -> dirty = 0;
+    return 0;
+}
+
+static keymap_t* /* NULL if fails */
+genKeymap(void)
+{
+    keymap_t *km = (keymap_t *)calloc(1, sizeof(keymap_t));
+    if(!km){
+        return NULL;
+    }
+    km -> binds      = (keybind_t *)malloc(sizeof(keybind_t)*KEYMAP_MIN_BIND_NUM);
+    km -> bind_size  = KEYMAP_MIN_BIND_NUM;
+    km -> next       = (int (*)[256])malloc(sizeof(int[256])*KEYMAP_MIN_STATE_NUM);
+    km -> bind       = (int *)malloc(sizeof(int)*KEYMAP_MIN_STATE_NUM);
+    km -> state_size = KEYMAP_MIN_STATE_NUM;
+    km -> dirty      = 1;
+    if(!km->binds || !km->next || !km->bind){
+        goto free_and_exit;
+    }
+
+    /* sc_*の分はrwh()の最初にsyncKeymap()で写す */
+    for(int i=0; i<RWH_SC_NUM; i++){
+        if(addKeyBind(km, NULL, (rwh_action_t)(RWH_ACTION_HEAD + i)) != 0){
+            goto free_and_exit;
+        }
+    }
+    if(addKeyBind(km, right,       RWH_ACTION_RIGHT)  != 0 ||
+       addKeyBind(km, left,        RWH_ACTION_LEFT)   != 0 ||
+       addKeyBind(km, delete,      RWH_ACTION_DELETE) != 0 ||
+       addKeyBind(km, paste_begin, RWH_ACTION_PASTE)  != 0)
+    {
+        goto free_and_exit;
+    }
+    return km;
+
+free_and_exit:
+    for(int i=0; i<km->bind_num; i++){
+        free(km -> binds[i].seq);
+    }
+    free(km -> binds);
+    free(km -> next);
+    free(km -> bind);
+    free(km);
+    return NULL;
+}
+
+static void
+freeKeymap(
+        keymap_t *km)
+{
+    if(km){
+        for(int i=0; i<km->bind_num; i++){
+            free(km -> binds[i].seq);
+        }
+        free(km -> binds);
+        free(km -> next);
+        free(km -> bind);
+        free(km);
+    }
+}
+
+static int /* 0: success, 1: out of memory */
+syncKeymap( /* copy the sc_* fields changed since the last rwh() and compile the trie again if needed */
+        rwhctx_t *ctx)
+{
+    keymap_t   *km = ctx -> keymap;
+    const char *sc[RWH_SC_NUM] = {
+        ctx -> sc_head, ctx -> sc_tail, ctx -> sc_next_block, ctx -> sc_prev_block,
+        ctx -> sc_completion, ctx -> sc_dive_hist, ctx -> sc_float_hist,
+    };
+
+    for(int i=0; i<RWH_SC_NUM; i++){
+        const char *seen = km->binds[i].seq ? km->binds[i].seq : "";
+        if(sc[i] != km->sc_seen[i] || strcmp(sc[i] ? sc[i] : "", seen) != 0){
+            if(setKeyBindSeq(&(km -> binds[i]), sc[i]) != 0){
+                return 1;
+            }
+            km -> sc_seen[i] = sc[i];
+            km -> dirty      = 1;
+        }
+    }
+    return km->dirty ? compileKeymap(km) : 0;
+}
+
+int
+bindRwhKey(
+              rwhctx_t     *ctx,
+        const char         *seq,
+              rwh_action_t  action)
+{
+    keymap_t *km = ctx -> keymap;
+    if(!seq || seq[0] == '\0' || addKeyBind(km, seq, action) != 0){
+        return 1;
+    }
+    /* 最も優先するので, 作ってある木に道を足すだけでよい */
+    if(!km->dirty && insertKeyBind(km, km->bind_num-1, 1) != 0){
+        km -> dirty = 1;
+    }
+    return 0;
+}
+
+/* ================================================== */
+
 rwhctx_t*
 genRwhCtx(
         const char  *prompt,         /* [in] prompt */
@@ -279,6 +912,21 @@ genRwhCtx(
     ctx -> sc_completion = NULL;
     ctx -> sc_dive_hist  = NULL;
     ctx -> sc_float_hist = NULL;
+    ctx -> line          = NULL;
+    ctx -> frame         = NULL;
+    ctx -> keymap        = NULL;
+
+    if(!(ctx -> keymap = genKeymap())){
+        goto free_and_exit;
+    }
+
+    if(!(ctx -> line = genLineBuf(0))){
+        goto free_and_exit;
+    }
+
+    if(!(ctx -> frame = genFrame())){
+        goto free_and_exit;
+    }
 
     if(!(ctx -> history = (ringbuf_t *)malloc(sizeof(ringbuf_t)))){
         goto free_and_exit;
@@ -294,31 +942,31 @@ genRwhCtx(
     }
     memset(ctx -> history -> buf, 0, history_size);
 
-    if(!(ctx -> sc_head       = malloc(sizeof(char)*strlen(DEFAULT_SC_HEAD)))){
+    if(!(ctx -> sc_head       = malloc(sizeof(char)*(strlen(DEFAULT_SC_HEAD)+1)))){
         goto free_and_exit;
     }
 
-    if(!(ctx -> sc_tail       = malloc(sizeof(char)*strlen(DEFAULT_SC_TAIL)))){
+    if(!(ctx -> sc_tail       = malloc(sizeof(char)*(strlen(DEFAULT_SC_TAIL)+1)))){
         goto free_and_exit;
     }
 
-    if(!(ctx -> sc_next_block = malloc(sizeof(char)*strlen(DEFAULT_SC_NEXT_BLOCK)))){
+    if(!(ctx -> sc_next_block = malloc(sizeof(char)*(strlen(DEFAULT_SC_NEXT_BLOCK)+1)))){
         goto free_and_exit;
     }
 
-    if(!(ctx -> sc_prev_block = malloc(sizeof(char)*strlen(DEFAULT_SC_PREV_BLOCK)))){
+    if(!(ctx -> sc_prev_block = malloc(sizeof(char)*(strlen(DEFAULT_SC_PREV_BLOCK)+1)))){
         goto free_and_exit;
     }
 
-    if(!(ctx -> sc_completion = malloc(sizeof(char)*strlen(DEFAULT_SC_COMPLETION)))){
+    if(!(ctx -> sc_completion = malloc(sizeof(char)*(strlen(DEFAULT_SC_COMPLETION)+1)))){
         goto free_and_exit;
     }
 
-    if(!(ctx -> sc_dive_hist  = malloc(sizeof(char)*strlen(DEFAULT_SC_DIVE_HIST)))){
+    if(!(ctx -> sc_dive_hist  = malloc(sizeof(char)*(strlen(DEFAULT_SC_DIVE_HIST)+1)))){
         goto free_and_exit;
     }
 
-    if(!(ctx -> sc_float_hist = malloc(sizeof(char)*strlen(DEFAULT_SC_FLOAT_HIST)))){
+    if(!(ctx -> sc_float_hist = malloc(sizeof(char)*(strlen(DEFAULT_SC_FLOAT_HIST)+1)))){
         goto free_and_exit;
     }
 
@@ -337,362 +985,294 @@ free_and_exit:
     free(ctx -> sc_completion);
     free(ctx -> sc_next_block);
     free(ctx -> sc_prev_block);
-    free(ctx -> sc_dive_hist);
     free(ctx -> sc_tail);
     free(ctx -> sc_head);
-    if(!(ctx -> history)){
+    if(ctx -> history){
         free(ctx -> history -> buf);
     }
     free(ctx -> history);
+    freeLineBuf(ctx -> line);
+    freeFrame(ctx -> frame);
+    freeKeymap(ctx -> keymap);
     free(ctx);
     return NULL;
 }
 
 
-typedef enum{
-    JS_NOT_SHORT_CUT = 0,
-    JS_UNKNOWN_YET   = 1,
-    JS_HEAD          = 2,
-    JS_TAIL          = 3,
-    JS_NEXT_BLOCK    = 4,
-    JS_PREV_BLOCK    = 5,
-    JS_COMPLETION    = 6,
-    JS_DIVE_HIST     = 7,
-    JS_FLOAT_HIST    = 8,
-    JS_RIGHT         = 9,  /* ショートカットでは無いがカーソル右が制御信号なので */ 
-    JS_LEFT          = 10, /* ショートカットでは無いがカーソル左が制御信号なので */ 
-    JS_DELETE        = 11, /* ショートカットでは無いがデリートキーが制御信号なので */ 
-}judgeShortCut_errcode_t;
-
 static int
-judgeShortCut(
-        rwhctx_t    *ctx,
-        const char *str)
+auxNextPrevBlock(
+              int        step, /* 1 for the next block, -1 for the previous block */
+              int        curent_cursor_pos,
+        const linebuf_t *lb)
 {
-    /* flags */
-    bool sc_head_possibility       = 1;
-    bool sc_tail_possibility       = 1;
-    bool sc_next_block_possibility = 1;
-    bool sc_prev_block_possibility = 1;
-    bool sc_completion_possibility = 1;
-    bool sc_dive_hist_possibility  = 1;
-    bool sc_float_hist_possibility = 1;
-    bool right_possibility         = 1;
-    bool left_possibility          = 1;
-    bool delete_possibility        = 1;
-
-    int str_len = strlen(str);
-
-    for(int i=0; i<strlen(str); i++){
-        int sc_len;
-        if(sc_head_possibility){
-            sc_len = strlen(ctx->sc_head);
-            sc_head_possibility = sc_len >= str_len && ctx->sc_head[i] == str[i];
-            if(sc_head_possibility && i == sc_len-1){
-                return JS_HEAD;
-            }
-        }
-        if(sc_tail_possibility){
-            sc_len = strlen(ctx->sc_tail);
-            sc_tail_possibility = sc_len >= str_len && ctx->sc_tail[i] == str[i];
-            if(sc_tail_possibility && i == sc_len-1){
-                return JS_TAIL;
-            }
-        }
-        if(sc_next_block_possibility){
-            sc_len = strlen(ctx->sc_next_block);
-            sc_next_block_possibility = sc_len >= str_len && ctx->sc_next_block[i] == str[i];
-            if(sc_next_block_possibility && i == sc_len-1){
-                return JS_NEXT_BLOCK;
-            }
-        }
-        if(sc_prev_block_possibility){
-            sc_len = strlen(ctx->sc_prev_block);
-            sc_prev_block_possibility = sc_len >= str_len && ctx->sc_prev_block[i] == str[i];
-            if(sc_prev_block_possibility && i == sc_len-1){
-                return JS_PREV_BLOCK;
-            }
-        }
-        if(sc_completion_possibility){
-            sc_len = strlen(ctx->sc_completion);
-            sc_completion_possibility = sc_len >= str_len && ctx->sc_completion[i] == str[i];
-            if(sc_completion_possibility && i == sc_len-1){
-                return JS_COMPLETION;
-            }
-        }
-        if(sc_dive_hist_possibility){
-            sc_len = strlen(ctx->sc_dive_hist);
-            sc_dive_hist_possibility = sc_len >= str_len && ctx->sc_dive_hist[i] == str[i];
-            if(sc_dive_hist_possibility && i == sc_len-1){
-                return JS_DIVE_HIST;
-            }
-        }
-        if(sc_float_hist_possibility){
-            sc_len = strlen(ctx->sc_float_hist);
-            sc_float_hist_possibility = sc_len >= str_len && ctx->sc_float_hist[i] == str[i];
-            if(sc_float_hist_possibility && i == sc_len-1){
-                return JS_FLOAT_HIST;
-            }
-        }
-        if(right_possibility){
-            sc_len = strlen(right);
-            right_possibility = sc_len >= str_len && right[i] == str[i];
-            if(right_possibility && i == sc_len-1){
-                return JS_RIGHT;
-            }
-        }
-        if(left_possibility){
-            sc_len = strlen(left);
-            left_possibility = sc_len >= str_len && left[i] == str[i];
-            if(left_possibility && i == sc_len-1){
-                return JS_LEFT;
-            }
-        }
-        if(delete_possibility){
-            sc_len = strlen(delete);
-            delete_possibility = sc_len >= str_len && delete[i] == str[i];
-            if(delete_possibility && i == sc_len-1){
-                return JS_DELETE;
-            }
+    /* loop instead of recursion so that a long line does not overflow the stack */
+    while(1){
+        if(curent_cursor_pos + step == 0){
+            return 0;
         }
-    }
-
-    if(sc_head_possibility || sc_tail_possibility ||
-    sc_next_block_possibility || sc_prev_block_possibility ||
-    sc_completion_possibility || sc_dive_hist_possibility ||
-    sc_float_hist_possibility || right_possibility ||
-    left_possibility || delete_possibility)
-    {
-        return JS_UNKNOWN_YET;
-    }
-
-    return JS_NOT_SHORT_CUT;
-}
 
-static int
-auxNextPrevBlock(
-        int         incOrDec(int),
-        int         curent_cursor_pos,
-        const char *str)
-{
-    if(incOrDec(curent_cursor_pos) == 0){
-        return 0;
-    }
+        if(lineBufAt(lb, curent_cursor_pos + step) == '\0'){
+            return curent_cursor_pos;
+        }
 
-    if(str[incOrDec(curent_cursor_pos)] == '\0'){
-        return curent_cursor_pos;
-    }
+        if(lineBufAt(lb, curent_cursor_pos) != ' ' && (lineBufAt(lb, curent_cursor_pos-1) == ' ' || lineBufAt(lb, curent_cursor_pos+1) == ' ')){
+            return curent_cursor_pos;
+        }
 
-    if(str[curent_cursor_pos] != ' ' && (str[curent_cursor_pos-1] == ' ' || str[curent_cursor_pos+1] == ' ')){
-        return curent_cursor_pos;
+        curent_cursor_pos += step;
     }
-
-    return auxNextPrevBlock(incOrDec, incOrDec(curent_cursor_pos), str);
 }
 
 static int
 nextBlock(
-        int         curent_cursor_pos, 
-        const char *str)
+              int        curent_cursor_pos, 
+        const linebuf_t *lb)
 {
-    if(str == NULL || curent_cursor_pos == strlen(str)){
+    if(curent_cursor_pos == lineBufLen(lb)){
         return curent_cursor_pos;
     }
 
-    int inc(int n){
-        return n + 1;
-    }
-
-    if(str[curent_cursor_pos-1] == ' ' || str[curent_cursor_pos+1] == ' '){
+    if(lineBufAt(lb, curent_cursor_pos-1) == ' ' || lineBufAt(lb, curent_cursor_pos+1) == ' '){
         curent_cursor_pos++;
     }
 
-    return auxNextPrevBlock(inc, curent_cursor_pos, str);
+    return auxNextPrevBlock(1, curent_cursor_pos, lb);
 }
 
 static int
 prevBlock(
-        int curent_cursor_pos,
-        const char *str)
+              int        curent_cursor_pos,
+        const linebuf_t *lb)
 {
     if(curent_cursor_pos == 0){
         return 0;
     }
 
-    int dec(int n){
-        return n - 1;
-    }
-
-    if(str[curent_cursor_pos-1] == ' ' || str[curent_cursor_pos+1] == ' '){
+    if(lineBufAt(lb, curent_cursor_pos-1) == ' ' || lineBufAt(lb, curent_cursor_pos+1) == ' '){
         curent_cursor_pos--;
     }
 
-    return auxNextPrevBlock(dec, curent_cursor_pos, str);
-}
-
-static void clearLine(
-        const char *prompt,
-        const char *line)
-{
-    int line_len = line == NULL ? 0 : strlen(line);
-    printf("\r");
-    /* +1は直前の操作がbackspaceだった場合に, 1文字分lineからは消えているがコンソール上では消えていないため */
-    for(int i=0; i<strlen(prompt)+line_len+1; i++){
-        printf(" ");
-    }
-    printf("\r%s", prompt);
-    fflush(stdout);
+    return auxNextPrevBlock(-1, curent_cursor_pos, lb);
 }
 
-char *
-rwh(
+static char *
+rwhRaw(
         rwhctx_t    *ctx) 
 {
-    char *line           = NULL;
-    int   line_len       = 0;
-    char *tmp            = NULL;
-    int   tmp_len        = 0;
-    int   cursor_pos     = 0;
-    int   history_idx    = 0;
-    char *evacated_line  = NULL;
-    const char *prompt   = ctx -> prompt;
+    linebuf_t  *line          = ctx -> line;
+    int         state         = 0; /* ctx->keymapの木の状態 */
+    int         history_idx   = 0;
+    char       *evacated_line = NULL;
+    const char *prompt        = ctx -> prompt;
+    frame_t    *frame         = ctx -> frame;
 
     /* flags */
     bool before_is_dive = 0;
     bool dived          = 0;
     bool line_modified  = 1;
 
-    printf("%s", prompt);
-    fflush(stdout);
+    /* 編集中の行はgap bufferに持つので, カーソル位置での挿入と削除は行の長さによらない */
+    setLineBuf(line, NULL);
+
+    /* 端末には前回の描画との差分だけを送る. 1行に収まることを前提にする */
+    drawLine(frame, prompt, line);
+    flushFrame(frame);
 
     while(1){
-        char ch = getch();
+        int  key = getch();
+        char ch  = key;
+        if(key == EOF){
+            free(evacated_line);
+            appendFrame(frame, "\n", 1);
+            flushFrame(frame);
+            return NULL;
+        }
         switch(ch){
             case '\n':
-                if(line){
-                    push2Ringbuf(ctx->history, line);
+                {
+                    /* 確定した行だけをNUL終端された文字列にする. 履歴が所有するので呼び出し元は開放しない */
+                    char *entered = lineBufLen(line) == 0 ? NULL : dupLineBuf(line);
+                    if(entered){
+                        push2Ringbuf(ctx->history, entered);
+                    }
+                    free(evacated_line);
+                    drawMove(frame, line);
+                    appendFrame(frame, "\n", 1);
+                    flushFrame(frame);
+                    return entered == NULL ? "" : entered;
                 }
-                printf("\n");
-                return line == NULL ? "" : line;
 
             case 0x7f: /* backspace */
-                if(cursor_pos != 0){
-                    cursor_pos--;
-                    line_len--;
-                    strndelete(cursor_pos, &line);
+                state = 0;
+                if(line->gap_head != 0){
+                    deleteLineBuf(line, 1, 0);
+                    drawDelete(frame, 1, 0);
                     line_modified = 1;
                 }
                 break;
 
             default:
-                if(!(tmp = (char *)realloc(tmp, sizeof(char)*(tmp_len+1)))){
-                    return NULL;
-                }
-                sprintf(tmp, "%s%c", tmp_len == 0 ? "" : tmp, ch);
-                tmp_len++;
-                switch(judgeShortCut(ctx, tmp)){
-                    case JS_NOT_SHORT_CUT:
-                        strninsert(cursor_pos, &line, ch);
-                        cursor_pos++;
-                        line_len++;
-                        line_modified = 1;
-                        goto free_and_break;
-
-                    case JS_UNKNOWN_YET:
+                {
+                    /* キー1つにつき木を1段たどる. 途中まで一致した列が続かなければ, そのキーから改めてたどる */
+                    keymap_t *km   = ctx -> keymap;
+                    int       next = km -> next[state][(unsigned char)ch];
+                    if(next == 0 && state != 0){
+                        next = km -> next[0][(unsigned char)ch];
+                    }
+                    state = next;
+                    if(state != 0 && km->bind[state] == -1){
                         /* nothing to do */
                         break;
+                    }
+                    const keybind_t *kb     = state == 0 ? NULL : &(km -> binds[km->bind[state]]);
+                    rwh_action_t     action = kb ? kb->action : RWH_ACTION_INSERT;
+                    state = 0;
+
+                    switch(action){
+                        case RWH_ACTION_INSERT:
+                            {
+                                /* どれにも当たらないキーはそのキーだけを, 挿入に割り当てた列はその列を挿入する */
+                                const char *text     = kb ? kb->seq : &ch;
+                                int         text_len = kb ? strlen(kb->seq) : 1;
+                                if(insertLineBuf(line, text, text_len) != 0){
+                                    free(evacated_line);
+                                    return NULL;
+                                }
+                                drawInsert(frame, line, text_len);
+                                line_modified = 1;
+                            }
+                            break;
+
+                        case RWH_ACTION_HEAD:
+                            moveLineBuf(line, 0);
+                            drawMove(frame, line);
+                            break;
+
+                        case RWH_ACTION_TAIL:
+                            moveLineBuf(line, lineBufLen(line));
+                            drawMove(frame, line);
+                            break;
+
+                        case RWH_ACTION_NEXT_BLOCK:
+                            moveLineBuf(line, nextBlock(line->gap_head, line));
+                            drawMove(frame, line);
+                            break;
+
+                        case RWH_ACTION_PREV_BLOCK:
+                            moveLineBuf(line, prevBlock(line->gap_head, line));
+                            drawMove(frame, line);
+                            break;
+
+                        case RWH_ACTION_COMPLETION:
+                            {
+                                char *str = dupLineBuf(line);
+                                if(str){
+                                    /* 候補は次の行から表示されるので, 行は描き直す */
+                                    flushFrame(frame);
+                                    completion(str, ctx->candidate);
+                                    free(str);
+                                    drawLine(frame, prompt, line);
+                                }
+                            }
+                            break;
+
+                        case RWH_ACTION_DIVE_HIST:
+                            if(history_idx < ctx->history->entory_num){
+                                before_is_dive = 1;
+                                if(dived){
+                                    history_idx   += !before_is_dive;
+                                }
+                                if(line_modified){
+                                    /* 履歴から戻った時のために編集中の行を退避する */
+                                    free(evacated_line);
+                                    evacated_line  = dupLineBuf(line);
+                                    line_modified  = 0;
+                                }
+                                dived          = 1;
+                                setLineBuf(line, readRingBuf(ctx->history, history_idx++));
+                                drawLine(frame, prompt, line);
+                            }
+                            break;
 
-                    case JS_HEAD:
-                        cursor_pos = 0;
-                        goto free_and_break;
-
-                    case JS_TAIL:
-                        cursor_pos = line_len;
-                        goto free_and_break;
-
-                    case JS_NEXT_BLOCK:
-                        cursor_pos = nextBlock(cursor_pos, line);
-                        goto free_and_break;
-
-                    case JS_PREV_BLOCK:
-                        cursor_pos = prevBlock(cursor_pos, line);
-                        goto free_and_break;
-
-                    case JS_COMPLETION:
-                        completion(line, ctx->candidate);
-                        goto free_and_break;
-
-                    case JS_DIVE_HIST:
-                        if(history_idx < ctx->history->entory_num){
-                            before_is_dive = 1;
+                        case RWH_ACTION_FLOAT_HIST:
                             if(dived){
-                                history_idx   += !before_is_dive;
-                            }
-                            if(line_modified){
-                                evacated_line  = line;
-                                line_modified  = 0;
+                                history_idx   -= before_is_dive;
+                                before_is_dive = 0;
+                                if(history_idx == 0){
+                                    setLineBuf(line, evacated_line);
+                                }
+                                else{
+                                    setLineBuf(line, readRingBuf(ctx->history, --history_idx));
+                                }
+                                drawLine(frame, prompt, line);
                             }
-                            dived          = 1;
-                            clearLine(prompt, line);
-                            line           = readRingBuf(ctx->history, history_idx++);
-                            line_len       = strlen(line);
-                            cursor_pos     = line_len;
-                        }
-                        goto free_and_break;
-
-                    case JS_FLOAT_HIST:
-                        if(dived){
-                            history_idx   -= before_is_dive;
-                            before_is_dive = 0;
-                            clearLine(prompt, line);
-                            if(history_idx == 0){
-                                line = evacated_line;
+                            break;
+
+                        case RWH_ACTION_RIGHT:
+                            moveLineBuf(line, line->gap_head + 1);
+                            drawMove(frame, line);
+                            break;
+
+                        case RWH_ACTION_LEFT:
+                            moveLineBuf(line, line->gap_head - 1);
+                            drawMove(frame, line);
+                            break;
+
+                        case RWH_ACTION_DELETE:
+                            if(line->gap_head < lineBufLen(line)){
+                                deleteLineBuf(line, 0, 1);
+                                drawDelete(frame, 0, 1);
+                                line_modified = 1;
                             }
-                            else{
-                                line = readRingBuf(ctx->history, --history_idx);
+                            break;
+
+                        case RWH_ACTION_PASTE:
+                            {
+                                /* 貼り付けられた分はショートカットとして扱わず, まとめて挿入して1回だけ描く */
+                                int n = pasteKeys(line);
+                                if(n < 0){
+                                    free(evacated_line);
+                                    return NULL;
+                                }
+                                if(n > 0){
+                                    drawInsert(frame, line, n);
+                                    line_modified = 1;
+                                }
                             }
-                            line_len   = line == NULL ? 0 : strlen(line);
-                            cursor_pos = line_len;
-                        }
-                        goto free_and_break;
-
-                    case JS_RIGHT:
-                        cursor_pos = cursor_pos == line_len ? cursor_pos : cursor_pos+1;
-                        goto free_and_break;
-
-                    case JS_LEFT:
-                        cursor_pos = cursor_pos == 0 ? 0 : cursor_pos-1;
-                        goto free_and_break;
-
-                    case JS_DELETE:
-                        if(cursor_pos >= line_len){
-                            strndelete(cursor_pos, &line);
-                            line_len--;
-                            line_modified = 1;
-                        }
-                        goto free_and_break;
-
-                    default:
-                        BUG_REPORT();
-                        goto free_and_break;
-
-                    free_and_break:
-                        free(tmp);
-                        tmp = NULL;
-                        tmp_len = 0;
-                        break;
+                            break;
+
+                        default:
+                            BUG_REPORT();
+                            break;
+
+                    }
                 }
                 break;
         }
-        clearLine(prompt, line);
-        printf("%s", line == NULL ? "" : line);
-        for(int i=0; i<line_len-cursor_pos; i++){
-            printf("\b");
+        /* 先読みした入力が残っていれば, それを処理してからまとめて書き出す */
+        if(!keyPending() || frame->len >= FRAME_FLUSH_SIZE){
+            flushFrame(frame);
         }
-        fflush(stdout);
     }
 }
 
+char *
+rwh(
+        rwhctx_t    *ctx) 
+{
+    /* beginRawSession()の中で呼ばれた場合は端末の設定を変えない */
+    if(syncKeymap(ctx) != 0){
+        return NULL;
+    }
+    if(beginRawSession() != 0){
+        perror("tcsetattr()");
+        return NULL;
+    }
+    char *line = rwhRaw(ctx);
+    endRawSession();
+    return line;
+}
+
 void
 freeRwhCtx(rwhctx_t *ctx){
     for(int i=0; i<ctx->history->size; i++){
@@ -700,6 +1280,11 @@ freeRwhCtx(rwhctx_t *ctx){
     }
     free(ctx -> history -> buf);
     free(ctx -> history);
+    freeLineBuf(ctx -> line);
+    freeFrame(ctx -> frame);
+    freeKeymap(ctx -> keymap);
+    free(ctx -> candidate -> entories);
+    free(ctx -> candidate);
     free(ctx -> sc_head);
     free(ctx -> sc_tail);
     free(ctx -> sc_next_block);
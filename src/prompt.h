@@ -26,6 +26,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <signal.h>
 #include <termios.h>
 #include <unistd.h>
 #include <readline/readline.h>
@@ -54,6 +57,64 @@ typedef struct _ringbuf_t{
     int    entory_num;  /* number of entories */
 }ringbuf_t;
 
+/* structure for gap buffer holding the line being edited. this is used for rwh_ctx_t's member. there is no need for user to know.
+ * the characters before the cursor are buf[0, gap_head) and the ones after it are buf[gap_tail, size),
+ * so inserting and deleting at the cursor only moves gap_head or gap_tail. */
+typedef struct _linebuf_t{
+    char *buf;      /* characters and the gap. not NUL terminated */
+    int   size;     /* size of buf */
+    int   gap_head; /* index of the head of the gap. this is the cursor position */
+    int   gap_tail; /* index of the next of the tail of the gap */
+}linebuf_t;
+
+/* structure for the last frame drawn by rwh() and the buffer for the next one. this is used for rwh_ctx_t's member. there is no need for user to know.
+ * only the difference from the last frame is put into buf, and buf is written with one write(). */
+typedef struct _frame_t{
+    char *buf;      /* bytes of the next frame */
+    int   len;      /* number of bytes in buf */
+    int   size;     /* size of buf */
+    int   line_len; /* length of the line on the console */
+    int   cursor;   /* cursor position on the console, counted from the head of the line */
+}frame_t;
+
+/* actions which key sequences are bound to. */
+typedef enum{
+    RWH_ACTION_INSERT     = 0,  /* insert the key sequence into the line as it is */
+    RWH_ACTION_HEAD       = 1,  /* go to the head of the line */
+    RWH_ACTION_TAIL       = 2,  /* go to the tail of the line */
+    RWH_ACTION_NEXT_BLOCK = 3,  /* go to the next edge of the word of the line */
+    RWH_ACTION_PREV_BLOCK = 4,  /* go to the previous edge of the word of the line */
+    RWH_ACTION_COMPLETION = 5,  /* print the candidates of completion */
+    RWH_ACTION_DIVE_HIST  = 6,  /* fetch older history */
+    RWH_ACTION_FLOAT_HIST = 7,  /* fetch newer history */
+    RWH_ACTION_RIGHT      = 8,  /* move the cursor right */
+    RWH_ACTION_LEFT       = 9,  /* move the cursor left */
+    RWH_ACTION_DELETE     = 10, /* delete the character at the cursor */
+    RWH_ACTION_PASTE      = 11, /* the start of bracketed paste */
+}rwh_action_t;
+
+#define RWH_SC_NUM 7 /* number of sc_* fields of rwh_ctx_t */
+
+/* structure for a key sequence bound to an action. this is used for keymap_t's member. there is no need for user to know. */
+typedef struct _keybind_t{
+    char         *seq;    /* copy of the key sequence. NULL if nothing is bound */
+    rwh_action_t  action;
+}keybind_t;
+
+/* structure for key bindings compiled into a trie. this is used for rwh_ctx_t's member. there is no need for user to know.
+ * each input byte is one lookup of next[state][byte], and a state with a binding fires it at once. */
+typedef struct _keymap_t{
+    keybind_t  *binds;               /* the sc_* fields of rwh_ctx_t, the arrow and delete keys, the start of paste, then the ones added by bindRwhKey() */
+    int         bind_num;            /* number of binds */
+    int         bind_size;           /* size of binds */
+    const char *sc_seen[RWH_SC_NUM]; /* the sc_* fields when they were copied into binds. a different pointer or content means rebinding */
+    int       (*next)[256];          /* next state of each state and byte. 0 is the root, so it also means no transition */
+    int        *bind;                /* index of binds which ends at each state. -1 if none */
+    int         state_num;           /* number of states */
+    int         state_size;          /* size of next and bind */
+    bool        dirty;               /* binds must be compiled again */
+}keymap_t;
+
 /* structure for holding candidates at completion. */
 typedef struct _completion_t{
     char** entories;   /* entories are sorted in ascending order */
@@ -65,6 +126,9 @@ typedef struct _rwhctx_t{
     const char   *prompt;        /* prompt */
     ringbuf_t    *history;       /* history of lines enterd in the console */
     completion_t *candidate;     /* search target at completion */
+    linebuf_t    *line;          /* line being edited. this is reused by every rwh() */
+    frame_t      *frame;         /* what is on the console */
+    keymap_t     *keymap;        /* key bindings compiled from the following sc_* fields. changing them is noticed at the next rwh() */
     char         *sc_head;       /* shortcut for go to the head of the line */
     char         *sc_tail;       /* shortcut for go to the tail of the line */
     char         *sc_next_block; /* shortcut for go to the next edge of the word of the line */
@@ -74,6 +138,49 @@ typedef struct _rwhctx_t{
     char         *sc_float_hist; /* shortcut for fetch newer history */
 }rwhctx_t;
 
+extern linebuf_t* /* NULL if fails */
+genLineBuf( /* generate an empty linebuf_t */
+        int capacity); /* initial size of the buffer. it grows automatically */
+
+extern int /* 0: success, 1: out of memory */
+insertLineBuf( /* insert str at the cursor and move the cursor to the end of it. amortized O(len) */
+              linebuf_t *lb,   /* [mod] */
+        const char      *str,  /* [in] characters to insert. need not to be NUL terminated */
+              int        len); /* number of characters to insert */
+
+extern void
+deleteLineBuf( /* delete characters around the cursor in O(1). the numbers are clamped to the line */
+        linebuf_t *lb,     /* [mod] */
+        int        before, /* number of characters to delete before the cursor (backspace) */
+        int        after); /* number of characters to delete after the cursor (delete) */
+
+extern void
+moveLineBuf( /* move the cursor to pos. O(distance) */
+        linebuf_t *lb,   /* [mod] */
+        int        pos); /* new cursor position. it is clamped to the line */
+
+extern int /* 0: success, 1: out of memory */
+setLineBuf( /* replace the whole line with str and move the cursor to the end */
+              linebuf_t *lb,   /* [mod] */
+        const char      *str); /* [in] new line. NULL is the same as "" */
+
+extern int /* number of characters in the line */
+lineBufLen(
+        const linebuf_t *lb); /* [in] */
+
+extern int /* character at pos, or '\0' if pos is out of the line */
+lineBufAt(
+        const linebuf_t *lb,   /* [in] */
+              int        pos);
+
+extern char* /* NUL terminated copy of the line allocated by malloc. NULL if fails */
+dupLineBuf(
+        const linebuf_t *lb); /* [in] */
+
+extern void
+freeLineBuf(
+        linebuf_t *lb); /* [mod] to be freed */
+
 extern completion_t* /* NULL if fails */
 genCompletion( /* generate a completion_t */
         const char **strings,      /* [in] search target at completion */
@@ -86,8 +193,23 @@ genRwhCtx( /* generate a rwh_ctx_t pointer. */
         const char **candidates,     /* [in] search target at completion */ 
               int    candidate_num); /* number of candidates */
 
-extern char * /* enterd line */
-rwh( /* acquire the line entered in the console and keep history. */
+extern int /* 0: success, 1: out of memory or seq is empty */
+bindRwhKey( /* bind a key sequence to an action. it takes precedence over the sc_* fields and the earlier bindings */
+              rwhctx_t     *ctx,     /* [mod] */
+        const char         *seq,     /* [in] key sequence. it is copied */
+              rwh_action_t  action);
+
+extern int /* 0: success, 1: failed to change the terminal settings */
+beginRawSession( /* put the terminal into raw mode until endRawSession(). sessions nest, and rwh() inside a session does not touch the terminal settings.
+                  * SIGINT, SIGQUIT, SIGTERM, SIGHUP and SIGTSTP restore the terminal before their previous handling, and raw mode is resumed if it returns. */
+        void);
+
+extern void
+endRawSession( /* restore the terminal settings saved by the outermost beginRawSession() */
+        void);
+
+extern char * /* enterd line. NULL if the input ends or fails */
+rwh( /* acquire the line entered in the console and keep history. keys typed ahead after Enter are kept for the next rwh(). */
         rwhctx_t   *ctx);      /* [mod] an context generated by genRwhCtx(). ctx keeps shortcuts and history operation keys settings and history. after rwh(), the entories of history of ctx is updated. */
 
 extern void
@@ -0,0 +1,531 @@
+/* MIT License
+ *
+ * Copyright (c) 2018 Sho Sone
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. */
+
+/* usage: optgen <spec> <name>
+ *
+ * オプションの仕様ファイルを読み, 事前に埋めたopt_property_db_tとそれ専用のマッチャを定義するCのソースを標準出力に書き出す.
+ * 出力はoption.hをincludeした後にincludeすることを想定しており, groupingOpt(&<name>, argc, argv, &opt_grp_db) のように使える.
+ * contents_checkerに指定した関数とenum_namesに指定した配列はincludeより前に宣言しておく必要がある.
+ *
+ * 仕様ファイルは1行に1つのオプションを空白区切りで書く. #から行末まではコメント.
+ *     <short_form> <long_form> <content_num_min> <content_num_max> <contents_checker> [<value_type>]
+ * long_formが無い場合とcontents_checkerが無い場合は - と書く. 数は整数かINT_MAXのような識別子.
+ * value_typeは int64, uint64, double, bool, size, enum:<enum_names> のどれかで, 省略するか - と書くとコンテンツを解釈しない. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+
+#define SPEC_LINE_MAX  4096
+#define SPEC_FIELD_NUM 6 /* value_typeは省略できるので最後のフィールドは無くてもよい */
+
+/* 仕様ファイルの1行 */
+typedef struct _spec_prop_t{
+    char *short_form;
+    char *long_form;        /* 無ければNULL */
+    char *content_num_min;
+    char *content_num_max;
+    char *contents_checker; /* 無ければNULL */
+    char *value_type;       /* OPT_VALUE_で始まるopt_value_type_tの名前 */
+    char *enum_names;       /* value_typeがOPT_VALUE_ENUMの場合の配列の名前. 無ければNULL */
+}spec_prop_t;
+
+/* 仕様ファイルに書くvalue_typeとopt_value_type_tの対応 */
+static const char *const value_type_names[][2] = {
+    {"-",      "OPT_VALUE_NONE"},
+    {"int64",  "OPT_VALUE_INT64"},
+    {"uint64", "OPT_VALUE_UINT64"},
+    {"double", "OPT_VALUE_DOUBLE"},
+    {"bool",   "OPT_VALUE_BOOL"},
+    {"size",   "OPT_VALUE_SIZE"},
+};
+
+/* マッチャが引く名前. 同じ名前は先に書かれたオプションを優先する */
+typedef struct _spec_key_t{
+    const char *form;
+    int         len;
+    int         prop;
+}spec_key_t;
+
+static void
+die(
+        const char *spec_path,
+        int         line_no,
+        const char *msg)
+{
+    fprintf(stderr, "optgen: %s:%d: %s\n", spec_path, line_no, msg);
+    exit(1);
+}
+
+static bool
+isIdentifierOrNumber(
+        const char *str)
+{
+    if(*str == '-' || *str == '+'){
+        str++;
+    }
+    if(*str == '\0'){
+        return false;
+    }
+    for(; *str != '\0'; str++){
+        if(!isalnum((unsigned char)*str) && *str != '_'){
+            return false;
+        }
+    }
+    return true;
+}
+
+static char*
+dupString(
+        const char *str)
+{
+    char *dup = (char *)malloc(strlen(str)+1);
+    if(!dup){
+        fprintf(stderr, "optgen: out of memory\n");
+        exit(1);
+    }
+    strcpy(dup, str);
+    return dup;
+}
+
+static int /* 読んだオプションの数 */
+readSpec(
+        const char   *spec_path,
+        spec_prop_t **props) /* [out] 読んだオプションの配列 */
+{
+    FILE *fp = fopen(spec_path, "r");
+    char  line[SPEC_LINE_MAX];
+    int   prop_num = 0;
+    int   capacity = 0;
+    int   line_no  = 0;
+
+    if(!fp){
+        perror(spec_path);
+        exit(1);
+    }
+    *props = NULL;
+
+    while(fgets(line, sizeof(line), fp)){
+        char *field[SPEC_FIELD_NUM];
+        int   field_num = 0;
+
+        line_no++;
+        line[strcspn(line, "#\n")] = '\0';
+        for(char *tok = strtok(line, " \t\r"); tok; tok = strtok(NULL, " \t\r")){
+            if(field_num == SPEC_FIELD_NUM){
+                die(spec_path, line_no, "too many fields");
+            }
+            field[field_num++] = tok;
+        }
+        if(field_num == 0){
+            continue;
+        }
+        if(field_num < SPEC_FIELD_NUM - 1){
+            die(spec_path, line_no, "expected <short_form> <long_form> <content_num_min> <content_num_max> <contents_checker> [<value_type>]");
+        }
+        if(strcmp(field[0], "-") == 0){
+            die(spec_path, line_no, "short_form is required");
+        }
+        if(!isIdentifierOrNumber(field[2]) || !isIdentifierOrNumber(field[3])){
+            die(spec_path, line_no, "content_num_min and content_num_max must be integers or identifiers");
+        }
+        if(isdigit((unsigned char)field[2][0]) && isdigit((unsigned char)field[3][0]) && atol(field[3]) < atol(field[2])){
+            die(spec_path, line_no, "content_num_min is bigger than content_num_max");
+        }
+        if(strcmp(field[4], "-") != 0 && strcmp(field[4], "NULL") != 0 && !isIdentifierOrNumber(field[4])){
+            die(spec_path, line_no, "contents_checker must be an identifier");
+        }
+        const char *value_type = NULL;
+        const char *enum_names = NULL;
+        const char *type_field = field_num == SPEC_FIELD_NUM ? field[5] : "-";
+        if(strncmp(type_field, "enum:", 5) == 0){
+            value_type = "OPT_VALUE_ENUM";
+            enum_names = type_field + 5;
+            if(!isIdentifierOrNumber(enum_names) || !(isalpha((unsigned char)enum_names[0]) || enum_names[0] == '_')){
+                die(spec_path, line_no, "enum:<enum_names> must name an array");
+            }
+        }
+        for(size_t i=0; i<sizeof(value_type_names)/sizeof(value_type_names[0]) && !value_type; i++){
+            if(strcmp(type_field, value_type_names[i][0]) == 0){
+                value_type = value_type_names[i][1];
+            }
+        }
+        if(!value_type){
+            die(spec_path, line_no, "value_type must be one of int64, uint64, double, bool, size, enum:<enum_names>");
+        }
+
+        if(prop_num == capacity){
+            capacity = capacity ? capacity*2 : 16;
+            if(!(*props = (spec_prop_t *)realloc(*props, sizeof(spec_prop_t)*capacity))){
+                die(spec_path, line_no, "out of memory");
+            }
+        }
+        spec_prop_t *prop = &((*props)[prop_num++]);
+        prop -> short_form       = dupString(field[0]);
+        prop -> long_form        = strcmp(field[1], "-") == 0 ? NULL : dupString(field[1]);
+        prop -> content_num_min  = dupString(field[2]);
+        prop -> content_num_max  = dupString(field[3]);
+        prop -> contents_checker = strcmp(field[4], "-") == 0 || strcmp(field[4], "NULL") == 0 ? NULL : dupString(field[4]);
+        prop -> value_type       = dupString(value_type);
+        prop -> enum_names       = enum_names ? dupString(enum_names) : NULL;
+    }
+
+    fclose(fp);
+    if(prop_num == 0){
+        die(spec_path, line_no, "no options");
+    }
+    return prop_num;
+}
+
+/* ============================================== */
+
+static void
+printCString( /* strの先頭len文字をCの文字列リテラルとして書き出す */
+        const char *str,
+        int         len)
+{
+    putchar('"');
+    for(int i=0; i<len; i++){
+        unsigned char c = str[i];
+        if(c == '"' || c == '\\'){
+            printf("\\%c", c);
+        }
+        else if(isprint(c)){
+            putchar(c);
+        }
+        else{
+            printf("\\%03o", c);
+        }
+    }
+    putchar('"');
+}
+
+static void
+printCChar(
+        unsigned char c)
+{
+    if(c == '\'' || c == '\\'){
+        printf("'\\%c'", c);
+    }
+    else if(isprint(c)){
+        printf("'%c'", c);
+    }
+    else{
+        printf("'\\%03o'", c);
+    }
+}
+
+static void
+indent(
+        int depth)
+{
+    printf("%*s", depth*4, "");
+}
+
+static int
+compareKey(
+        const void *a,
+        const void *b)
+{
+    const spec_key_t *ka = (const spec_key_t *)a;
+    const spec_key_t *kb = (const spec_key_t *)b;
+
+    if(ka->len != kb->len){
+        return ka->len - kb->len;
+    }
+    return memcmp(ka->form, kb->form, ka->len);
+}
+
+static int
+compareKeyName( /* option.cのsortOptNamesと同じ辞書順(strcmpの順) */
+        const void *a,
+        const void *b)
+{
+    return strcmp(((const spec_key_t *)a)->form, ((const spec_key_t *)b)->form);
+}
+
+static void
+emitTrieNode( /* 長さが同じでpos文字目まで一致しているkeysを見分けるswitch文を書き出す. 書き出したコードは必ずreturnする */
+        const spec_key_t *keys,
+        int               key_num,
+        int               pos,
+        int               depth)
+{
+    int len = keys[0].len;
+
+    if(key_num == 1){
+        indent(depth);
+        if(pos == len){
+            printf("return %d;\n", keys[0].prop);
+        }
+        else{
+            printf("return memcmp(str+%d, ", pos);
+            printCString(keys[0].form + pos, len - pos);
+            printf(", %d) == 0 ? %d : -1;\n", len - pos, keys[0].prop);
+        }
+        return;
+    }
+
+    /* 全てのkeyに共通する部分は1回のmemcmpで確かめる. keysは重複しないので共通部分はlenより短い */
+    int common = 0;
+    while(pos + common < len){
+        char c = keys[0].form[pos + common];
+        int  i;
+        for(i=1; i<key_num && keys[i].form[pos + common] == c; i++){
+        }
+        if(i != key_num){
+            break;
+        }
+        common++;
+    }
+    if(common > 0){
+        indent(depth);
+        if(common == 1){
+            printf("if(str[%d] != ", pos);
+            printCChar(keys[0].form[pos]);
+            printf("){\n");
+        }
+        else{
+            printf("if(memcmp(str+%d, ", pos);
+            printCString(keys[0].form + pos, common);
+            printf(", %d) != 0){\n", common);
+        }
+        indent(depth+1);
+        printf("return -1;\n");
+        indent(depth);
+        printf("}\n");
+        pos += common;
+    }
+
+    /* keysはソート済みなのでpos文字目が同じものは連続している */
+    indent(depth);
+    printf("switch(str[%d]){\n", pos);
+    for(int head=0; head<key_num;){
+        int tail = head + 1;
+        while(tail < key_num && keys[tail].form[pos] == keys[head].form[pos]){
+            tail++;
+        }
+        indent(depth+1);
+        printf("case ");
+        printCChar(keys[head].form[pos]);
+        printf(":\n");
+        emitTrieNode(&keys[head], tail - head, pos+1, depth+2);
+        head = tail;
+    }
+    indent(depth);
+    printf("}\n");
+    indent(depth);
+    printf("return -1;\n");
+}
+
+static void
+emitMatcher(
+        const char       *name,
+        const spec_key_t *keys,
+        int               key_num)
+{
+    printf("static int\n%s_match_(\n        const char *str,\n        int         len)\n{\n", name);
+    printf("    switch(len){\n");
+    for(int head=0; head<key_num;){
+        int tail = head + 1;
+        while(tail < key_num && keys[tail].len == keys[head].len){
+            tail++;
+        }
+        printf("        case %d:\n", keys[head].len);
+        emitTrieNode(&keys[head], tail - head, 0, 3);
+        head = tail;
+    }
+    printf("    }\n    return -1;\n}\n\n");
+}
+
+static void
+emitNames( /* 補完に用いる名前の索引を辞書順に並べて書き出す. keysは重複を取り除いてあるのでそのままoption.cのensureOptNamesの結果になる */
+        const char       *name,
+        spec_key_t       *keys,
+        int               key_num)
+{
+    qsort(keys, key_num, sizeof(spec_key_t), compareKeyName);
+    printf("static opt_name_t %s_names_[%d] = {\n", name, key_num);
+    for(int k=0; k<key_num; k++){
+        printf("    {");
+        printCString(keys[k].form, keys[k].len);
+        printf(", %d},\n", keys[k].prop);
+    }
+    printf("};\n\n");
+}
+
+static unsigned int /* FNV-1a. option.cのhashOptNameと同じでなければならない */
+hashOptName(
+        const char *str,
+        int         len)
+{
+    unsigned int hash = 2166136261u;
+    for(int i=0; i<len; i++){
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void
+emitIdx( /* option.cのinsertOptIdxと同じ手順でハッシュ表を埋めて書き出す. short_idxで引く名前は含めない */
+        const char        *name,
+        const spec_prop_t *props,
+        int                prop_num,
+        int               *idx_size) /* [out] */
+{
+    int *idx;
+
+    *idx_size = 4;
+    while(*idx_size < prop_num*4){
+        *idx_size <<= 1;
+    }
+    if(!(idx = (int *)malloc(sizeof(int)*(*idx_size)))){
+        fprintf(stderr, "optgen: out of memory\n");
+        exit(1);
+    }
+    memset(idx, 0xff, sizeof(int)*(*idx_size));
+
+    for(int i=0; i<prop_num; i++){
+        const char *forms[2] = {props[i].short_form, props[i].long_form};
+        for(int f=0; f<2 && forms[f]; f++){
+            if(strlen(forms[f]) == 2 && forms[f][0] == '-'){
+                continue;
+            }
+            unsigned int mask = *idx_size - 1;
+            unsigned int slot = hashOptName(forms[f], strlen(forms[f])) & mask;
+            bool         dup  = false;
+            while(idx[slot] != -1 && !dup){
+                const spec_prop_t *prop = &props[idx[slot]];
+                dup  = strcmp(prop->short_form, forms[f]) == 0 || (prop->long_form && strcmp(prop->long_form, forms[f]) == 0);
+                slot = dup ? slot : (slot+1) & mask;
+            }
+            if(!dup){
+                idx[slot] = i;
+            }
+        }
+    }
+
+    printf("static int %s_idx_[%d] = {", name, *idx_size);
+    for(int i=0; i<*idx_size; i++){
+        printf(i % 16 ? " %d," : "\n    %d,", idx[i]);
+    }
+    printf("\n};\n\n");
+    free(idx);
+}
+
+int main(int argc, char *argv[]){
+    if(argc != 3 || !isIdentifierOrNumber(argv[2]) || isdigit((unsigned char)argv[2][0])){
+        fprintf(stderr, "usage: %s <spec> <name>\n", argv[0]);
+        return 1;
+    }
+
+    const char  *spec_path  = argv[1];
+    const char  *name       = argv[2];
+    spec_prop_t *props;
+    int          prop_num   = readSpec(spec_path, &props);
+    spec_key_t  *keys       = (spec_key_t *)malloc(sizeof(spec_key_t)*prop_num*2);
+    spec_key_t  *match_keys = (spec_key_t *)malloc(sizeof(spec_key_t)*prop_num*2);
+    int          key_num    = 0;
+    int          idx_size;
+
+    if(!keys || !match_keys){
+        fprintf(stderr, "optgen: out of memory\n");
+        return 1;
+    }
+
+    /* 同じ名前が複数のオプションに書かれていたらregOptPropと同様に先に書かれた方を優先する */
+    for(int i=0; i<prop_num; i++){
+        const char *forms[2] = {props[i].short_form, props[i].long_form};
+        for(int f=0; f<2 && forms[f]; f++){
+            bool dup = false;
+            for(int k=0; k<key_num && !dup; k++){
+                dup = strcmp(keys[k].form, forms[f]) == 0;
+            }
+            if(!dup){
+                keys[key_num++] = (spec_key_t){forms[f], strlen(forms[f]), i};
+            }
+        }
+    }
+    qsort(keys, key_num, sizeof(spec_key_t), compareKey);
+
+    printf("/* このファイルはoptgenが%sから生成した. 編集しないこと */\n\n", spec_path);
+
+    printf("static const opt_property_t %s_props_[%d] = {\n", name, prop_num);
+    for(int i=0; i<prop_num; i++){
+        printf("    {");
+        printCString(props[i].short_form, strlen(props[i].short_form));
+        printf(", ");
+        if(props[i].long_form){
+            printCString(props[i].long_form, strlen(props[i].long_form));
+        }
+        else{
+            printf("NULL");
+        }
+        printf(", %s, %s, %s, %s, %s},\n", props[i].contents_checker ? props[i].contents_checker : "NULL",
+                props[i].content_num_min, props[i].content_num_max,
+                props[i].value_type, props[i].enum_names ? props[i].enum_names : "NULL");
+    }
+    printf("};\n\n");
+
+    emitIdx(name, props, prop_num, &idx_size);
+    /* '-'と1文字からなる名前はlookupOptPropがshort_idxで引くのでマッチャには含めない.
+     * keysは長さ順なので, 該当する名前を取り除いても順序は保たれる */
+    int match_num = 0;
+    for(int k=0; k<key_num; k++){
+        if(keys[k].len != 2 || keys[k].form[0] != '-'){
+            match_keys[match_num++] = keys[k];
+        }
+    }
+    emitMatcher(name, match_keys, match_num);
+    /* 並べ替えるのでマッチャを書き出した後にする */
+    emitNames(name, keys, key_num);
+
+    printf("static opt_trie_node_t %s_trie_[OPT_PROP_TRIE_SIZE(%d)];\n\n", name, prop_num);
+    printf("static opt_property_db_t %s = {\n", name);
+    printf("    .prop_num  = %d,\n", prop_num);
+    printf("    .reg_num   = %d,\n", prop_num);
+    printf("    .props     = %s_props_,\n", name);
+    printf("    .idx_size  = %d,\n", idx_size);
+    printf("    .idx       = %s_idx_,\n", name);
+    printf("    .short_idx = {");
+    for(int k=0; k<key_num; k++){
+        if(keys[k].len == 2 && keys[k].form[0] == '-'){
+            printf("[");
+            printCChar(keys[k].form[1]);
+            printf("] = %d, ", keys[k].prop + 1);
+        }
+    }
+    printf("},\n");
+    printf("    .idx_state = OPT_IDX_BUILT,\n");
+    printf("    .matcher   = %s_match_,\n", name);
+    printf("    .trie_size = OPT_PROP_TRIE_SIZE(%d),\n", prop_num);
+    printf("    .trie      = %s_trie_,\n", name);
+    printf("    .name_num  = %d,\n", key_num);
+    printf("    .names     = %s_names_,\n", name);
+    printf("    .names_state = OPT_IDX_BUILT,\n");
+    printf("};\n");
+
+    return 0;
+}